@@ -11,16 +11,25 @@ uniform mediump vec4        u_color;
 uniform mediump sampler2D   u_tex;
 
 varying highp   vec2        v_tex_pos;
+#ifdef VERTEX_COLOR
+varying lowp    vec4        v_color;
+#endif
 
 #ifdef VERTEX_SHADER
 
 attribute highp     vec4    a_pos;
 attribute mediump   vec2    a_tex_pos;
+#ifdef VERTEX_COLOR
+attribute lowp      vec4    a_color;
+#endif
 
 void main()
 {
     gl_Position = a_pos;
     v_tex_pos = a_tex_pos;
+#ifdef VERTEX_COLOR
+    v_color = a_color;
+#endif
 }
 
 #endif
@@ -28,11 +37,15 @@ void main()
 
 void main()
 {
+    mediump vec4 color = u_color;
+#ifdef VERTEX_COLOR
+    color *= v_color;
+#endif
 #ifndef TEXTURE_LUMINANCE
-    gl_FragColor = texture2D(u_tex, v_tex_pos) * u_color;
+    gl_FragColor = texture2D(u_tex, v_tex_pos) * color;
 #else
     // Luminance mode: the texture only applies to the alpha channel.
-    gl_FragColor = u_color;
+    gl_FragColor = color;
     gl_FragColor.a *= texture2D(u_tex, v_tex_pos).r;
 #endif
 }
@@ -15,18 +15,75 @@ uniform   lowp    vec2 u_fbo_size;
 attribute highp   vec4 a_pos;
 
 
-// Mollweide projection implementation.
+// Projections implementations, so that the meshes vertices can stay in
+// their original frame.  They should give the same results as the
+// functions in src/projections.
 // Note: we should probably put this in a seperate file and support include.
-#ifdef PROJ_MOLLWEIDE
 
+#define PI 3.14159265
+#define SQRT2 1.4142135623730951
+
+uniform highp mat3 u_rot;          // Rotation from the mesh frame to view.
+uniform highp vec2 u_proj_flip;
 uniform highp vec2 u_proj_scaling;
 
-#define PI 3.14159265
+#ifdef PROJ_PERSPECTIVE
+
+uniform highp mat4 u_proj_mat;
+
+vec4 project(vec3 v)
+{
+    return u_proj_mat * vec4(v, 1.0);
+}
+
+#endif
+
+#ifdef PROJ_STEREOGRAPHIC
+
+vec4 project(vec3 v)
+{
+    // Let the GPU do the division, so that the clipping also works for
+    // the points close to the discontinuity.
+    return vec4(v.xy / u_proj_scaling, 0.0, 0.5 * (1.0 - v.z));
+}
+
+#endif
+
+#ifdef PROJ_MERCATOR
+
+vec4 project(vec3 v)
+{
+    highp float s = v.y;
+    highp vec2 p;
+    p.x = atan(v.x, -v.z);
+    if (abs(s) < 1.0)
+        p.y = 0.5 * log((1.0 + s) / (1.0 - s));
+    else
+        p.y = 1024.0 * sign(s); // Just use an arbitrary large value.
+    return vec4(p / u_proj_scaling, 0.0, 1.0);
+}
+
+#endif
+
+#ifdef PROJ_HAMMER
+
+vec4 project(vec3 v)
+{
+    highp float alpha = atan(v.x, -v.z);
+    highp float cos_delta = sqrt(1.0 - v.y * v.y);
+    highp float z = sqrt(1.0 + cos_delta * cos(alpha / 2.0));
+    return vec4(vec2(2.0 * SQRT2 * cos_delta * sin(alpha / 2.0),
+                     SQRT2 * v.y) / z / u_proj_scaling, 0.0, 1.0);
+}
+
+#endif
+
+#ifdef PROJ_MOLLWEIDE
+
 #define MAX_ITER 10
 #define PRECISION 1e-7
-#define SQRT2 1.4142135623730951
 
-vec2 project(vec3 v)
+vec4 project(vec3 v)
 {
     highp float phi, lambda, theta, d, k;
 
@@ -43,17 +100,55 @@ vec2 project(vec3 v)
         if (abs(d) < PRECISION) break;
     }
 
-    return vec2(2.0 * SQRT2 / PI * lambda * cos(theta),
-                SQRT2 * sin(theta)) / u_proj_scaling;
+    return vec4(vec2(2.0 * SQRT2 / PI * lambda * cos(theta),
+                     SQRT2 * sin(theta)) / u_proj_scaling, 0.0, 1.0);
 }
 
 #endif
 
+// Atmospheric refraction, same as in src/algos/refraction.c.  If set, the
+// u_rot matrix goes from the mesh frame to the observed frame.
+#ifdef REFRACTION
+
+uniform highp mat3 u_ro2v;          // Rotation from observed to view.
+uniform highp float u_refraction;   // Pressure and temperature factor.
+
+#define DD2R 0.017453292519943295
+#define MIN_GEO_ALTITUDE_DEG (-3.54)
+#define TRANSITION_WIDTH_GEO_DEG 1.46
+
+vec3 refraction(vec3 v)
+{
+    highp float alt, r;
+
+    if (v.z < sin((MIN_GEO_ALTITUDE_DEG - TRANSITION_WIDTH_GEO_DEG) * DD2R))
+        return v;
+    alt = asin(v.z) / DD2R;
+    if (alt > MIN_GEO_ALTITUDE_DEG) {
+        r = u_refraction / tan((alt + 10.3 / (alt + 5.11)) * DD2R) +
+            0.0019279;
+        alt = min(alt + r, 90.0);
+    } else {
+        // Avoids the jump below -5 by interpolating linearly.
+        r = u_refraction / tan((MIN_GEO_ALTITUDE_DEG + 10.3 /
+                (MIN_GEO_ALTITUDE_DEG + 5.11)) * DD2R) + 0.0019279;
+        alt += r * (alt - (MIN_GEO_ALTITUDE_DEG - TRANSITION_WIDTH_GEO_DEG)) /
+               TRANSITION_WIDTH_GEO_DEG;
+    }
+    return normalize(vec3(v.xy, sin(alt * DD2R)));
+}
+
+#endif
 
 void main()
 {
-#ifdef PROJ_MOLLWEIDE
-    gl_Position = vec4(project(a_pos.xyz), 0.0, 1.0);
+#ifdef PROJ
+    highp vec3 p = normalize(u_rot * a_pos.xyz);
+#ifdef REFRACTION
+    p = u_ro2v * refraction(p);
+#endif
+    gl_Position = project(p);
+    gl_Position.xy *= u_proj_flip;
 #else
     gl_Position = a_pos;
 #endif
@@ -16,6 +16,23 @@
 
 #include <assert.h>
 #include <math.h>
+#include <stdbool.h>
+
+/*
+ * The items are indexed in a uniform grid of CELL_SIZE pixels cells, so that
+ * the lookups only have to test the items close to the search position.
+ * The grid is not bounded: the cells are stored in a fixed size hash table
+ * of NB_BUCKETS buckets.  Each bucket is a linked list of items indices.
+ *
+ * Items larger than a cell are not put in the grid but in a separate list
+ * that is always fully tested.  This way we know that an item is never
+ * further than CELL_SIZE from its cell.  We do the same for the items
+ * very far away from the screen (more than GRID_MAX pixels), to prevent
+ * integer overflows.
+ */
+#define CELL_SIZE 32
+#define NB_BUCKETS 1024
+#define GRID_MAX 1e8
 
 typedef struct item item_t;
 
@@ -26,11 +43,19 @@ struct item
     double b; // Semi-minor axis.
     double angle;
     obj_t  *obj;
+    // Used instead of obj for the lazy items.
+    obj_t  *(*get_obj)(void *user, uint64_t id);
+    void   *user;
+    uint64_t id;
+    int    cell[2]; // Cell coordinates in the grid.
+    int    next;    // Index of the next item in the bucket, or -1.
 };
 
 struct areas
 {
     UT_array *items;
+    int buckets[NB_BUCKETS]; // Index of the first item of each bucket.
+    int large; // Index of the first item too large for the grid.
 };
 
 /*
@@ -57,15 +82,45 @@ static double ellipse_dist(const double center[2], double angle,
     return vec2_norm(p) - vec2_norm(p2);
 }
 
+static int get_cell(double x)
+{
+    return (int)floor(x / CELL_SIZE);
+}
+
+// Return the bucket of a cell.
+static int get_bucket(int x, int y)
+{
+    return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u) % NB_BUCKETS;
+}
+
 areas_t *areas_create(void)
 {
     static UT_icd item_icd = {sizeof(item_t), NULL, NULL, NULL};
     areas_t *areas;
     areas = calloc(1, sizeof(*areas));
     utarray_new(areas->items, &item_icd);
+    memset(areas->buckets, 0xff, sizeof(areas->buckets));
+    areas->large = -1;
     return areas;
 }
 
+static void add_item(areas_t *areas, item_t *item)
+{
+    int *head;
+    if (max(item->a, item->b) > CELL_SIZE ||
+            !(fabs(item->pos[0]) < GRID_MAX) ||
+            !(fabs(item->pos[1]) < GRID_MAX)) {
+        head = &areas->large;
+    } else {
+        item->cell[0] = get_cell(item->pos[0]);
+        item->cell[1] = get_cell(item->pos[1]);
+        head = &areas->buckets[get_bucket(item->cell[0], item->cell[1])];
+    }
+    item->next = *head;
+    *head = utarray_len(areas->items);
+    utarray_push_back(areas->items, item);
+}
+
 void areas_add_circle(areas_t *areas, const double pos[2], double r,
                       obj_t *obj)
 {
@@ -73,7 +128,7 @@ void areas_add_circle(areas_t *areas, const double pos[2], double r,
     memcpy(item.pos, pos, sizeof(item.pos));
     item.a = item.b = r;
     item.obj = obj_retain(obj);
-    utarray_push_back(areas->items, &item);
+    add_item(areas, &item);
 }
 
 void areas_add_ellipse(areas_t *areas, const double pos[2], double angle,
@@ -85,7 +140,37 @@ void areas_add_ellipse(areas_t *areas, const double pos[2], double angle,
     item.a = a;
     item.b = b;
     item.obj = obj_retain(obj);
-    utarray_push_back(areas->items, &item);
+    add_item(areas, &item);
+}
+
+void areas_add_circle_lazy(areas_t *areas, const double pos[2], double r,
+                           obj_t *(*get_obj)(void *user, uint64_t id),
+                           void *user, uint64_t id)
+{
+    areas_add_ellipse_lazy(areas, pos, 0, r, r, get_obj, user, id);
+}
+
+void areas_add_ellipse_lazy(areas_t *areas, const double pos[2],
+                            double angle, double a, double b,
+                            obj_t *(*get_obj)(void *user, uint64_t id),
+                            void *user, uint64_t id)
+{
+    item_t item = {};
+    memcpy(item.pos, pos, sizeof(item.pos));
+    item.angle = angle;
+    item.a = a;
+    item.b = b;
+    item.get_obj = get_obj;
+    item.user = user;
+    item.id = id;
+    add_item(areas, &item);
+}
+
+// Return a new reference to the object of an item.
+static obj_t *item_get_obj(const item_t *item)
+{
+    if (item->get_obj) return item->get_obj(item->user, item->id);
+    return obj_retain(item->obj);
 }
 
 void areas_clear_all(areas_t *areas)
@@ -95,6 +180,54 @@ void areas_clear_all(areas_t *areas)
         obj_release(item->obj);
     }
     utarray_clear(areas->items);
+    memset(areas->buckets, 0xff, sizeof(areas->buckets));
+    areas->large = -1;
+}
+
+/*
+ * Iterate all the items that can be inside a given rect, plus a margin.
+ * The callback returns false to stop the iteration.
+ */
+static void iter_rect(const areas_t *areas,
+                      const double min_[2], const double max_[2],
+                      double margin, void *user,
+                      bool (*f)(void *user, int idx, const item_t *item))
+{
+    const item_t *items = (const item_t*)utarray_front(areas->items);
+    int i, x, y, x0 = 0, x1 = -1, y0 = 0, y1 = -1;
+
+    // Items in the grid can be up to one cell away from their cell.
+    margin += CELL_SIZE;
+    if (fabs(min_[0]) < GRID_MAX && fabs(max_[0]) < GRID_MAX &&
+        fabs(min_[1]) < GRID_MAX && fabs(max_[1]) < GRID_MAX &&
+        margin < GRID_MAX)
+    {
+        x0 = get_cell(min_[0] - margin);
+        x1 = get_cell(max_[0] + margin);
+        y0 = get_cell(min_[1] - margin);
+        y1 = get_cell(max_[1] + margin);
+    }
+
+    // Large rect: faster to test all the items.
+    if (x1 < x0 || y1 < y0 ||
+            (double)(x1 - x0 + 1) * (y1 - y0 + 1) > NB_BUCKETS) {
+        for (i = 0; i < utarray_len(areas->items); i++)
+            if (!f(user, i, &items[i])) return;
+        return;
+    }
+
+    for (i = areas->large; i != -1; i = items[i].next)
+        if (!f(user, i, &items[i])) return;
+
+    for (y = y0; y <= y1; y++)
+    for (x = x0; x <= x1; x++) {
+        for (i = areas->buckets[get_bucket(x, y)]; i != -1;
+             i = items[i].next) {
+            // Skip items from other cells sharing the same bucket.
+            if (items[i].cell[0] != x || items[i].cell[1] != y) continue;
+            if (!f(user, i, &items[i])) return;
+        }
+    }
 }
 
 /*
@@ -126,18 +259,150 @@ static double lookup_score(const item_t *item, const double pos[static 2],
 
 }
 
+typedef struct {
+    const double *pos;
+    double max_dist;
+    double best_score;
+    int best; // Index of the best item, or -1.
+} lookup_t;
+
+static bool lookup_iter(void *user, int idx, const item_t *item)
+{
+    lookup_t *lookup = user;
+    double score;
+    score = lookup_score(item, lookup->pos, lookup->max_dist);
+    // In case of equality we keep the first added item.
+    if (score > lookup->best_score ||
+            (score == lookup->best_score && idx < lookup->best)) {
+        lookup->best_score = score;
+        lookup->best = idx;
+    }
+    return true;
+}
+
 obj_t *areas_lookup(const areas_t *areas, const double pos[2], double max_dist)
 {
-    item_t *item = NULL, *best = NULL;
-    double score, best_score = 0.0;
+    lookup_t lookup = {pos, max_dist, 0.0, -1};
+    const item_t *item;
 
-    while ( (item = (item_t*)utarray_next(areas->items, item)) ) {
-        score = lookup_score(item, pos, max_dist);
-        if (score > best_score) {
-            best_score = score;
-            best = item;
+    iter_rect(areas, pos, pos, max(max_dist, 0), &lookup, lookup_iter);
+    if (lookup.best == -1) return NULL;
+    item = (const item_t*)utarray_eltptr(areas->items, lookup.best);
+    return item_get_obj(item);
+}
+
+typedef struct {
+    const double *min;
+    const double *max;
+    void *user;
+    int (*callback)(void *user, obj_t *obj);
+    int nb;
+} query_t;
+
+static bool query_iter(void *user, int idx, const item_t *item)
+{
+    query_t *query = user;
+    obj_t *obj;
+    int r;
+
+    if (item->pos[0] < query->min[0] || item->pos[0] > query->max[0] ||
+        item->pos[1] < query->min[1] || item->pos[1] > query->max[1])
+        return true;
+    obj = item_get_obj(item);
+    if (!obj) return true;
+    query->nb++;
+    r = query->callback(query->user, obj);
+    obj_release(obj);
+    return r >= 0;
+}
+
+int areas_query_rect(const areas_t *areas,
+                     const double min[2], const double max[2],
+                     void *user, int (*callback)(void *user, obj_t *obj))
+{
+    query_t query = {min, max, user, callback};
+    iter_rect(areas, min, max, 0, &query, query_iter);
+    return query.nb;
+}
+
+/******** TESTS ***********************************************************/
+
+#if COMPILE_TESTS
+
+#include "tests.h"
+
+static int test_count(void *user, obj_t *obj)
+{
+    (*(int*)user)++;
+    return 0;
+}
+
+static obj_t *test_get_obj(void *user, uint64_t id)
+{
+    return obj_retain(&((obj_t*)user)[id]);
+}
+
+static void test_areas(void)
+{
+    // Compare the grid lookup with a linear search over random shapes.
+    static obj_t objs[2000];
+    areas_t *areas;
+    const item_t *item;
+    double pos[2], score, best_score, rmin[2], rmax[2];
+    int i, j, best, nb, count;
+    obj_t *obj;
+
+    areas = areas_create();
+    srand(0);
+    for (i = 0; i < ARRAY_SIZE(objs); i++) {
+        objs[i].ref = 1;
+        pos[0] = rand() % 2000 - 500;
+        pos[1] = rand() % 2000 - 500;
+        if (i % 3 == 1)
+            areas_add_circle(areas, pos, rand() % 10, &objs[i]);
+        else if (i % 3 == 2)
+            areas_add_circle_lazy(areas, pos, rand() % 10, test_get_obj,
+                                  objs, i);
+        else
+            areas_add_ellipse(areas, pos, rand() % 6, rand() % 100 + 1,
+                              rand() % 20 + 1, &objs[i]);
+    }
+
+    for (i = 0; i < 1000; i++) {
+        pos[0] = rand() % 1200;
+        pos[1] = rand() % 1200;
+        best = -1;
+        best_score = 0;
+        for (j = 0; j < utarray_len(areas->items); j++) {
+            item = (const item_t*)utarray_eltptr(areas->items, j);
+            score = lookup_score(item, pos, 10);
+            if (score > best_score) {
+                best_score = score;
+                best = j;
+            }
         }
+        obj = areas_lookup(areas, pos, 10);
+        assert(obj == (best == -1 ? NULL : &objs[best]));
+        obj_release(obj);
     }
-    if (!best) return NULL;
-    return obj_retain(best->obj);
+
+    rmin[0] = 100; rmin[1] = 200;
+    rmax[0] = 400; rmax[1] = 300;
+    nb = 0;
+    for (j = 0; j < utarray_len(areas->items); j++) {
+        item = (const item_t*)utarray_eltptr(areas->items, j);
+        if (item->pos[0] >= rmin[0] && item->pos[0] <= rmax[0] &&
+            item->pos[1] >= rmin[1] && item->pos[1] <= rmax[1]) nb++;
+    }
+    count = 0;
+    assert(areas_query_rect(areas, rmin, rmax, &count, test_count) == nb);
+    assert(count == nb && nb > 0);
+
+    areas_clear_all(areas);
+    assert(!areas_lookup(areas, pos, 10));
+    for (i = 0; i < ARRAY_SIZE(objs); i++) assert(objs[i].ref == 1);
 }
+
+TEST_REGISTER(NULL, test_areas, TEST_AUTO);
+
+#endif
@@ -41,6 +41,36 @@ void areas_add_ellipse(areas_t *areas, const double pos[2], double angle,
                        double a, double b,
                        obj_t *obj);
 
+/*
+ * Function: areas_add_circle_lazy
+ * Add a circle shape whose object is only created when needed.
+ *
+ * This is the same as <areas_add_circle>, but instead of an object we
+ * pass a function that returns a new reference to it, so that the
+ * modules rendering many points don't have to create all the objects.
+ *
+ * Parameters:
+ *   areas   - an areas instance.
+ *   pos     - a 2d position in window space.
+ *   r       - radius in window space.
+ *   get_obj - function returning a new reference to the object of the
+ *             area (or NULL), called with user and id.
+ *   user    - data passed to get_obj.
+ *   id      - id passed to get_obj.
+ */
+void areas_add_circle_lazy(areas_t *areas, const double pos[2], double r,
+                           obj_t *(*get_obj)(void *user, uint64_t id),
+                           void *user, uint64_t id);
+
+/*
+ * Function: areas_add_ellipse_lazy
+ * Same as <areas_add_circle_lazy>, for an ellipse shape.
+ */
+void areas_add_ellipse_lazy(areas_t *areas, const double pos[2],
+                            double angle, double a, double b,
+                            obj_t *(*get_obj)(void *user, uint64_t id),
+                            void *user, uint64_t id);
+
 /*
  * Function: areas_lookup
  * Return the closest shape at a given position in an areas.
@@ -56,6 +86,29 @@ void areas_add_ellipse(areas_t *areas, const double pos[2], double angle,
  */
 obj_t *areas_lookup(const areas_t *areas, const double pos[2], double max_dist);
 
+/*
+ * Function: areas_query_rect
+ * Iterate all the shapes whose center is inside a rectangle.
+ *
+ * This can be used for box selection.
+ *
+ * Parameters:
+ *   areas      - an areas instance.
+ *   min        - top left corner of the rectangle in screen space.
+ *   max        - bottom right corner of the rectangle in screen space.
+ *   user       - data passed to the callback.
+ *   callback   - function called for each shape object.  If it returns
+ *                a negative value, the iteration stops.  The object is not
+ *                retained, so the callback needs to call obj_retain if it
+ *                keeps a reference to it.
+ *
+ * Return:
+ *   The number of objects passed to the callback.
+ */
+int areas_query_rect(const areas_t *areas,
+                     const double min[2], const double max[2],
+                     void *user, int (*callback)(void *user, obj_t *obj));
+
 /*
  * Function: areas_clear_all
  * Remove all the shapes in an areas instance.
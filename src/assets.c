@@ -11,6 +11,10 @@
 #include <sys/stat.h>
 
 static const int DEFAULT_DELAY = 60;
+// Max number of delayed assets network requests running at the same time.
+static const int MAX_SCHEDULED_REQUESTS = 8;
+// Number of dispatch calls after which we cancel an unused delayed asset.
+static const int MAX_UNUSED = 30;
 
 #ifdef __EMSCRIPTEN__
 static const bool HAS_FS = false;
@@ -26,6 +30,8 @@ enum {
     FREE_DATA   = 1 << 10,
     LOGGED      = 1 << 11,
     CAN_RELEASE = 1 << 12,
+    SCHEDULED   = 1 << 13,
+    MAPPED      = 1 << 14, // Data mapped with map_file.
 };
 
 typedef struct asset asset_t;
@@ -41,11 +47,17 @@ struct asset
     int             size;
     int             last_used;
     int             delay;
+    double          priority;
+    int             unused; // Number of dispatch since the last request.
+    asset_t         *sched_next, *sched_prev; // Scheduled list.
 };
 
 // Global map of all the assets.
 static asset_t *g_assets = NULL;
 
+// List of the delayed assets waiting for, or running a network request.
+static asset_t *g_scheduled = NULL;
+
 // Global hook function.
 static struct {
     void *user;
@@ -182,8 +194,9 @@ const void *asset_get_data2(const char *url, int flags, int *size, int *code)
             *code = 404;
             goto end;
         }
-        asset->data = read_file(path, &asset->size);
-        asset->flags |= FREE_DATA;
+        asset->data = map_file(path, &asset->size);
+        asset->flags |= asset->data ? MAPPED : FREE_DATA;
+        if (!asset->data) asset->data = read_file(path, &asset->size);
     }
 
     if (asset->data) {
@@ -192,14 +205,21 @@ const void *asset_get_data2(const char *url, int flags, int *size, int *code)
         return asset->data;
     }
 
-    if (!asset->request) {
-        if (asset->delay) {
-            asset->delay--;
+    // Delayed assets requests are started by assets_dispatch.
+    if (asset->flags & ASSET_DELAY) {
+        asset->unused = 0;
+        if (!(asset->flags & SCHEDULED)) {
+            DL_APPEND2(g_scheduled, asset, sched_prev, sched_next);
+            asset->flags |= SCHEDULED;
+        }
+        if (!asset->request) {
             assert(*code == 0 && *size == 0);
             return NULL;
         }
-        asset->request = request_create(asset->url);
     }
+
+    if (!asset->request)
+        asset->request = request_create(asset->url);
     data = request_get_data(asset->request, size, code);
     if (*code && data && (flags & ASSET_USED_ONCE))
         asset->flags |= CAN_RELEASE;
@@ -214,11 +234,20 @@ end:
 
 static int asset_release_(asset_t *asset)
 {
+    if (asset->flags & SCHEDULED) {
+        DL_DELETE2(g_scheduled, asset, sched_prev, sched_next);
+        asset->flags &= ~SCHEDULED;
+    }
     if (asset->flags & FREE_DATA) {
         free(asset->data);
         asset->data = NULL;
         asset->size = 0;
     }
+    if (asset->flags & MAPPED) {
+        unmap_file(asset->data, asset->size);
+        asset->data = NULL;
+        asset->size = 0;
+    }
     if (asset->request)
         request_delete(asset->request);
     if (!(asset->flags & STATIC)) {
@@ -263,6 +292,48 @@ void asset_release(const char *url)
     asset_release_(asset);
 }
 
+void asset_set_priority(const char *url, double priority)
+{
+    asset_t *asset;
+    HASH_FIND_STR(g_assets, url, asset);
+    if (asset) asset->priority = priority;
+}
+
+static int priority_cmp(void *a, void *b)
+{
+    return cmp(((asset_t*)b)->priority, ((asset_t*)a)->priority);
+}
+
+void assets_dispatch(void)
+{
+    asset_t *asset, *tmp;
+    int nb = 0;
+
+    DL_FOREACH_SAFE2(g_scheduled, asset, tmp, sched_next) {
+        if (asset->request && request_is_finished(asset->request)) {
+            DL_DELETE2(g_scheduled, asset, sched_prev, sched_next);
+            asset->flags &= ~SCHEDULED;
+            continue;
+        }
+        // Nobody asked for the asset for a while: cancel it.
+        if (asset->unused++ > MAX_UNUSED) {
+            asset_release_(asset);
+            continue;
+        }
+        if (asset->request) nb++;
+        else if (asset->delay && asset->unused == 1) asset->delay--;
+    }
+
+    DL_SORT2(g_scheduled, priority_cmp, sched_prev, sched_next);
+    DL_FOREACH2(g_scheduled, asset, sched_next) {
+        if (nb >= MAX_SCHEDULED_REQUESTS) break;
+        if (asset->request || asset->delay || asset->unused > 1) continue;
+        asset->request = request_create(asset->url);
+        request_get_data(asset->request, NULL, NULL); // Start the request.
+        nb++;
+    }
+}
+
 /*
  * Function: asset_set_hook
  * Set a global function to handle special urls.
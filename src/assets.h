@@ -30,9 +30,10 @@
  * Flags that can be passed to asset_get to optimize the network requests.
  *
  * Values:
- *   ASSET_DELAY        - Delay the network request for a few seconds.  This
- *                        is useful to prevent loading tiles resources too
- *                        quickly.
+ *   ASSET_DELAY        - Let <assets_dispatch> start the network request,
+ *                        after the asset has been requested for about one
+ *                        second.  This is useful to prevent loading tiles
+ *                        resources too quickly.
  *   ASSET_ACCEPT_404   - Do not log error on a 404 return.
  *   ASSET_USED_ONCE    - Hint that the data can be release after it has
  *                        been read.
@@ -85,6 +86,26 @@ const void *asset_get_data2(const char *url, int flags, int *size, int *code);
  */
 void asset_release(const char *url);
 
+/*
+ * Function: asset_set_priority
+ * Set the priority of a delayed asset network request.
+ *
+ * The assets with the highest priority get their requests started first
+ * by <assets_dispatch>.
+ */
+void asset_set_priority(const char *url, double priority);
+
+/*
+ * Function: assets_dispatch
+ * Start or cancel the network requests of the delayed assets.
+ *
+ * Should be called once per frame.  The delayed assets that have not been
+ * requested since the previous call are released, and the others get their
+ * network request started in order of priority, with a limited number of
+ * concurrent requests.
+ */
+void assets_dispatch(void);
+
 /*
  * Macro: ASSET_ITER
  * Iter all the asset url that start with a given prefix.
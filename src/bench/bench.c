@@ -0,0 +1,421 @@
+/* Stellarium Web Engine - Copyright (c) 2018 - Noctua Software Ltd
+ *
+ * This program is licensed under the terms of the GNU AGPL v3, or
+ * alternatively under a commercial licence.
+ *
+ * The terms of the AGPL v3 license can be found in the main directory of this
+ * repository.
+ */
+
+/*
+ * Native headless benchmark of the rendering loop.
+ *
+ * Build with 'make bench', or run it manually from the repository root:
+ *
+ *   ./build/bench [-d data/skydata] [-n frames] [path...]
+ *
+ * The bench loads the local skydata, then replays scripted camera paths
+ * (see PATHS) using a renderer that only counts the items it receives.
+ * The constellation lines and labels, and the azimuthal and equatorial
+ * grids are enabled.  For each path it reports the frame times percentiles,
+ * the time spent in each module render function, the number of rendered
+ * items, the hips tiles cache, healpix clipping and lines tesselation
+ * statistics.
+ */
+
+#include "swe.h"
+
+#include <time.h>
+
+#define MAX_MODULES 64
+// Fixed date so that the results can be compared (2020-01-01).
+#define START_UTC 58849.0
+
+static struct {
+    int points;     // Number of points.
+    int points_calls;
+    int lines;      // Number of line vertices.
+    int lines_calls;
+    int texts;
+    int quads;
+    int meshes;
+    int textures;
+    int shapes_2d;  // Ellipses, rects and 2d lines.
+    int models;
+} g_counts;
+
+// Render time of each module, see timed_render.
+static struct {
+    obj_t       *module;
+    obj_klass_t *klass; // Original klass of the module.
+    obj_klass_t timed_klass;
+    double      time;
+} g_modules[MAX_MODULES];
+static int g_nb_modules;
+
+static double get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/******** Counting renderer **********************************************/
+
+static void rend_points_2d(renderer_t *rend, const painter_t *painter,
+                           int n, const point_t *points)
+{
+    g_counts.points += n;
+    g_counts.points_calls++;
+}
+
+static void rend_quad(renderer_t *rend, const painter_t *painter,
+                      int frame, int grid_size, const uv_map_t *map)
+{
+    g_counts.quads++;
+}
+
+static void rend_texture(renderer_t *rend, const texture_t *tex,
+                         double uv[4][2], const double pos[2], double size,
+                         const double color[4], double angle)
+{
+    g_counts.textures++;
+}
+
+static void rend_text(renderer_t *rend, const char *text,
+                      const double pos[2], int align, int effects,
+                      double size, const double color[4], double angle,
+                      double bounds[4])
+{
+    // When bounds is set we are only asked for the text size, use a
+    // rough estimation.
+    if (bounds) {
+        bounds[0] = pos[0];
+        bounds[1] = pos[1];
+        bounds[2] = pos[0] + strlen(text) * size * 0.6;
+        bounds[3] = pos[1] + size;
+        return;
+    }
+    g_counts.texts++;
+}
+
+static void rend_line(renderer_t *rend, const painter_t *painter,
+                      const double (*line)[3], int size)
+{
+    g_counts.lines += size;
+    g_counts.lines_calls++;
+}
+
+static void rend_mesh(renderer_t *rend, const painter_t *painter,
+                      int frame, int mode, int verts_count,
+                      const double verts[][3], int indices_count,
+                      const uint16_t indices[], bool use_stencil)
+{
+    g_counts.meshes++;
+}
+
+static void rend_ellipse_2d(renderer_t *rend, const painter_t *painter,
+                            const double pos[2], const double size[2],
+                            double angle, double nb_dashes)
+{
+    g_counts.shapes_2d++;
+}
+
+static void rend_rect_2d(renderer_t *rend, const painter_t *painter,
+                         const double pos[2], const double size[2],
+                         double angle)
+{
+    g_counts.shapes_2d++;
+}
+
+static void rend_line_2d(renderer_t *rend, const painter_t *painter,
+                         const double p1[2], const double p2[2])
+{
+    g_counts.shapes_2d++;
+}
+
+static void rend_model_3d(renderer_t *rend, const painter_t *painter,
+                          const char *model, const double model_mat[4][4],
+                          const double view_mat[4][4],
+                          const double proj_mat[4][4],
+                          const double light_dir[3], json_value *args)
+{
+    g_counts.models++;
+}
+
+static renderer_t g_rend = {
+    .points_2d      = rend_points_2d,
+    .quad           = rend_quad,
+    .texture        = rend_texture,
+    .text           = rend_text,
+    .line           = rend_line,
+    .mesh           = rend_mesh,
+    .ellipse_2d     = rend_ellipse_2d,
+    .rect_2d        = rend_rect_2d,
+    .line_2d        = rend_line_2d,
+    .model_3d       = rend_model_3d,
+};
+
+/*
+ * We don't create any GL context, but the textures code still needs valid
+ * ids, so we replace the libGL function.
+ */
+void glGenTextures(int n, unsigned int *textures)
+{
+    static unsigned int id = 0;
+    while (n--) *textures++ = ++id;
+}
+
+/******** Modules timing *************************************************/
+
+static int timed_render(const obj_t *obj, const painter_t *painter)
+{
+    int i, ret;
+    double t;
+    for (i = 0; i < g_nb_modules; i++) {
+        if (g_modules[i].module == obj) break;
+    }
+    assert(i < g_nb_modules);
+    t = get_time();
+    ret = g_modules[i].klass->render(obj, painter);
+    g_modules[i].time += get_time() - t;
+    return ret;
+}
+
+// Replace the klass of all the modules with a copy that times the render
+// function.
+static void setup_modules_timing(void)
+{
+    obj_t *module;
+    DL_FOREACH(core->obj.children, module) {
+        if (!module->klass->render) continue;
+        if (g_nb_modules >= MAX_MODULES) break;
+        g_modules[g_nb_modules].module = module;
+        g_modules[g_nb_modules].klass = module->klass;
+        g_modules[g_nb_modules].timed_klass = *module->klass;
+        g_modules[g_nb_modules].timed_klass.render = timed_render;
+        module->klass = &g_modules[g_nb_modules].timed_klass;
+        g_nb_modules++;
+    }
+}
+
+/******** Camera paths ***************************************************/
+
+typedef struct {
+    const char *name;
+    // Set the observer and fov for a given frame, with t in [0, 1].
+    void (*update)(double t);
+} path_t;
+
+static void path_pan(double t)
+{
+    core->observer->yaw = t * 2 * M_PI;
+    core->observer->pitch = 20 * DD2R;
+    core->fov = 60 * DD2R;
+}
+
+static void path_zoom(double t)
+{
+    // Zoom from 120° to 0.5° and back, looking to the south.
+    double f = 1.0 - fabs(2.0 * t - 1.0);
+    core->observer->yaw = M_PI;
+    core->observer->pitch = 40 * DD2R;
+    core->fov = exp(log(120 * DD2R) * (1 - f) + log(0.5 * DD2R) * f);
+}
+
+static void path_timelapse(double t)
+{
+    // One full day, looking at the east horizon.
+    core->observer->yaw = M_PI / 2;
+    core->observer->pitch = 10 * DD2R;
+    core->fov = 90 * DD2R;
+    obj_set_attr(&core->observer->obj, "utc", START_UTC + t);
+}
+
+static const path_t PATHS[] = {
+    {"pan",         path_pan},
+    {"zoom",        path_zoom},
+    {"timelapse",   path_timelapse},
+};
+
+static int double_cmp(const void *a, const void *b)
+{
+    return cmp(*(const double*)a, *(const double*)b);
+}
+
+// Sort modules indices by decreasing render time.
+static int module_time_cmp(const void *a, const void *b)
+{
+    return cmp(g_modules[*(const int*)b].time, g_modules[*(const int*)a].time);
+}
+
+static void run_path(const path_t *path, int nb_frames)
+{
+    const double dt = 1.0 / 60;
+    const double w = 1280, h = 720;
+    double *times, t, total = 0;
+    int i, order[MAX_MODULES];
+    uint64_t nb_clip_tests, nb_clip_saved, nb_clip_tests0, nb_clip_saved0;
+    uint64_t nb_lines, nb_line_points, nb_line_evals;
+    uint64_t nb_lines0, nb_line_points0, nb_line_evals0;
+    cache_stats_t stats;
+
+    times = calloc(nb_frames, sizeof(*times));
+    memset(&g_counts, 0, sizeof(g_counts));
+    for (i = 0; i < g_nb_modules; i++) g_modules[i].time = 0;
+    painter_get_clip_cache_stats(&nb_clip_tests0, &nb_clip_saved0);
+    painter_get_lines_stats(&nb_lines0, &nb_line_points0, &nb_line_evals0);
+
+    for (i = 0; i < nb_frames; i++) {
+        path->update((double)i / max(nb_frames - 1, 1));
+        t = get_time();
+        core_update(dt);
+        core_render(w, h, 1.0);
+        times[i] = get_time() - t;
+        total += times[i];
+    }
+    obj_set_attr(&core->observer->obj, "utc", START_UTC);
+
+    qsort(times, nb_frames, sizeof(*times), double_cmp);
+    printf("\n== %s: %d frames, %.1f ms/frame ==\n", path->name, nb_frames,
+           total / nb_frames * 1000);
+    printf("frame time (ms): p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n",
+           times[nb_frames * 50 / 100] * 1000,
+           times[nb_frames * 90 / 100] * 1000,
+           times[nb_frames * 99 / 100] * 1000,
+           times[nb_frames - 1] * 1000);
+    printf("items per frame: points %d (%d calls), lines %d (%d calls), "
+           "texts %d, quads %d, meshes %d, textures %d, 2d shapes %d, "
+           "models %d\n",
+           g_counts.points / nb_frames, g_counts.points_calls / nb_frames,
+           g_counts.lines / nb_frames, g_counts.lines_calls / nb_frames,
+           g_counts.texts / nb_frames, g_counts.quads / nb_frames,
+           g_counts.meshes / nb_frames, g_counts.textures / nb_frames,
+           g_counts.shapes_2d / nb_frames, g_counts.models / nb_frames);
+
+    hips_get_cache_stats(&stats);
+    printf("hips tiles: %d cached (%d pinned), size %d, hits %llu, "
+           "misses %llu, evictions %llu\n",
+           stats.nb, stats.nb_pinned, stats.size,
+           (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+           (unsigned long long)stats.evictions);
+    painter_get_clip_cache_stats(&nb_clip_tests, &nb_clip_saved);
+    printf("healpix clip tests per frame: %d, %d saved\n",
+           (int)((nb_clip_tests - nb_clip_tests0) / nb_frames),
+           (int)((nb_clip_saved - nb_clip_saved0) / nb_frames));
+    painter_get_lines_stats(&nb_lines, &nb_line_points, &nb_line_evals);
+    nb_lines -= nb_lines0;
+    printf("tesselated lines per frame: %d, %.1f points and %.1f samples "
+           "per line\n", (int)(nb_lines / nb_frames),
+           (double)(nb_line_points - nb_line_points0) / max(nb_lines, 1),
+           (double)(nb_line_evals - nb_line_evals0) / max(nb_lines, 1));
+
+    // Note: we can't sort g_modules directly since the modules point to
+    // the klass copies it contains.
+    for (i = 0; i < g_nb_modules; i++) order[i] = i;
+    qsort(order, g_nb_modules, sizeof(*order), module_time_cmp);
+    printf("modules render time (ms/frame):\n");
+    for (i = 0; i < g_nb_modules; i++) {
+        if (g_modules[order[i]].time == 0) continue;
+        printf("  %-20s %8.3f\n", g_modules[order[i]].module->id,
+               g_modules[order[i]].time / nb_frames * 1000);
+    }
+    free(times);
+}
+
+static void add_data_sources(const char *dir)
+{
+    int i;
+    char url[1024];
+    const struct {
+        const char *module;
+        const char *path;
+        const char *key;
+    } SOURCES[] = {
+        {"stars",           "stars"},
+        {"skycultures",     "skycultures/western",      "western"},
+        {"dsos",            "dso"},
+        {"landscapes",      "landscapes/guereins",      "guereins"},
+        {"milkyway",        "surveys/milkyway"},
+        {"minor_planets",   "mpcorb.dat",               "mpc_asteroids"},
+        {"planets",         "surveys/sso/moon",         "moon"},
+        {"planets",         "surveys/sso/sun",          "sun"},
+        {"planets",         "surveys/sso/moon",         "default"},
+        {"comets",          "CometEls.txt",             "mpc_comets"},
+        {"satellites",      "tle_satellite.jsonl.gz",   "jsonl/sat"},
+    };
+
+    for (i = 0; i < ARRAY_SIZE(SOURCES); i++) {
+        snprintf(url, sizeof(url), "%s/%s", dir, SOURCES[i].path);
+        module_add_data_source(core_get_module(SOURCES[i].module), url,
+                               SOURCES[i].key);
+    }
+}
+
+// Enable the overlays that are off by default, so that the lines and
+// labels code paths are also measured.
+static void show_overlays(void)
+{
+    int i;
+    const struct {
+        const char *module;
+        const char *attr;
+    } ATTRS[] = {
+        {"constellations",      "lines_visible"},
+        {"constellations",      "labels_visible"},
+        {"lines.azimuthal",     "visible"},
+        {"lines.equatorial",    "visible"},
+    };
+
+    for (i = 0; i < ARRAY_SIZE(ATTRS); i++) {
+        obj_set_attr(core_get_module(ATTRS[i].module), ATTRS[i].attr, true);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *data_dir = "data/skydata";
+    int i, j, nb_frames = 600, warmup = 300, nb_paths = 0;
+    const path_t *paths[ARRAY_SIZE(PATHS)];
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            data_dir = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            nb_frames = max(atoi(argv[++i]), 1);
+            continue;
+        }
+        for (j = 0; j < ARRAY_SIZE(PATHS); j++) {
+            if (strcmp(argv[i], PATHS[j].name) == 0) break;
+        }
+        if (j == ARRAY_SIZE(PATHS) || nb_paths == ARRAY_SIZE(paths)) {
+            fprintf(stderr, "usage: %s [-d data_dir] [-n frames] "
+                    "[pan] [zoom] [timelapse]\n", argv[0]);
+            return -1;
+        }
+        paths[nb_paths++] = &PATHS[j];
+    }
+    if (!nb_paths) {
+        for (i = 0; i < ARRAY_SIZE(PATHS); i++) paths[nb_paths++] = &PATHS[i];
+    }
+
+    core_init(1280, 720, 1.0);
+    core->rend = &g_rend;
+    add_data_sources(data_dir);
+    show_overlays();
+    obj_set_attr(&core->observer->obj, "utc", START_UTC);
+
+    // Let all the data sources load before we start measuring.
+    for (i = 0; i < warmup; i++) {
+        path_pan((double)i / warmup);
+        core_update(1.0 / 60);
+        core_render(1280, 720, 1.0);
+    }
+    setup_modules_timing();
+
+    for (i = 0; i < nb_paths; i++)
+        run_path(paths[i], nb_frames);
+    return 0;
+}
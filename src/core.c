@@ -15,6 +15,20 @@ core_t *core;   // The global core object.
 #define CORE_MIN_FOV (1./3600 * DD2R)
 #define exp10(x) exp((x) * log(10.f))
 
+// Size and min magnitude of the points radius and luminance table.
+#define POINT_LUT_SIZE 1024
+#define POINT_LUT_MIN_MAG -5.0
+
+// Table of the points radius and luminance, only valid during a render.
+// See <core_get_point_for_mag>.
+static struct {
+    bool    valid;
+    double  step;
+    double  r_raw[POINT_LUT_SIZE];
+    double  radius[POINT_LUT_SIZE];
+    double  luminance[POINT_LUT_SIZE];
+} g_point_lut = {};
+
 static void core_on_fov_changed(obj_t *obj, const attribute_t *attr)
 {
     // For the moment there is not point going further than 0.5°.
@@ -501,6 +515,8 @@ int core_update(double dt)
         }
     }
 
+    // Send all the attributes changes of this frame to the listener.
+    module_flush_changes();
     return 0;
 }
 
@@ -546,6 +562,62 @@ static void core_get_point_for_mag_(
 }
 
 
+// Radius and luminance of a point, before the radius skip test.
+// Return the raw radius, used to decide if the point is visible.
+static double compute_point_for_mag(double mag, double *radius,
+                                    double *luminance)
+{
+    double ld, r, r_raw;
+    double r_min = core->min_point_radius;
+    const double r_skip = core->skip_point_radius;
+
+    // Fix aliasing on low res screen
+    if (r_min * core->win_pixels_scale < 1.0)
+        r_min = 1.0;
+
+    // Get radius and luminance without any constraint on the radius.
+    core_get_point_for_mag_(mag, &r, &ld);
+    r_raw = r;
+
+    // If the radius is too small, we adjust the luminance.
+    if (r > 0 && r < r_min) {
+        ld *= pow(max(r - r_skip, 0) / (r_min - r_skip), 2);
+        r = r_min;
+    }
+
+    ld = pow(ld, 1 / 2.2); // Gama correction.
+    // Saturate radius after a certain point.
+    // XXX: make it smooth.
+    r = min(r, core->max_point_radius);
+    *radius = r;
+    *luminance = clamp(ld, 0, 1);
+    return r_raw;
+}
+
+/*
+ * Build the table of points radius and luminance for the current frame.
+ *
+ * The values only depend on the tonemapper and the core settings, that
+ * don't change during a render, so we sample them once over the range of
+ * visible magnitudes and then interpolate linearly.  The raw radius is
+ * interpolated as well so that we can still test the skip radius.
+ */
+static void point_lut_update(double max_vmag)
+{
+    int i;
+    double mag;
+
+    g_point_lut.valid = false;
+    if (!(max_vmag > POINT_LUT_MIN_MAG)) return;
+    g_point_lut.step = (max_vmag - POINT_LUT_MIN_MAG) / (POINT_LUT_SIZE - 2);
+    for (i = 0; i < POINT_LUT_SIZE; i++) {
+        mag = POINT_LUT_MIN_MAG + i * g_point_lut.step;
+        g_point_lut.r_raw[i] = compute_point_for_mag(
+                mag, &g_point_lut.radius[i], &g_point_lut.luminance[i]);
+    }
+    g_point_lut.valid = true;
+}
+
 /*
  * Function: core_get_point_for_mag
  * Compute a point radius and luminosity from a observed magnitude.
@@ -555,6 +627,9 @@ static void core_get_point_for_mag_(
  * higher contrast.  Also for very small points, we use a minimum radius
  * and instead lower the luminance.
  *
+ * During a render the values are looked up in a table computed at the
+ * start of the frame.
+ *
  * Parameters:
  *   mag       - The observed magnitude.
  *   radius    - Output radius in window pixels.
@@ -563,36 +638,28 @@ static void core_get_point_for_mag_(
  */
 bool core_get_point_for_mag(double mag, double *radius, double *luminance)
 {
-    double ld, r;
-    double r_min = core->min_point_radius;
-    const double r_skip = core->skip_point_radius;
-
-    // Fix aliasing on low res screen
-    if (r_min * core->win_pixels_scale < 1.0)
-        r_min = 1.0;
+    double r_raw, r, ld, x, f;
+    int i;
 
-    // Get radius and luminance without any constraint on the radius.
-    core_get_point_for_mag_(mag, &r, &ld);
+    x = (mag - POINT_LUT_MIN_MAG) / g_point_lut.step;
+    if (g_point_lut.valid && x >= 0 && x < POINT_LUT_SIZE - 1) {
+        i = (int)x;
+        f = x - i;
+        r_raw = mix(g_point_lut.r_raw[i], g_point_lut.r_raw[i + 1], f);
+        r = mix(g_point_lut.radius[i], g_point_lut.radius[i + 1], f);
+        ld = mix(g_point_lut.luminance[i], g_point_lut.luminance[i + 1], f);
+    } else {
+        r_raw = compute_point_for_mag(mag, &r, &ld);
+    }
 
     // If the radius is really too small, we don't render the star.
-    if (r < r_skip) {
+    if (r_raw < core->skip_point_radius) {
         *radius = 0;
         if (luminance) *luminance = 0;
         return false;
     }
-
-    // If the radius is too small, we adjust the luminance.
-    if (r > 0 && r < r_min) {
-        ld *= pow((r - r_skip) / (r_min - r_skip), 2);
-        r = r_min;
-    }
-
-    ld = pow(ld, 1 / 2.2); // Gama correction.
-    // Saturate radius after a certain point.
-    // XXX: make it smooth.
-    r = min(r, core->max_point_radius);
     *radius = r;
-    if (luminance) *luminance = clamp(ld, 0, 1);
+    if (luminance) *luminance = ld;
     return true;
 }
 
@@ -724,6 +791,7 @@ int core_render(double win_w, double win_h, double pixel_scale)
     observer_update(core->observer, true);
     max_vmag = compute_vmag_for_radius(core->skip_point_radius);
     hints_vmag = compute_vmag_for_radius(core->show_hints_radius);
+    point_lut_update(max_vmag);
 
     fps_tick(&core->fps, sys_get_unix_time());
     module_changed(&core->obj, "fps");
@@ -779,6 +847,10 @@ int core_render(double win_w, double win_h, double pixel_scale)
             module->klass->post_render(module, &painter);
     }
 
+    g_point_lut.valid = false;
+
+    // Start the network requests of the tiles we need the most.
+    assets_dispatch();
     return 0;
 }
 
@@ -1189,8 +1261,13 @@ static int on_search(void *user, obj_t *obj)
 EMSCRIPTEN_KEEPALIVE
 obj_t *core_search(const char *query)
 {
-    obj_t *module, *ret = NULL;
+    obj_t *module, *ret;
+
+    ret = search_index_find(query);
+    if (ret) return ret;
+    // Iterate the modules that don't put their objects in the index.
     DL_FOREACH(core->obj.children, module) {
+        if (module->klass->flags & OBJ_INDEXED) continue;
         module_list_objs(module, NAN, 0, NULL, USER_PASS(query, &ret),
                          on_search);
     }
@@ -1290,7 +1367,36 @@ static void test_info(void)
     obj_get_info(obj, core->observer, INFO_VMAG, &vmag);
 }
 
+// Check that the points table gives the same values as the direct
+// computation.
+static void test_point_lut(void)
+{
+    double mag, max_vmag, r1, r2, l1, l2;
+    bool v1, v2;
+
+    core_init(100, 100, 1.0);
+    core_update(0);
+    // Adapt to a dark sky so that we have some visible stars.
+    tonemapper_update(&core->tonemapper, core->tonemapper_p, -1,
+                      core->exposure_scale, core->lwmax_min);
+    max_vmag = compute_vmag_for_radius(core->skip_point_radius);
+    point_lut_update(max_vmag);
+    assert(g_point_lut.valid);
+    for (mag = -6; mag < max_vmag + 1; mag += 0.0123) {
+        g_point_lut.valid = false;
+        v1 = core_get_point_for_mag(mag, &r1, &l1);
+        g_point_lut.valid = true;
+        v2 = core_get_point_for_mag(mag, &r2, &l2);
+        if (fabs(mag - max_vmag) < 0.01) continue; // Skip limit.
+        assert(v1 == v2);
+        assert(fabs(r1 - r2) < 0.001 * max(r1, 1));
+        assert(fabs(l1 - l2) < 0.002);
+    }
+    g_point_lut.valid = false;
+}
+
 TEST_REGISTER(NULL, test_core, TEST_AUTO);
+TEST_REGISTER(NULL, test_point_lut, TEST_AUTO);
 TEST_REGISTER(NULL, test_vec, TEST_AUTO);
 TEST_REGISTER(NULL, test_basic, TEST_AUTO);
 TEST_REGISTER(NULL, test_info, TEST_AUTO);
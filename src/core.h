@@ -18,6 +18,7 @@
 #include "observer.h"
 #include "obj.h"
 #include "module.h"
+#include "search_index.h"
 #include "otypes.h"
 #include "telescope.h"
 #include "tonemapper.h"
@@ -0,0 +1,160 @@
+/* Stellarium Web Engine - Copyright (c) 2018 - Noctua Software Ltd
+ *
+ * This program is licensed under the terms of the GNU AGPL v3, or
+ * alternatively under a commercial licence.
+ *
+ * The terms of the AGPL v3 license can be found in the main directory of this
+ * repository.
+ */
+
+#include "swe.h"
+
+#define MAX_ORDER 16
+#define NB_SEGMENTS 4
+
+typedef struct segment {
+    double  start;                      // Start time (MJD), or NAN if unset.
+    double  coefs[3][MAX_ORDER + 1];
+    int     last_used;
+} segment_t;
+
+struct ephcache {
+    double      seg_len;
+    int         order;
+    void        *user;
+    void        (*f)(void *user, double tt, double pos[3]);
+    segment_t   segments[NB_SEGMENTS];
+    int         tick;
+};
+
+ephcache_t *ephcache_create(double seg_len, int order, void *user,
+                            void (*f)(void *user, double tt, double pos[3]))
+{
+    ephcache_t *cache;
+    int i;
+
+    assert(order >= 1 && order <= MAX_ORDER);
+    cache = calloc(1, sizeof(*cache));
+    cache->seg_len = seg_len;
+    cache->order = order;
+    cache->user = user;
+    cache->f = f;
+    for (i = 0; i < NB_SEGMENTS; i++) cache->segments[i].start = NAN;
+    return cache;
+}
+
+// Compute the Chebyshev coefficients of a segment.
+static void segment_fit(const ephcache_t *cache, segment_t *seg, double start)
+{
+    int j, k, n = cache->order + 1;
+    double x, pos[MAX_ORDER + 1][3];
+
+    seg->start = start;
+    for (k = 0; k < n; k++) {
+        x = cos(M_PI * (k + 0.5) / n);
+        cache->f(cache->user, start + (x + 1) / 2 * cache->seg_len, pos[k]);
+    }
+    for (j = 0; j < n; j++) {
+        seg->coefs[0][j] = seg->coefs[1][j] = seg->coefs[2][j] = 0;
+        for (k = 0; k < n; k++) {
+            x = cos(M_PI * j * (k + 0.5) / n) * 2 / n;
+            seg->coefs[0][j] += pos[k][0] * x;
+            seg->coefs[1][j] += pos[k][1] * x;
+            seg->coefs[2][j] += pos[k][2] * x;
+        }
+    }
+    seg->coefs[0][0] /= 2;
+    seg->coefs[1][0] /= 2;
+    seg->coefs[2][0] /= 2;
+}
+
+static segment_t *get_segment(ephcache_t *cache, double start)
+{
+    segment_t *seg, *oldest = &cache->segments[0];
+    int i;
+
+    for (i = 0; i < NB_SEGMENTS; i++) {
+        seg = &cache->segments[i];
+        if (seg->start == start) goto end;
+        if (seg->last_used < oldest->last_used) oldest = seg;
+    }
+    seg = oldest;
+    segment_fit(cache, seg, start);
+end:
+    seg->last_used = ++cache->tick;
+    return seg;
+}
+
+void ephcache_get(ephcache_t *cache, double tt, double pv[2][3])
+{
+    const segment_t *seg;
+    double start, x, t[MAX_ORDER + 1], dt[MAX_ORDER + 1];
+    int i, j, n = cache->order + 1;
+
+    start = floor(tt / cache->seg_len) * cache->seg_len;
+    seg = get_segment(cache, start);
+    x = (tt - start) / cache->seg_len * 2 - 1;
+
+    // Chebyshev polynomials and their derivatives.
+    t[0] = 1;
+    t[1] = x;
+    dt[0] = 0;
+    dt[1] = 1;
+    for (j = 2; j < n; j++) {
+        t[j] = 2 * x * t[j - 1] - t[j - 2];
+        dt[j] = 2 * t[j - 1] + 2 * x * dt[j - 1] - dt[j - 2];
+    }
+    for (i = 0; i < 3; i++) {
+        pv[0][i] = pv[1][i] = 0;
+        for (j = 0; j < n; j++) {
+            pv[0][i] += seg->coefs[i][j] * t[j];
+            pv[1][i] += seg->coefs[i][j] * dt[j];
+        }
+        pv[1][i] *= 2 / cache->seg_len;
+    }
+}
+
+void ephcache_delete(ephcache_t *cache)
+{
+    free(cache);
+}
+
+/******** TESTS ***********************************************************/
+
+#if COMPILE_TESTS
+
+static void test_circle(void *user, double tt, double pos[3])
+{
+    int *nb_calls = user;
+    (*nb_calls)++;
+    pos[0] = cos(tt);
+    pos[1] = sin(tt);
+    pos[2] = tt * tt;
+}
+
+static void test_ephcache(void)
+{
+    ephcache_t *cache;
+    double tt, pv[2][3];
+    int nb_calls = 0;
+
+    cache = ephcache_create(1.0, 12, &nb_calls, test_circle);
+    for (tt = 10.0; tt < 12.0; tt += 0.01) {
+        ephcache_get(cache, tt, pv);
+        assert(fabs(pv[0][0] - cos(tt)) < 1e-12);
+        assert(fabs(pv[0][1] - sin(tt)) < 1e-12);
+        assert(fabs(pv[0][2] - tt * tt) < 1e-10);
+        assert(fabs(pv[1][0] + sin(tt)) < 1e-10);
+        assert(fabs(pv[1][1] - cos(tt)) < 1e-10);
+        assert(fabs(pv[1][2] - 2 * tt) < 1e-10);
+    }
+    // Two segments, and they should still be in the cache.
+    assert(nb_calls == 2 * 13);
+    ephcache_get(cache, 10.5, pv);
+    assert(nb_calls == 2 * 13);
+    ephcache_delete(cache);
+}
+
+TEST_REGISTER(NULL, test_ephcache, TEST_AUTO);
+
+#endif
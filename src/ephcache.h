@@ -0,0 +1,56 @@
+/* Stellarium Web Engine - Copyright (c) 2018 - Noctua Software Ltd
+ *
+ * This program is licensed under the terms of the GNU AGPL v3, or
+ * alternatively under a commercial licence.
+ *
+ * The terms of the AGPL v3 license can be found in the main directory of this
+ * repository.
+ */
+
+/*
+ * File: ephcache.h
+ * Cache of ephemerides as Chebyshev polynomials.
+ *
+ * The time is split into fixed length segments.  The first time a position
+ * is requested in a segment, the ephemeris function is evaluated at the
+ * Chebyshev nodes of the segment, and the polynomials coefficients are
+ * stored.  After that any position and velocity in the segment is a cheap
+ * polynomial evaluation.  The velocity is the derivative of the polynomial,
+ * so it is always consistent with the position.
+ *
+ * Only a few segments are kept per cache, which is enough for time
+ * scrubbing and light time corrections.
+ */
+
+typedef struct ephcache ephcache_t;
+
+/*
+ * Function: ephcache_create
+ * Create a new ephemeris cache.
+ *
+ * Parameters:
+ *   seg_len - Length of the segments (day).
+ *   order   - Order of the polynomials (up to 16).
+ *   user    - User data passed to the ephemeris function.
+ *   f       - The ephemeris function, that returns the position of a body
+ *             at a given TT time (MJD).
+ */
+ephcache_t *ephcache_create(double seg_len, int order, void *user,
+                            void (*f)(void *user, double tt, double pos[3]));
+
+/*
+ * Function: ephcache_get
+ * Get the position and velocity of a body at a given time.
+ *
+ * Parameters:
+ *   cache  - An ephemeris cache.
+ *   tt     - TT time (MJD).
+ *   pv     - Output position and velocity (per day).
+ */
+void ephcache_get(ephcache_t *cache, double tt, double pv[2][3]);
+
+/*
+ * Function: ephcache_delete
+ * Delete an ephemeris cache.
+ */
+void ephcache_delete(ephcache_t *cache);
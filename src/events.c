@@ -8,88 +8,263 @@
  */
 
 /*
- * This file is only used by the javascript at the moment.  We could
- * probably try to remove it totally at some point
+ * Rise, set and transit times computation.
+ *
+ * The events are the zeros of two functions of time:
+ *   - the altitude of the top of the object above the horizon (rise/set).
+ *   - the sine of the angle of the object east of the meridian plane
+ *     (upper and lower transits).
+ *
+ * We sample those functions at a fixed step, computing each observer state
+ * only once for all the objects.  If a step is too large compared to the
+ * max angular speed of an object to be sure that it does not contain two
+ * zeros, it gets subdivided.  Then each sign change is refined with Brent's
+ * method.
  */
 
 #include "swe.h"
+#include "events.h"
 
-// Events types
+// Number of observer states computed together.
+#define BLOCK_SIZE 64
+// Max number of subdivisions of a step.
+#define MAX_DEPTH 8
+#define BRENT_MAX_ITER 64
+// Earth rotation rate relative to the stars (rad/day).
+#define EARTH_ROTATION (2 * M_PI * 1.00273781191135448)
+
+// Index of the functions whose zeros give the events.
 enum {
-    EVENT_RISE      = 1 << 0,
-    EVENT_SET       = 1 << 1,
+    FN_ALT,
+    FN_MERIDIAN,
 };
 
-// Newton algo.
-#define NEWTON_MAX_STEPS 20
-static double newton(double (*f)(double x, void *user),
-                     double x0, double x1, double precision, void *user)
-{
-    int nbiter = 0;
-    double f0, f1, tmp;
-    double startDelta = fabs(x1 - x0);
-    f0 = f(x0, user);
-    f1 = f(x1, user);
-    while (f1 && fabs(x1 - x0) > precision && f1 != f0) {
-        tmp = x1;
-        x1 = x1 + (x1 - x0) / (f0 / f1 - 1.0);
-        x0 = tmp;
-        // Check for diverging
-        if (fabs(x1 - x0) > startDelta * 10)
-            return NAN;
-        f0 = f1;
-        f1 = f(x1, user);
-        if (nbiter++ > NEWTON_MAX_STEPS)
-            return x1;
-    }
-    return x1;
-}
+typedef struct {
+    int         types;
+    double      precision;
+    observer_t  *obs;   // Scratch observer for the subdivisions.
+    obj_t       *obj;   // Current object.
+    int         obj_idx;
+    event_t     *events;
+    int         nb;
+    int         allocated;
+} ctx_t;
 
 static int sign(double x)
 {
     return x < 0 ? -1 : 1;
 }
 
-static double find_zero(double (*f)(double x, void *user),
-                        double x0, double x1, double step, double precision,
-                        int rising, void *user)
+// Compute the values of the events functions for an object.
+static void eval_obj(obj_t *obj, const observer_t *obs, double out[2],
+                     double *alt)
 {
-    int last_sign = 0;
-    double x, fx;
-    bool found = false;
-    // First find an approximate answer simply by stepping.  Not very clever.
-    // Make sure the last iteration is exactly at x1.
-    for (x = x0;; x += step) {
-        if (x > x1) x = x1; // Clamp to x1.
-        fx = f(x, user);
-        if (sign(fx) * last_sign == -1 && sign(fx) == rising) {
-            found = true;
-            break;
+    double radius = 0, pvo[2][4], observed[4], az, alt_;
+
+    obj_get_pvo(obj, (observer_t*)obs, pvo);
+    convert_framev4(obs, FRAME_ICRF, FRAME_OBSERVED, pvo[0], observed);
+    eraC2s(observed, &az, &alt_);
+    obj_get_info(obj, (observer_t*)obs, INFO_RADIUS, &radius);
+    out[FN_ALT] = alt_ + radius - obs->horizon;
+    // The observed frame Y axis points to the east.
+    out[FN_MERIDIAN] = observed[1] / vec3_norm(observed);
+    if (alt) *alt = alt_;
+}
+
+static void eval_at(ctx_t *ctx, double t, double out[2], double *alt)
+{
+    ctx->obs->tt = t;
+    observer_update(ctx->obs, false);
+    eval_obj(ctx->obj, ctx->obs, out, alt);
+}
+
+/*
+ * Upper bound of the rate of change of the events functions (per day).
+ *
+ * Both functions are sines or angles on the sky, so their derivatives are
+ * bounded by the angular speed of the object relative to the rotating
+ * Earth.  We add a margin since the velocity changes over the window.
+ */
+static double get_max_rate(obj_t *obj, const observer_t *obs)
+{
+    double pvo[2][4], w[3], d2;
+
+    obj_get_pvo(obj, (observer_t*)obs, pvo);
+    d2 = vec3_norm2(pvo[0]);
+    if (pvo[0][3] == 0.0 || d2 == 0.0) return 1.2 * EARTH_ROTATION;
+    vec3_cross(pvo[0], pvo[1], w);
+    return 1.2 * (EARTH_ROTATION + vec3_norm(w) / d2);
+}
+
+// Brent's method root finding, with f(a) and f(b) of opposite signs.
+static double brent(ctx_t *ctx, int fn, double a, double b,
+                    double fa, double fb)
+{
+    double c = a, fc = fa, d = b - a, e = d;
+    double tol, m, p, q, r, s, v[2];
+    int iter;
+
+    for (iter = 0; iter < BRENT_MAX_ITER; iter++) {
+        if (sign(fb) == sign(fc)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (fabs(fc) < fabs(fb)) {
+            a = b; b = c; c = a;
+            fa = fb; fb = fc; fc = fa;
         }
-        last_sign = sign(fx);
-        if (x == x1) break;
+        tol = ctx->precision / 2;
+        m = (c - b) / 2;
+        if (fabs(m) <= tol || fb == 0.0) break;
+        if (fabs(e) >= tol && fabs(fa) > fabs(fb)) {
+            // Inverse quadratic interpolation.
+            s = fb / fa;
+            if (a == c) {
+                p = 2 * m * s;
+                q = 1 - s;
+            } else {
+                q = fa / fc;
+                r = fb / fc;
+                p = s * (2 * m * q * (q - r) - (b - a) * (r - 1));
+                q = (q - 1) * (r - 1) * (s - 1);
+            }
+            if (p > 0) q = -q;
+            p = fabs(p);
+            if (2 * p < min(3 * m * q - fabs(tol * q), fabs(e * q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = e = m;
+            }
+        } else {
+            d = e = m; // Bisection.
+        }
+        a = b;
+        fa = fb;
+        b += fabs(d) > tol ? d : (m > 0 ? tol : -tol);
+        eval_at(ctx, b, v, NULL);
+        fb = v[fn];
     }
-    if (!found) return NAN;
-    // Once we are near the value, use newton algorithm.
-    return newton(f, x - step, x, precision, user);
+    return b;
 }
 
-static double rise_dist(double time, void *user)
+static void add_event(ctx_t *ctx, int type, double time)
 {
-    struct {
-        observer_t *obs;
-        obj_t *obj;
-    } *data = user;
-    double radius = 0, pvo[2][4], observed[4], az, alt;
-
-    data->obs->tt = time;
-    observer_update(data->obs, false);
-    obj_get_pvo(data->obj, data->obs, pvo);
-    convert_framev4(data->obs, FRAME_ICRF, FRAME_OBSERVED, pvo[0], observed);
-    eraC2s(observed, &az, &alt);
-    az = eraAnp(az);
-    obj_get_info(data->obj, data->obs, INFO_RADIUS, &radius);
-    return alt + radius - data->obs->horizon;
+    event_t *event;
+    double v[2];
+
+    if (ctx->nb >= ctx->allocated) {
+        ctx->allocated = max(16, ctx->allocated * 2);
+        ctx->events = realloc(ctx->events,
+                              ctx->allocated * sizeof(*ctx->events));
+    }
+    event = &ctx->events[ctx->nb++];
+    event->obj = ctx->obj_idx;
+    event->type = type;
+    event->time = time;
+    eval_at(ctx, time, v, &event->alt);
+}
+
+static void process_interval(ctx_t *ctx, double t0, double t1,
+                             const double v0[2], const double v1[2],
+                             double rate, int depth)
+{
+    const int masks[2] = {EVENT_RISE | EVENT_SET,
+                          EVENT_TRANSIT | EVENT_LOWER_TRANSIT};
+    bool subdivide = false;
+    double tm, vm[2], t;
+    int fn, type;
+
+    // If there is no sign change, we can still have two zeros in the
+    // interval if the function had the time to go to zero and back.
+    for (fn = 0; fn < 2; fn++) {
+        if (!(ctx->types & masks[fn])) continue;
+        if (sign(v0[fn]) != sign(v1[fn])) continue;
+        if (fabs(v0[fn]) + fabs(v1[fn]) <= rate * (t1 - t0))
+            subdivide = true;
+    }
+    if (subdivide && depth < MAX_DEPTH && t1 - t0 > ctx->precision) {
+        tm = (t0 + t1) / 2;
+        eval_at(ctx, tm, vm, NULL);
+        process_interval(ctx, t0, tm, v0, vm, rate, depth + 1);
+        process_interval(ctx, tm, t1, vm, v1, rate, depth + 1);
+        return;
+    }
+
+    for (fn = 0; fn < 2; fn++) {
+        if (sign(v0[fn]) == sign(v1[fn])) continue;
+        if (fn == FN_ALT)
+            type = v0[fn] < 0 ? EVENT_RISE : EVENT_SET;
+        else
+            type = v0[fn] < 0 ? EVENT_LOWER_TRANSIT : EVENT_TRANSIT;
+        if (!(ctx->types & type)) continue;
+        t = brent(ctx, fn, t0, t1, v0[fn], v1[fn]);
+        add_event(ctx, type, t);
+    }
+}
+
+static int event_cmp(const void *a_, const void *b_)
+{
+    const event_t *a = a_, *b = b_;
+    if (a->obj != b->obj) return cmp(a->obj, b->obj);
+    return cmp(a->time, b->time);
+}
+
+EMSCRIPTEN_KEEPALIVE
+int events_compute(const observer_t *obs, obj_t *const *objs, int nb_objs,
+                   int types, double start_time, double end_time,
+                   double precision, event_t **events)
+{
+    ctx_t ctx = {.types = types, .precision = precision};
+    observer_t *states;
+    double step, t0, t1, v[2], (*prev)[2], *rates;
+    int i, j, k, n, nb_steps;
+
+    *events = NULL;
+    if (nb_objs <= 0 || end_time <= start_time) return 0;
+
+    step = min(1.0 / 24, (end_time - start_time) / 24);
+    nb_steps = ceil((end_time - start_time) / step);
+    states = malloc(BLOCK_SIZE * sizeof(*states));
+    prev = malloc(nb_objs * sizeof(*prev));
+    rates = malloc(nb_objs * sizeof(*rates));
+    ctx.obs = malloc(sizeof(*ctx.obs));
+    *ctx.obs = *obs;
+
+    // Sample the steps by blocks, so that the observer states can be
+    // shared by all the objects without having to keep all of them.
+    for (i = 0; i <= nb_steps; i += BLOCK_SIZE) {
+        n = min(BLOCK_SIZE, nb_steps + 1 - i);
+        for (k = 0; k < n; k++) {
+            states[k] = *obs;
+            states[k].tt = min(start_time + (i + k) * step, end_time);
+            observer_update(&states[k], false);
+        }
+        for (j = 0; j < nb_objs; j++) {
+            ctx.obj = objs[j];
+            ctx.obj_idx = j;
+            for (k = 0; k < n; k++) {
+                eval_obj(objs[j], &states[k], v, NULL);
+                if (i + k == 0) {
+                    rates[j] = get_max_rate(objs[j], &states[k]);
+                } else {
+                    t0 = min(start_time + (i + k - 1) * step, end_time);
+                    t1 = states[k].tt;
+                    process_interval(&ctx, t0, t1, prev[j], v, rates[j], 0);
+                }
+                vec2_copy(v, prev[j]);
+            }
+        }
+    }
+
+    free(states);
+    free(prev);
+    free(rates);
+    free(ctx.obs);
+    qsort(ctx.events, ctx.nb, sizeof(*ctx.events), event_cmp);
+    *events = ctx.events;
+    return ctx.nb;
 }
 
 EMSCRIPTEN_KEEPALIVE
@@ -100,16 +275,58 @@ double compute_event(observer_t *obs,
                      double end_time,
                      double precision)
 {
-    observer_t obs2 = *obs;
-    double ret;
-    int rising;
-    struct {
-        observer_t *obs;
-        obj_t *obj;
-    } data = {&obs2, obj};
-    rising = event == EVENT_RISE ? +1 : -1;
-    ret = find_zero(rise_dist, start_time, end_time,
-                    (end_time - start_time) / 24, precision,
-                    rising, &data);
+    event_t *events;
+    double ret = NAN;
+    int nb;
+
+    nb = events_compute(obs, &obj, 1, event, start_time, end_time,
+                        precision, &events);
+    if (nb) ret = events[0].time;
+    free(events);
     return ret;
 }
+
+/******** TESTS ***********************************************************/
+
+#if COMPILE_TESTS
+
+static void test_events(void)
+{
+    observer_t obs;
+    obj_t *sun;
+    event_t *events;
+    int i, nb, types[4] = {};
+
+    core_init(100, 100, 1.0);
+    obs = *core->observer;
+    obs.tt = 58849.0;
+    observer_update(&obs, false);
+    sun = core_get_planet(10);
+    assert(sun);
+    nb = events_compute(&obs, &sun, 1,
+                        EVENT_RISE | EVENT_SET | EVENT_TRANSIT |
+                        EVENT_LOWER_TRANSIT,
+                        obs.tt, obs.tt + 2, 1.0 / 24 / 3600, &events);
+    // Two of each event, alternating, spaced by about half a day.
+    assert(nb == 8);
+    for (i = 0; i < nb; i++) {
+        types[(int)log2(events[i].type)]++;
+        if (i) assert(events[i].time > events[i - 1].time);
+        if (events[i].type == EVENT_TRANSIT)
+            assert(events[i].alt > 0);
+        if (events[i].type == EVENT_LOWER_TRANSIT)
+            assert(events[i].alt < 0);
+        if (i >= 4)
+            assert(fabs(events[i].time - events[i - 4].time - 1) < 0.01);
+    }
+    assert(types[0] == 2 && types[1] == 2 && types[2] == 2 && types[3] == 2);
+    // compute_event returns the first event of the given type.
+    for (i = 0; events[i].type != EVENT_SET; i++) {}
+    assert(compute_event(&obs, sun, EVENT_SET, obs.tt, obs.tt + 2,
+                         1.0 / 24 / 3600) == events[i].time);
+    free(events);
+}
+
+TEST_REGISTER(NULL, test_events, TEST_AUTO);
+
+#endif
@@ -0,0 +1,77 @@
+/* Stellarium Web Engine - Copyright (c) 2018 - Noctua Software Ltd
+ *
+ * This program is licensed under the terms of the GNU AGPL v3, or
+ * alternatively under a commercial licence.
+ *
+ * The terms of the AGPL v3 license can be found in the main directory of this
+ * repository.
+ */
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+/*
+ * File: events.h
+ * Computation of rise, set and transit times of objects.
+ */
+
+#include "obj.h"
+#include "observer.h"
+
+/*
+ * Enum: EVENT_TYPES
+ *
+ * EVENT_RISE           - The object rises above the observer horizon.
+ * EVENT_SET            - The object sets below the observer horizon.
+ * EVENT_TRANSIT        - Upper culmination: the object crosses the meridian
+ *                        from east to west.
+ * EVENT_LOWER_TRANSIT  - Lower culmination: the object crosses the meridian
+ *                        from west to east.
+ */
+enum {
+    EVENT_RISE          = 1 << 0,
+    EVENT_SET           = 1 << 1,
+    EVENT_TRANSIT       = 1 << 2,
+    EVENT_LOWER_TRANSIT = 1 << 3,
+};
+
+/*
+ * Type: event_t
+ * An event returned by <events_compute>.
+ */
+typedef struct event {
+    int     obj;    // Index of the object in the list passed.
+    int     type;   // One of <EVENT_TYPES>.
+    double  time;   // TT time of the event (MJD).
+    double  alt;    // Altitude of the object at the event (rad).
+} event_t;
+
+/*
+ * Function: events_compute
+ * Compute all the events of a list of objects in a time window.
+ *
+ * The observer state is computed only once for each step of the time
+ * window, and shared by all the objects.  Intervals where an event could
+ * happen between two steps (according to the max angular speed of the
+ * object) are subdivided, and the events are then refined with Brent's
+ * method.
+ *
+ * Parameters:
+ *   obs        - The observer.
+ *   objs       - Array of objects.
+ *   nb_objs    - Number of objects.
+ *   types      - Union of the <EVENT_TYPES> to compute.
+ *   start_time - Start of the window (TT MJD).
+ *   end_time   - End of the window (TT MJD).
+ *   precision  - Precision of the events times (day).
+ *   events     - Allocated array of the events, sorted by object then
+ *                time.  Need to be freed by the caller.
+ *
+ * Return:
+ *   The number of events.
+ */
+int events_compute(const observer_t *obs, obj_t *const *objs, int nb_objs,
+                   int types, double start_time, double end_time,
+                   double precision, event_t **events);
+
+#endif // EVENTS_H
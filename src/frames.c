@@ -191,6 +191,56 @@ int convert_frame(const observer_t *obs,
     return 0;
 }
 
+void convert_frame_many(const observer_t *obs, int origin, int dest,
+                        bool at_inf, int n, const double (*in)[3],
+                        double (*out)[3])
+{
+    PROFILE(convert_frame_many, PROFILE_AGGREGATE);
+    const double (*rot)[3];
+    double p[3], dist;
+    int i;
+
+    obs = obs ?: (observer_t*)core->observer;
+    if (dest != FRAME_VIEW || origin > FRAME_CIRS) {
+        for (i = 0; i < n; i++)
+            convert_frame(obs, origin, dest, at_inf, in[i], out[i]);
+        return;
+    }
+
+    if (origin == FRAME_ASTROM) {
+        for (i = 0; i < n; i++)
+            astrometric_to_apparent(obs, in[i], at_inf, out[i]);
+        in = (const double (*)[3])out;
+    }
+
+    // Without refraction the whole rotation chain is a single matrix.
+    if (!obs->pressure) {
+        rot = (origin == FRAME_CIRS) ? obs->ri2v : obs->rc2v;
+        for (i = 0; i < n; i++)
+            mat3_mul_vec3(rot, in[i], out[i]);
+        return;
+    }
+
+    rot = (origin == FRAME_CIRS) ? obs->ri2h : obs->rc2h;
+    for (i = 0; i < n; i++) {
+        mat3_mul_vec3(rot, in[i], p);
+        if (at_inf) {
+            refraction(p, obs->refa, obs->refb, p);
+        } else {
+            // Special case for null's vectors
+            dist = vec3_norm(p);
+            if (dist == 0.0) {
+                vec3_set(out[i], 0, 0, 0);
+                continue;
+            }
+            vec3_mul(1.0 / dist, p, p);
+            refraction(p, obs->refa, obs->refb, p);
+            vec3_mul(dist, p, p);
+        }
+        mat3_mul_vec3(obs->ro2v, p, out[i]);
+    }
+}
+
 EMSCRIPTEN_KEEPALIVE
 int convert_framev4(const observer_t *obs,
                         int origin, int dest,
@@ -310,6 +360,10 @@ bool frame_get_rotation(const observer_t *obs, int origin, int dest,
         mat3_set_identity(rot);
         return true;
     }
+    if (origin == FRAME_OBSERVED && dest == FRAME_VIEW) {
+        mat3_copy(obs->ro2v, rot);
+        return true;
+    }
     // For the moment we only support ICRF to VIEW, without refraction.
     if (origin != FRAME_ICRF || dest != FRAME_VIEW || obs->pressure)
         return false;
@@ -466,4 +520,33 @@ static void test_convert_origin(void)
 
 TEST_REGISTER(NULL, test_convert_origin, TEST_AUTO)
 
+// Check that convert_frame_many gives the same results as convert_frame.
+static void test_convert_frame_many(void)
+{
+    observer_t *obs;
+    double in[64][3], out[64][3], ref[3];
+    int i, origin, at_inf, pressure;
+
+    core_init(100, 100, 1.0);
+    obs = core->observer;
+    for (i = 0; i < 64; i++) {
+        vec3_set(in[i], sin(i), cos(i * 3), sin(i * 7));
+        vec3_normalize(in[i], in[i]);
+    }
+    for (pressure = 0; pressure < 2; pressure++) {
+        obs->pressure = pressure ? 1013.25 : 0;
+        observer_update(obs, false);
+        for (origin = FRAME_ASTROM; origin <= FRAME_OBSERVED; origin++)
+        for (at_inf = 0; at_inf < 2; at_inf++) {
+            convert_frame_many(obs, origin, FRAME_VIEW, at_inf, 64, in, out);
+            for (i = 0; i < 64; i++) {
+                convert_frame(obs, origin, FRAME_VIEW, at_inf, in[i], ref);
+                assert(vec3_dist(out[i], ref) < 1e-12);
+            }
+        }
+    }
+}
+
+TEST_REGISTER(NULL, test_convert_frame_many, TEST_AUTO)
+
 #endif
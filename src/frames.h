@@ -123,6 +123,28 @@ int convert_frame(const observer_t *obs,
                         int origin, int dest, bool at_inf,
                         const double in[3], double out[3]);
 
+/*
+ * Function: convert_frame_many
+ * Same as <convert_frame>, for a list of vectors.
+ *
+ * The conversions to FRAME_VIEW from the ASTROM, ICRF and CIRS frames use
+ * the rotation matrices precomputed in the observer, so that without
+ * refraction each vector only needs a single matrix product after the
+ * aberration.  The other conversions fall back to <convert_frame>.
+ *
+ * Parameters:
+ *  obs     - The observer.  If NULL we use the current core observer.
+ *  origin  - Origin coordinates.  One of the <FRAME> enum values.
+ *  dest    - Destination coordinates.  One of the <FRAME> enum values.
+ *  at_inf  - true for fixed objects (far away from the solar system).
+ *  n       - Number of vectors.
+ *  in      - The input coordinates (3d AU).
+ *  out     - The output coordinates (3d AU).  Can be the same as in.
+ */
+void convert_frame_many(const observer_t *obs, int origin, int dest,
+                        bool at_inf, int n, const double (*in)[3],
+                        double (*out)[3]);
+
 /*
  * Function: convert_framev4
  * Rotate a 4D vector from a frame to an other.
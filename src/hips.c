@@ -226,9 +226,13 @@ static int parse_properties(hips_t *hips)
 static int del_tile(void *data)
 {
     tile_t *tile = data;
-    // XXX: why the worker_is_running?
-    if (tile->loader && worker_is_running(&tile->loader->worker))
-        return CACHE_KEEP;
+    // Drop the loader if it didn't start yet, otherwise wait for it.
+    if (tile->loader) {
+        if (!worker_cancel(&tile->loader->worker)) return CACHE_KEEP;
+        free(tile->loader->data);
+        free(tile->loader);
+        tile->loader = NULL;
+    }
     if (tile->data) {
         if (tile->hips->settings.delete_tile(tile->data) == CACHE_KEEP)
             return CACHE_KEEP;
@@ -254,37 +258,18 @@ static bool img_is_transparent(
 
 int hips_traverse(void *user, int callback(int order, int pix, void *user))
 {
-    typedef struct {
-        int order;
-        int pix;
-    } node_t;
-    node_t queue[1024];
-    const int n = ARRAY_SIZE(queue);
-    int start = 0, size = 12, r, i;
-    int order, pix;
-    // Enqueue the first 12 pix at order 0.
-    for (i = 0; i < 12; i++) {queue[i] = (node_t){0, i};}
-    while (size) {
-        order = queue[start % n].order;
-        pix = queue[start % n].pix;
-        start++;
-        size--;
+    hips_iterator_t iter;
+    int order, pix, r = 0;
+
+    hips_iter_init(&iter);
+    while (hips_iter_next(&iter, &order, &pix)) {
         r = callback(order, pix, user);
-        if (r < 0) return r;
-        if (r == 1) {
-            // Enqueue the 4 children tiles.
-            if (size + 4 >= n) {
-                // No more space.
-                LOG_W("Abort HIPS traverse");
-                return -1;
-            }
-            for (i = 0; i < 4; i++) {
-                queue[(start + size) % n] = (node_t){order + 1, pix * 4 + i};
-                size++;
-            }
-        }
+        if (r < 0) break;
+        if (r == 1) hips_iter_push_children(&iter, order, pix);
+        r = 0;
     }
-    return 0;
+    hips_iter_release(&iter);
+    return r;
 }
 
 /*
@@ -296,6 +281,8 @@ void hips_iter_init(hips_iterator_t *iter)
     int i;
     typedef __typeof__(iter->queue[0]) node_t;
     memset(iter, 0, sizeof(*iter));
+    iter->allocated = 64;
+    iter->queue = malloc(iter->allocated * sizeof(*iter->queue));
     // Enqueue the first 12 pix at order 0.
     iter->size = 12;
     for (i = 0; i < 12; i++) {
@@ -303,6 +290,17 @@ void hips_iter_init(hips_iterator_t *iter)
     }
 }
 
+/*
+ * Function: hips_iter_release
+ * Release the memory used by an iterator.
+ */
+void hips_iter_release(hips_iterator_t *iter)
+{
+    free(iter->queue);
+    iter->queue = NULL;
+    iter->size = 0;
+}
+
 /*
  * Function: hips_iter_next
  * Pop the next healpix pixel from the iterator.
@@ -311,12 +309,11 @@ void hips_iter_init(hips_iterator_t *iter)
  */
 bool hips_iter_next(hips_iterator_t *iter, int *order, int *pix)
 {
-    const int n = ARRAY_SIZE(iter->queue);
     if (!iter->size) return false;
     // Get the first tile from the queue.
-    *order = iter->queue[iter->start % n].order;
-    *pix = iter->queue[iter->start % n].pix;
-    iter->start++;
+    *order = iter->queue[iter->start].order;
+    *pix = iter->queue[iter->start].pix;
+    iter->start = (iter->start + 1) % iter->allocated;
     iter->size--;
     return true;
 }
@@ -331,13 +328,18 @@ bool hips_iter_next(hips_iterator_t *iter, int *order, int *pix)
 void hips_iter_push_children(hips_iterator_t *iter, int order, int pix)
 {
     typedef __typeof__(iter->queue[0]) node_t;
-    const int n = ARRAY_SIZE(iter->queue);
-    int i;
-    // Enqueue the next four tiles.
-    if (iter->size + 4 >= n) {
-        // Todo: we should probably use a dynamic array instead.
-        LOG_E("No more space!");
-        return;
+    int i, n = iter->allocated;
+
+    // Grow the ring buffer, moving the wrapped part after the old end.
+    if (iter->size + 4 > n) {
+        iter->allocated *= 2;
+        iter->queue = realloc(iter->queue,
+                              iter->allocated * sizeof(*iter->queue));
+        if (iter->start + iter->size > n) {
+            memcpy(iter->queue + n, iter->queue,
+                   (iter->start + iter->size - n) * sizeof(*iter->queue));
+        }
+        n = iter->allocated;
     }
     for (i = 0; i < 4; i++) {
         iter->queue[(iter->start + iter->size) % n] = (node_t) {
@@ -545,6 +547,7 @@ static bool hips_update(hips_t *hips)
         if (!data) hips->allsky.not_available = true;
         if (data) {
             worker_init(&hips->allsky.worker, load_allsky_worker);
+            worker_set_priority(&hips->allsky.worker, 1);
             hips->ref++;
             hips->allsky.src_data = malloc(size);
             hips->allsky.size = size;
@@ -621,11 +624,19 @@ int hips_render_traverse(
     // Breath first traversal of all the tiles.
     hips_iter_init(&iter);
     while (hips_iter_next(&iter, &order, &pix)) {
-        // Early exit if the tile is clipped.
-        uv_map_init_healpix(&map, order, pix, false, false);
-        map.transf = (void*)transf;
-        if (painter_is_quad_clipped(painter, hips->frame, &map, outside))
-            continue;
+        // Early exit if the tile is clipped.  Sky surveys go through
+        // painter_is_healpix_clipped to share its cache with the other
+        // modules.
+        if (!transf && outside) {
+            if (painter_is_healpix_clipped(painter, hips->frame, order, pix,
+                                           true))
+                continue;
+        } else {
+            uv_map_init_healpix(&map, order, pix, false, false);
+            map.transf = (void*)transf;
+            if (painter_is_quad_clipped(painter, hips->frame, &map, outside))
+                continue;
+        }
         if (order < render_order) { // Keep going.
             hips_iter_push_children(&iter, order, pix);
             continue;
@@ -633,6 +644,7 @@ int hips_render_traverse(
         split = 1 << (split_order - render_order);
         callback(hips, painter, transf, order, pix, split, flags, user);
     }
+    hips_iter_release(&iter);
     return 0;
 }
 
@@ -690,9 +702,31 @@ static int load_tile_worker(worker_t *worker)
     if (!tile->data) tile->flags |= TILE_LOAD_ERROR;
     tile->flags |= (transparency * TILE_NO_CHILD_0);
     free(loader->data);
+    loader->data = NULL;
     return 0;
 }
 
+/*
+ * Compute the priority of a tile network request.
+ *
+ * This is roughly the tile surface on screen, divided by the distance to
+ * the center of the screen, so that large tiles close to the center get
+ * loaded first.  For planets we only consider the tiles order.
+ */
+static double tile_get_priority(const hips_t *hips, int order, int pix,
+                                int flags)
+{
+    double area, pos[3], dist;
+    const double fov = core->fov;
+
+    area = 4 * M_PI / (12 << (2 * order)) / (fov * fov);
+    if (flags & HIPS_PLANET) return area;
+    healpix_pix2vec(1 << order, pix, pos);
+    convert_frame(core->observer, hips->frame, FRAME_VIEW, true, pos, pos);
+    dist = acos(clamp(-pos[2], -1.0, 1.0)); // Angle to the view direction.
+    return area / (1.0 + dist / fov);
+}
+
 static tile_t *hips_get_tile_(hips_t *hips, int order, int pix, int flags,
                               int *code)
 {
@@ -746,7 +780,12 @@ static tile_t *hips_get_tile_(hips_t *hips, int order, int pix, int flags,
     if (order > 0 && !(flags & HIPS_NO_DELAY))
         asset_flags |= ASSET_DELAY;
     data = asset_get_data2(url, asset_flags, &size, code);
-    if (!(*code)) return NULL; // Still loading the file.
+    if (!(*code)) { // Still loading the file.
+        if (asset_flags & ASSET_DELAY)
+            asset_set_priority(url, tile_get_priority(hips, order, pix,
+                                                      flags));
+        return NULL;
+    }
 
     // If the tile doesn't exists, mark it in the parent tile so that we
     // won't have to search for it again.
@@ -788,6 +827,9 @@ static tile_t *hips_get_tile_(hips_t *hips, int order, int pix, int flags,
     } else {
         tile->loader = calloc(1, sizeof(*tile->loader));
         worker_init(&tile->loader->worker, load_tile_worker);
+        // Decode the low order tiles first, since they are needed before
+        // we can get their children.
+        worker_set_priority(&tile->loader->worker, -order);
         tile->loader->data = malloc(size);
         tile->loader->size = size;
         tile->loader->tile = tile;
@@ -853,6 +895,31 @@ static int delete_img_tile(void *tile_)
     return 0;
 }
 
+const void *hips_pin_tile(hips_t *hips, int order, int pix)
+{
+    tile_key_t key = {hips->hash, order, pix};
+    tile_t *tile;
+    if (!g_cache) return NULL;
+    tile = cache_pin(g_cache, &key, sizeof(key));
+    if (tile && !tile->data) { // Still loading.
+        cache_unpin(g_cache, &key, sizeof(key));
+        return NULL;
+    }
+    return tile ? tile->data : NULL;
+}
+
+void hips_unpin_tile(hips_t *hips, int order, int pix)
+{
+    tile_key_t key = {hips->hash, order, pix};
+    cache_unpin(g_cache, &key, sizeof(key));
+}
+
+void hips_get_cache_stats(cache_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (g_cache) cache_get_stats(g_cache, stats);
+}
+
 /*
  * Function: hips_parse_date
  * Parse a date in the format supported for HiPS property files
@@ -872,3 +939,26 @@ double hips_parse_date(const char *str)
     eraDtf2d("UTC", iy, im, id, ihr, imn, 0, &d1, &d2);
     return d1 - DJM0 + d2;
 }
+
+/******** TESTS ***********************************************************/
+
+#if COMPILE_TESTS
+
+static int test_traverse_callback(int order, int pix, void *user)
+{
+    int *nb = user;
+    nb[order]++;
+    return order < 5 ? 1 : 0;
+}
+
+static void test_hips_traverse(void)
+{
+    int nb[6] = {}, i;
+    // Up to 12288 pixels queued at the same time.
+    assert(hips_traverse(nb, test_traverse_callback) == 0);
+    for (i = 0; i <= 5; i++) assert(nb[i] == 12 * (1 << (2 * i)));
+}
+
+TEST_REGISTER(NULL, test_hips_traverse, TEST_AUTO);
+
+#endif
@@ -155,7 +155,6 @@ bool hips_is_ready(hips_t *hips);
  *
  * Return:
  *   0 if the traverse finished.
- *   -1 if we reach the traverse limite.
  *   -v if the callback returned a negative value -v.
  */
 int hips_traverse(void *user, int callback(int order, int pix, void *user));
@@ -177,14 +176,18 @@ int hips_traverse(void *user, int callback(int order, int pix, void *user));
  *         hips_iter_push_children(iter, order, pix);
  *      }
  *  }
+ *  hips_iter_release(&iter);
  *
+ * The queue grows as needed, so there is no limit to the number of pixels
+ * we can iterate.
  */
 typedef struct hips_iterator
 {
     struct {
         int order;
         int pix;
-    } queue[1024]; // Todo: make it dynamic?
+    } *queue;       // Ring buffer.
+    int allocated;
     int size;
     int start;
 } hips_iterator_t;
@@ -195,6 +198,12 @@ typedef struct hips_iterator
  */
 void hips_iter_init(hips_iterator_t *iter);
 
+/*
+ * Function: hips_iter_release
+ * Release the memory used by an iterator.
+ */
+void hips_iter_release(hips_iterator_t *iter);
+
 /*
  * Function: hips_iter_next
  * Pop the next healpix pixel from the iterator.
@@ -324,6 +333,29 @@ int hips_render_traverse(hips_t *hips, const painter_t *painter,
                                       int order, int pix, int split,
                                       int flags, void *user));
 
+/*
+ * Function: hips_pin_tile
+ * Prevent a loaded tile from being removed from the cache.
+ *
+ * Each call needs to be balanced with a call to <hips_unpin_tile>.
+ *
+ * Return:
+ *   The tile data, or NULL if the tile is not in the cache.
+ */
+const void *hips_pin_tile(hips_t *hips, int order, int pix);
+
+/*
+ * Function: hips_unpin_tile
+ * Release a pin previously set with <hips_pin_tile>.
+ */
+void hips_unpin_tile(hips_t *hips, int order, int pix);
+
+/*
+ * Function: hips_get_cache_stats
+ * Get the statistics of the cache shared by all the hips tiles.
+ */
+void hips_get_cache_stats(cache_stats_t *stats);
+
 /*
  * Function: hips_parse_date
  * Parse a date in the format supported for HiPS property files
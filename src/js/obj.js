@@ -47,11 +47,19 @@ Module.afterInit(function() {
   let g_obj_get_designations_callback = Module.addFunction(function(o, u, v) {
     g_ret.push(v);
   }, 'viii');
+  // Some modules create the objects while listing them, so we need to keep
+  // a reference until the filter is applied.
   let g_module_list_obj2 = Module.addFunction(function(user, obj) {
+    Module._obj_retain(obj);
     g_ret.push(obj);
     return 0;
   }, 'iii');
 
+  // Base types from obj_info.h.
+  const TYPE_FLOAT = 1;
+  const TYPE_INT = 2;
+  const TYPE_BOOL = 3;
+
   var SweObj = function(v) {
     assert(typeof(v) === 'number')
     this.v = v
@@ -65,10 +73,35 @@ Module.afterInit(function() {
       let attr = g_ret[i][0];
       let isProp = g_ret[i][1];
       let name = Module.UTF8ToString(attr);
+      // Attribute handle, and base type if we can access it directly.
+      let handle = Module._obj_get_attr_(this.v, attr);
+      let type = Module._obj_attr_get_direct_type(handle);
       if (!isProp) {
         that[name] = function(args) {
           return that._call(name, args);
         };
+      } else if (type === TYPE_FLOAT || type === TYPE_INT ||
+                 type === TYPE_BOOL) {
+        // Plain number or boolean member: skip the json conversions.
+        Object.defineProperty(that, name, {
+          configurable: true,
+          enumerable: true,
+          get: function() {
+            let v = Module._obj_attr_get_number(that.v, handle);
+            if (type === TYPE_BOOL) return v !== 0;
+            return isNaN(v) ? null : v;
+          },
+          set: function(v) {
+            // Let the json path convert or reject anything else, so that
+            // null doesn't become 0 and NaN never reaches the C side.
+            if ((typeof v === 'number' && isFinite(v)) ||
+                typeof v === 'boolean') {
+              Module._obj_attr_set_number(that.v, handle, Number(v));
+            } else {
+              that._call(name, v);
+            }
+          },
+        })
       } else {
         Object.defineProperty(that, name, {
           configurable: true,
@@ -216,8 +249,9 @@ Module.afterInit(function() {
     for (let i = 0; i < g_ret.length; i++) {
       let obj = new SweObj(g_ret[i]);
       if (filter(obj)) {
-        obj.retain();
         ret.push(obj);
+      } else {
+        obj.destroy();
       }
     }
     return ret;
@@ -383,6 +417,8 @@ Module.afterInit(function() {
     return ret;
   }
 
+  // Called once per frame for each attribute that changed, from
+  // module_flush_changes.
   var onObjChanged = Module.addFunction(function(objPtr, attr) {
     attr = Module.UTF8ToString(attr);
     for (var i = 0; i < g_listeners.length; i++) {
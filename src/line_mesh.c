@@ -9,10 +9,12 @@
 
 #include "line_mesh.h"
 
+#include "utils/utils.h"
 #include "utils/vec.h"
 
 #include <float.h>
 #include <stdlib.h>
+#include <string.h>
 
 static void line_get_normal(const double (*line)[3], int size, int i,
                             double n[2])
@@ -91,66 +93,100 @@ static double line_point_dist(const double a[2], const double b[2],
     return vec2_cross(ap, u) / vec2_norm(u);
 }
 
-static void line_push_point(double (**line)[3], const double p[3],
-                            int *size, int *allocated)
+// Reserve space for n more points in the tesselator arena.
+static void tesselator_reserve(line_tesselator_t *tess, int n)
 {
-    if (*size <= *allocated) {
-        *allocated += 4;
-        *line = realloc(*line, *allocated * sizeof(**line));
-    }
-    memcpy((*line)[(*size)++], p, sizeof(**line));
+    if (tess->nb + n <= tess->allocated) return;
+    tess->allocated = max(max(64, tess->allocated * 2), tess->nb + n);
+    tess->points = realloc(tess->points,
+                           tess->allocated * sizeof(*tess->points));
+}
+
+static void tesselator_push(line_tesselator_t *tess, const double p[3])
+{
+    tesselator_reserve(tess, 1);
+    vec3_copy(p, tess->points[tess->nb]);
+    tess->nb++;
 }
 
-static void line_tesselate_(void (*func)(void *user, double t, double pos[4]),
-                            const projection_t *proj,
-                            void *user, double t0, double t1,
-                            double (**out)[3],
-                            int level, int *size, int *allocated)
+static void tesselator_eval(line_tesselator_t *tess,
+                            void (*func)(void *user, double t, double pos[4]),
+                            const projection_t *proj, void *user,
+                            double t, double p[4])
 {
-    double p0[4], p1[4], pm[4], tm;
+    func(user, t, p);
+    project(proj, PROJ_TO_WINDOW_SPACE, p, p);
+    tess->nb_evals++;
+}
+
+/*
+ * Adaptive subdivision of the [t0, t1] interval.  The end points are passed
+ * already evaluated and projected, so that each sample is only computed
+ * once: one evaluation per node for the middle point.
+ */
+static void line_tesselate_(line_tesselator_t *tess,
+                            void (*func)(void *user, double t, double pos[4]),
+                            const projection_t *proj, void *user,
+                            double t0, const double p0[4],
+                            double t1, const double p1[4],
+                            int level)
+{
+    double pm[4], tm;
     const double max_dist = 1.0;
     const int max_level = 4;
-    tm = (t0 + t1) / 2;
-
-    func(user, t0, p0);
-    func(user, t1, p1);
-    func(user, tm, pm);
 
-    project(proj, PROJ_TO_WINDOW_SPACE, p0, p0);
-    project(proj, PROJ_TO_WINDOW_SPACE, p1, p1);
-    project(proj, PROJ_TO_WINDOW_SPACE, pm, pm);
+    tm = (t0 + t1) / 2;
+    tesselator_eval(tess, func, proj, user, tm, pm);
 
     if (level > max_level || line_point_dist(p0, p1, pm) < max_dist) {
-        line_push_point(out, p1, size, allocated);
+        tesselator_push(tess, p1);
         return;
     }
 
-    line_tesselate_(func, proj, user, t0, tm, out, level + 1, size, allocated);
-    line_tesselate_(func, proj, user, tm, t1, out, level + 1, size, allocated);
+    line_tesselate_(tess, func, proj, user, t0, p0, tm, pm, level + 1);
+    line_tesselate_(tess, func, proj, user, tm, pm, t1, p1, level + 1);
 }
 
-
-int line_tesselate(void (*func)(void *user, double t, double pos[4]),
-                   const projection_t *proj,
-                   void *user, int split, double (**out)[3])
+int line_tesselator_add(line_tesselator_t *tess,
+                        void (*func)(void *user, double t, double pos[4]),
+                        const projection_t *proj,
+                        void *user, int split, int *ofs)
 {
-    int i, allocated = 0, size = 0;
-    *out = NULL;
-    double p[4];
+    int i;
+    double p0[4], p1[4];
 
+    *ofs = tess->nb;
     if (split) {
-        size = split + 1;
-        *out = calloc(size, sizeof(**out));
-        for (i = 0; i < size; i++) {
-            func(user, (double)i / split, p);
-            project(proj, PROJ_TO_WINDOW_SPACE, p, p);
-            vec3_copy(p, (*out)[i]);
+        tesselator_reserve(tess, split + 1);
+        for (i = 0; i <= split; i++) {
+            tesselator_eval(tess, func, proj, user, (double)i / split, p0);
+            tesselator_push(tess, p0);
         }
     } else {
-        func(user, 0, p);
-        project(proj, PROJ_TO_WINDOW_SPACE, p, p);
-        line_push_point(out, p, &size, &allocated);
-        line_tesselate_(func, proj, user, 0, 1, out, 0, &size, &allocated);
+        tesselator_eval(tess, func, proj, user, 0, p0);
+        tesselator_eval(tess, func, proj, user, 1, p1);
+        tesselator_push(tess, p0);
+        line_tesselate_(tess, func, proj, user, 0, p0, 1, p1, 0);
     }
+    tess->nb_lines++;
+    tess->nb_points += tess->nb - *ofs;
+    return tess->nb - *ofs;
+}
+
+void line_tesselator_release(line_tesselator_t *tess)
+{
+    free(tess->points);
+    memset(tess, 0, sizeof(*tess));
+}
+
+int line_tesselate(void (*func)(void *user, double t, double pos[4]),
+                   const projection_t *proj,
+                   void *user, int split, double (**out)[3])
+{
+    line_tesselator_t tess = {};
+    int size, ofs;
+
+    size = line_tesselator_add(&tess, func, proj, user, split, &ofs);
+    *out = tess.points;
     return size;
 }
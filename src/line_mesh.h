@@ -57,6 +57,59 @@ line_mesh_t *line_to_mesh(const double (*line)[3], int size, double width);
  */
 void line_mesh_delete(line_mesh_t *mesh);
 
+/*
+ * Type: line_tesselator_t
+ * Scratch arena for the tesselation of parametric lines.
+ *
+ * The points of all the lines added with <line_tesselator_add> are appended
+ * to the same buffer, that only grows, so that we can tesselate many lines
+ * without any allocation once the buffer is large enough.  The points of a
+ * line can be dropped by setting nb back to the line offset.
+ *
+ * The counters can be used to tune the tesselation error threshold.
+ */
+typedef struct line_tesselator
+{
+    double (*points)[3];    // Points in windows coordinates + depth.
+    int nb;
+    int allocated;
+
+    uint64_t nb_lines;      // Number of tesselated lines.
+    uint64_t nb_points;     // Number of output points.
+    uint64_t nb_evals;      // Number of evaluated and projected samples.
+} line_tesselator_t;
+
+/*
+ * Function: line_tesselator_add
+ * Cut a parametric line into a list of points, appended to an arena.
+ *
+ * With the adaptive algorithm, each sample is only evaluated and projected
+ * once.
+ *
+ * Parameters:
+ *   tess   - A tesselator.
+ *   func   - Parametric line function.  The t argument ranges from 0 to 1.
+ *            Return a 4d homogenous position in view frame.
+ *   proj   - Screen projection.
+ *   user   - User data passed to the function.
+ *   split  - Number of segments requested in the output.  If set to 0 use
+ *            an adaptive algorithm.
+ *   ofs    - Output index of the first point of the line in tess->points.
+ *
+ * Return:
+ *   The number of points in the line.
+ */
+int line_tesselator_add(line_tesselator_t *tess,
+                        void (*func)(void *user, double t, double pos[4]),
+                        const projection_t *proj,
+                        void *user, int split, int *ofs);
+
+/*
+ * Function: line_tesselator_release
+ * Release the memory of a tesselator.
+ */
+void line_tesselator_release(line_tesselator_t *tess);
+
 /*
  * Function: line_tesselate
  * Cut a parametric line into a list of points.
@@ -11,6 +11,21 @@
 
 static void (*g_listener)(obj_t *module, const char *attr) = NULL;
 
+// Pending change notifications, sent to the listener by
+// module_flush_changes.
+typedef struct change {
+    UT_hash_handle hh;  // Hash of (module, attr).
+    obj_t *module;
+    char attr[64];      // Zero padded, so that we can use it in the key.
+} change_t;
+
+// Length of the (module, attr) key of a change.
+#define CHANGE_KEY_LEN \
+    (offsetof(change_t, attr) + sizeof(((change_t*)0)->attr) - \
+     offsetof(change_t, module))
+
+static change_t *g_changes = NULL;
+
 EMSCRIPTEN_KEEPALIVE
 int module_update(obj_t *module, double dt)
 {
@@ -135,8 +150,40 @@ void module_add_global_listener(void (*f)(obj_t *module, const char *attr))
 
 void module_changed(obj_t *module, const char *attr)
 {
-    if (g_listener)
-        g_listener(module, attr);
+    change_t key = {}, *change;
+
+    if (!g_listener) return;
+    assert(strlen(attr) < sizeof(key.attr));
+    key.module = module;
+    strncpy(key.attr, attr, sizeof(key.attr) - 1);
+    HASH_FIND(hh, g_changes, &key.module, CHANGE_KEY_LEN, change);
+    if (change) return;
+
+    change = calloc(1, sizeof(*change));
+    // Keep the module alive until we send the notification.
+    change->module = obj_retain(module);
+    memcpy(change->attr, key.attr, sizeof(change->attr));
+    HASH_ADD(hh, g_changes, module, CHANGE_KEY_LEN, change);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void module_flush_changes(void)
+{
+    change_t *changes, *change, *tmp;
+
+    // The listener can change more attributes, so we detach the hash
+    // first.  The new changes will be sent at the next flush.
+    changes = g_changes;
+    g_changes = NULL;
+
+    // Note: uthash iterates in insertion order.
+    HASH_ITER(hh, changes, change, tmp) {
+        if (g_listener)
+            g_listener(change->module, change->attr);
+        HASH_DEL(changes, change);
+        obj_release(change->module);
+        free(change);
+    }
 }
 
 EMSCRIPTEN_KEEPALIVE
@@ -165,6 +212,7 @@ void module_remove(obj_t *parent, obj_t *child)
     assert(child->parent == parent);
     assert(parent);
     assert(child->ref > 0);
+    if (parent->klass->flags & OBJ_INDEXED) search_index_remove_obj(child);
     child->parent = NULL;
     DL_DELETE(parent->children, child);
     obj_release(child);
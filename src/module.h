@@ -105,9 +105,25 @@ void module_add_global_listener(void (*f)(obj_t *module, const char *attr));
  * Function: module_changed
  * Should be called by modules after they manually change one of their
  * attributes.
+ *
+ * The notification is not sent immediately: all the changes are coalesced
+ * and sent to the listener once per frame by <module_flush_changes>, at the
+ * end of <core_update>.  This means that changes made outside of
+ * <core_update> (for example from the javascript API or from
+ * <core_render>) are only delivered at the end of the next <core_update>.
  */
 void module_changed(obj_t *module, const char *attr);
 
+/*
+ * Function: module_flush_changes
+ * Send all the pending change notifications to the global listener.
+ *
+ * Each pair of module and attribute is only sent once, even if it changed
+ * several times since the last flush.  This is called at the end of
+ * <core_update>.
+ */
+void module_flush_changes(void);
+
 /*
  * Macro: MODULE_ITER
  * Iter all the children of a given module of a given type.
@@ -58,6 +58,11 @@ typedef struct {
     // Hints/labels magnitude offset
     double hints_mag_offset;
     bool   hints_visible;
+
+    // Set if the data source is a binary snapshot.  In that case the
+    // objects are only created when they get visible or are searched.
+    mpc_snapshot_t  snapshot;
+    comet_t         **snapshot_objs;
 } comets_t;
 
 // Static instance.
@@ -112,6 +117,7 @@ static void load_data(comets_t *comets, const char *data, int size)
         strncpy(comet->obj.type, orbit_type_to_otype(orbit_type), 4);
         snprintf(comet->name, sizeof(comet->name), "%s", desgn);
         comet->pvo[0][0] = NAN;
+        search_index_add_obj(&comet->obj);
         last_epoch = max(epoch, last_epoch);
     }
 
@@ -123,6 +129,89 @@ static void load_data(comets_t *comets, const char *data, int size)
           format_time(buf, last_epoch, 0, "YYYY-MM-DD"));
 }
 
+static void comet_set_from_snapshot(comet_t *comet,
+                                    const mpc_snapshot_t *snap, int idx)
+{
+    comet->num = snap->number[idx];
+    comet->h = snap->h[idx];
+    comet->g = snap->g[idx];
+    comet->orbit.d = snap->epoch[idx];
+    comet->orbit.i = snap->i[idx];
+    comet->orbit.o = snap->node[idx];
+    comet->orbit.w = snap->peri[idx];
+    comet->orbit.q = snap->a[idx];
+    comet->orbit.e = snap->e[idx];
+    memcpy(comet->obj.type, snap->otype[idx], 4);
+    snprintf(comet->name, sizeof(comet->name), "%s",
+             snap->strings + snap->name[idx]);
+    comet->pvo[0][0] = NAN;
+}
+
+// Return the object of a snapshot comet, creating it if needed.
+static comet_t *get_snapshot_obj(comets_t *comets, int idx)
+{
+    comet_t *comet = comets->snapshot_objs[idx];
+    if (comet) return comet;
+    comet = (void*)module_add_new(&comets->obj, "mpc_comet", NULL);
+    comet_set_from_snapshot(comet, &comets->snapshot, idx);
+    // Keep a reference, in case the object gets removed from the module.
+    comets->snapshot_objs[idx] = (void*)obj_retain(&comet->obj);
+    return comet;
+}
+
+static int on_snapshot_search(void *user, int idx, const char *dsgn)
+{
+    comets_t *comets = USER_GET(user, 0);
+    void *f_user = USER_GET(user, 1);
+    int (*f)(void *user, const char *dsgn, obj_t *obj) = USER_GET(user, 2);
+    return f(f_user, dsgn, &get_snapshot_obj(comets, idx)->obj);
+}
+
+static void snapshot_search(void *user, const char *key, bool prefix,
+                            void *f_user,
+                            int (*f)(void *f_user, const char *dsgn,
+                                     obj_t *obj))
+{
+    comets_t *comets = user;
+    mpc_snapshot_search(&comets->snapshot, key, prefix,
+                        USER_PASS(comets, f_user, f), on_snapshot_search);
+}
+
+static void load_snapshot(comets_t *comets, const char *data, int size)
+{
+    mpc_snapshot_t *snap = &comets->snapshot;
+    if (mpc_snapshot_open(snap, data, size) ||
+            snap->type != MPC_SNAPSHOT_COMETS) {
+        LOG_E("Invalid comets snapshot");
+        memset(snap, 0, sizeof(*snap));
+        return;
+    }
+    comets->snapshot_objs = calloc(snap->nb, sizeof(*comets->snapshot_objs));
+    search_index_add_source(comets, snapshot_search);
+    LOG_I("Loaded %d comets snapshot", snap->nb);
+}
+
+// Remove all the objects of the current data source.
+static void release_data(comets_t *comets)
+{
+    obj_t *child, *tmp;
+    int i;
+
+    DL_FOREACH_SAFE(comets->obj.children, child, tmp)
+        module_remove(&comets->obj, child);
+    comets->update_pos = 0;
+    if (comets->snapshot_objs) {
+        search_index_remove_source(comets, snapshot_search);
+        for (i = 0; i < comets->snapshot.nb; i++)
+            obj_release((void*)comets->snapshot_objs[i]);
+        free(comets->snapshot_objs);
+        comets->snapshot_objs = NULL;
+        memset(&comets->snapshot, 0, sizeof(comets->snapshot));
+        asset_release(comets->source_url);
+    }
+    comets->parsed = false;
+}
+
 static int comet_update(comet_t *comet, const observer_t *obs)
 {
     double a, p, n, ph[2][3], pv[2][3], or, sr, b, v, w, r, o, u, i;
@@ -359,11 +448,24 @@ static int comets_init(obj_t *obj, json_value *args)
     return 0;
 }
 
+static void comets_del(obj_t *obj)
+{
+    comets_t *comets = (comets_t*)obj;
+    release_data(comets);
+    free(comets->source_url);
+    regfree(&comets->search_reg);
+    g_comets = NULL;
+}
+
 static int comets_add_data_source(
         obj_t *obj, const char *url, const char *key)
 {
     comets_t *comets = (void*)obj;
     if (strcmp(key, "mpc_comets") != 0) return -1;
+    if (comets->source_url) {
+        release_data(comets);
+        free(comets->source_url);
+    }
     comets->source_url = strdup(url);
     return 0;
 }
@@ -384,14 +486,20 @@ static int comets_update(obj_t *obj, double dt)
     if (comets->parsed || !comets->source_url)
         return 0;
 
-    data = asset_get_data2(comets->source_url, ASSET_USED_ONCE, &size, &code);
+    data = asset_get_data(comets->source_url, &size, &code);
     if (!code) return 0; // Still loading.
     comets->parsed = true;
     if (!data) {
         LOG_E("Cannot load comets data: %s (%d)", comets->source_url, code);
         return 0;
     }
-    load_data(comets, data, size);
+    // The snapshot points directly into the data, so we keep it.
+    if (mpc_snapshot_is(data, size)) {
+        load_snapshot(comets, data, size);
+    } else {
+        load_data(comets, data, size);
+        asset_release(comets->source_url);
+    }
 
     // Make sure the search work.
     obj = core_search("NAME C/1995 O1 (Hale-Bopp)");
@@ -401,6 +509,38 @@ static int comets_update(obj_t *obj, double dt)
     return 0;
 }
 
+/*
+ * Render the snapshot comets that have been on screen, and test the
+ * visibility of the next ones.  We only create the objects of the comets
+ * that could be visible.
+ */
+static void render_snapshot(comets_t *comets, const painter_t *painter,
+                            int update_nb)
+{
+    const mpc_snapshot_t *snap = &comets->snapshot;
+    double max_vmag = painter->stars_limit_mag + 2.0 +
+                      comets->hints_mag_offset;
+    comet_t *child, *comet, tmp = {};
+    int i, idx;
+
+    MODULE_ITER(&comets->obj, child, "mpc_comet") {
+        if (child->on_screen) obj_render(&child->obj, painter);
+    }
+    for (i = 0; i < min(update_nb, snap->nb); i++) {
+        idx = (comets->update_pos + i) % snap->nb;
+        comet = comets->snapshot_objs[idx];
+        if (comet && comet->on_screen) continue; // Already rendered.
+        if (!comet) {
+            comet_set_from_snapshot(&tmp, snap, idx);
+            comet_update(&tmp, painter->obs);
+            if (tmp.vmag > max_vmag) continue;
+            comet = get_snapshot_obj(comets, idx);
+        }
+        obj_render(&comet->obj, painter);
+    }
+    if (snap->nb) comets->update_pos = (comets->update_pos + i) % snap->nb;
+}
+
 static int comets_render(const obj_t *obj, const painter_t *painter)
 {
     PROFILE(comets_render, 0);
@@ -411,6 +551,10 @@ static int comets_render(const obj_t *obj, const painter_t *painter)
     int nb, i;
 
     if (!comets->visible) return 0;
+    if (comets->snapshot.nb) {
+        render_snapshot(comets, painter, update_nb);
+        return 0;
+    }
     /* To prevent spending too much time computing position of comets that
      * are not visible, we only render a small number of them at each
      * frame, using a moving range.  The comets who have been flagged as
@@ -429,6 +573,32 @@ static int comets_render(const obj_t *obj, const painter_t *painter)
     return 0;
 }
 
+static int comets_list(const obj_t *obj,
+                       double max_mag, uint64_t hint, const char *source,
+                       void *user, int (*f)(void *user, obj_t *obj))
+{
+    comets_t *comets = (void*)obj;
+    comet_t tmp = {};
+    obj_t *child;
+    int i;
+
+    // With a snapshot, we only create the objects bright enough to be
+    // listed.
+    for (i = 0; i < comets->snapshot.nb; i++) {
+        if (!isnan(max_mag)) {
+            comet_set_from_snapshot(&tmp, &comets->snapshot, i);
+            comet_update(&tmp, core->observer);
+            if (tmp.vmag > max_mag) continue;
+        }
+        if (f(user, &get_snapshot_obj(comets, i)->obj)) return 0;
+    }
+    if (comets->snapshot.nb) return 0;
+    DL_FOREACH(obj->children, child) {
+        if (f(user, child)) break;
+    }
+    return 0;
+}
+
 /*
  * Meta class declarations.
  */
@@ -445,11 +615,14 @@ OBJ_REGISTER(comet_klass)
 static obj_klass_t comets_klass = {
     .id             = "comets",
     .size           = sizeof(comets_t),
-    .flags          = OBJ_IN_JSON_TREE | OBJ_MODULE | OBJ_LISTABLE,
+    .flags          = OBJ_IN_JSON_TREE | OBJ_MODULE | OBJ_LISTABLE |
+                      OBJ_INDEXED,
     .init           = comets_init,
+    .del            = comets_del,
     .add_data_source = comets_add_data_source,
     .update         = comets_update,
     .render         = comets_render,
+    .list           = comets_list,
     .render_order   = 20,
     .attributes     = (attribute_t[]) {
         PROPERTY(visible, TYPE_BOOL, MEMBER(comets_t, visible)),
@@ -20,6 +20,9 @@
 
 static obj_klass_t dso_klass;
 
+typedef struct tile tile_t;
+typedef struct survey survey_t;
+
 /*
  * Type: dso_quick_data_t
  * Holds information used for clipping a DSO entry when rendering
@@ -55,22 +58,34 @@ typedef struct {
     // List of extra names, separated by '\0', terminated by two '\0'.
     char *names;
     float  vmag;
+
+    // For the objects created with tile_get_dso: the tile and index of
+    // the source.  The tile is pinned in the cache as long as the object
+    // exists, since we share its strings.
+    tile_t      *tile;
+    int         idx;
 } dso_t;
 
 /*
  * Type: tile_t
  * Custom tile structure for the dso HiPS survey.
+ *
+ * The dso_t objects are only created on demand with <tile_get_dso>, for
+ * example when a DSO gets selected or labeled.
  */
-typedef struct tile {
+struct tile {
     int         flags;
     double      mag_min;
     double      mag_max;
     int         nb;
     dso_t       *sources;
     dso_clip_data_t *sources_quick;
-} tile_t;
+    dso_t       **objs;     // Lazily created objects, can be NULL.
+    survey_t    *survey;
+    int         order;
+    int         pix;
+};
 
-typedef struct survey survey_t;
 struct survey {
     char key[128];
     int idx;
@@ -201,21 +216,78 @@ static int dso_init(obj_t *obj, json_value *args)
     return 0;
 }
 
+/*
+ * Function: tile_get_dso
+ * Return a new reference to the object of a DSO in a tile.
+ *
+ * The object is created the first time, and pins the tile in the hips
+ * cache until it gets deleted.
+ */
+static dso_t *tile_get_dso(tile_t *tile, int i)
+{
+    dso_t *dso;
+
+    assert(i >= 0 && i < tile->nb);
+    if (!tile->objs) tile->objs = calloc(tile->nb, sizeof(*tile->objs));
+    if (tile->objs[i]) return (dso_t*)obj_retain(&tile->objs[i]->obj);
+
+    if (!hips_pin_tile(tile->survey->hips, tile->order, tile->pix))
+        return NULL;
+    dso = malloc(sizeof(*dso));
+    *dso = tile->sources[i];
+    dso->obj.ref = 1;
+    dso->tile = tile;
+    dso->idx = i;
+    tile->objs[i] = dso;
+    return dso;
+}
+
+// Return the object of a DSO in a tile if it has already been created.
+static const obj_t *tile_peek_dso(const tile_t *tile, int i)
+{
+    return (tile->objs && tile->objs[i]) ? &tile->objs[i]->obj : NULL;
+}
+
+static void dso_del(obj_t *obj)
+{
+    dso_t *dso = (dso_t*)obj;
+    tile_t *tile = dso->tile;
+    if (!tile) return;
+    tile->objs[dso->idx] = NULL;
+    hips_unpin_tile(tile->survey->hips, tile->order, tile->pix);
+}
+
+/*
+ * Return a new reference to a rendered DSO, from its survey and the id
+ * set in render_visitor (tile nuniq and DSO index).
+ *
+ * Only called when the DSO gets picked.
+ */
+static obj_t *get_rendered_dso(void *user, uint64_t id)
+{
+    survey_t *survey = user;
+    int order, pix, code, i = id & 0xffffffff;
+    tile_t *tile;
+
+    nuniq_to_pix(id >> 32, &order, &pix);
+    tile = hips_get_tile(survey->hips, order, pix, HIPS_CACHED_ONLY, &code);
+    if (!tile || i >= tile->nb) return NULL;
+    return (obj_t*)tile_get_dso(tile, i);
+}
+
 // Used by the cache.
 static int del_tile(void *data)
 {
     int i;
     tile_t *tile = data;
 
-    // Don't delete the tile if any contained dso is used somehwere else.
-    for (i = 0; i < tile->nb; i++) {
-        if (tile->sources[i].obj.ref > 1) return CACHE_KEEP;
-    }
-
+    // The tiles are pinned as long as their objects exist, so at this point
+    // they have all been deleted.
     for (i = 0; i < tile->nb; i++) {
         free(tile->sources[i].names);
         free(tile->sources[i].morpho);
     }
+    free(tile->objs);
     free(tile->sources);
     free(tile->sources_quick);
     free(tile);
@@ -352,7 +424,11 @@ static const void *dsos_create_tile(void *user, int order, int pix, void *data,
     survey_t *survey = user;
     eph_load(data, size, USER_PASS(survey, &tile, transparency),
              on_file_tile_loaded);
-    if (tile) *cost = tile->nb * sizeof(*tile->sources);
+    if (!tile) return NULL;
+    tile->survey = survey;
+    tile->order = order;
+    tile->pix = pix;
+    *cost = tile->nb * sizeof(*tile->sources);
     return tile;
 }
 
@@ -454,12 +530,12 @@ static bool dso_get_short_name(const dso_t *s, char *out, int size)
 }
 
 
-static void dso_render_label(const dso_t *s,
-                             const painter_t *painter,
+static void dso_render_label(const dso_t *s, tile_t *tile, int idx,
+                             const painter_t *painter, bool selected,
                              const double win_size[2], double win_angle)
 {
-    const bool selected = (&s->obj == core->selection);
     int effects = 0;
+    dso_t *obj;
     double color[4], radius;
     char buf[128] = "";
     const float vmag = s->display_vmag;
@@ -476,22 +552,35 @@ static void dso_render_label(const dso_t *s,
                  fabs(win_size[0] / 2 - win_size[1] / 2);
     radius += 1;
     dso_get_short_name(s, buf, sizeof(buf));
-    if (buf[0]) {
-        labels_add_3d(buf, FRAME_ASTROM, s->bounding_cap, true, radius,
-                      FONT_SIZE_BASE - 2, color, 0, 0, effects,
-                      -vmag, &s->obj);
-    }
+    if (!buf[0]) return;
+    // The label keeps a reference to the object, so it only gets created
+    // the first time.
+    obj = tile ? tile_get_dso(tile, idx) : (dso_t*)obj_retain(&s->obj);
+    if (!obj) return;
+    labels_add_3d(buf, FRAME_ASTROM, s->bounding_cap, true, radius,
+                  FONT_SIZE_BASE - 2, color, 0, 0, effects,
+                  -vmag, &obj->obj);
+    obj_release(&obj->obj);
 }
 
 
-// Render a DSO from its data.
-static int dso_render_from_data(const dso_t *s,
-                                const painter_t *painter, uint64_t hint)
+/*
+ * Render a DSO from its data.
+ *
+ * Parameters:
+ *   s       - The DSO data.
+ *   tile    - The tile of the DSO, or NULL if s is an object.
+ *   idx     - Index of the DSO in the tile.
+ *   painter - The painter.
+ */
+static int dso_render_from_data(const dso_t *s, tile_t *tile, int idx,
+                                const painter_t *painter)
 {
     PROFILE(dso_render_from_data, PROFILE_AGGREGATE);
     double color[4];
     double win_pos[2], win_size[2], win_angle, hints_limit_mag;
-    const bool selected = (&s->obj == core->selection);
+    const obj_t *obj = tile ? tile_peek_dso(tile, idx) : &s->obj;
+    const bool selected = obj && obj == core->selection;
     double opacity;
     painter_t tmp_painter;
     const float vmag = s->display_vmag;
@@ -537,8 +626,16 @@ static int dso_render_from_data(const dso_t *s,
                                      max(win_size[0], win_size[1]) / 2))
         return 0;
 
-    areas_add_ellipse(core->areas, win_pos, win_angle,
-                      win_size[0] / 2, win_size[1] / 2, &s->obj);
+    if (tile) {
+        areas_add_ellipse_lazy(core->areas, win_pos, win_angle,
+                               win_size[0] / 2, win_size[1] / 2,
+                               get_rendered_dso, tile->survey,
+                               pix_to_nuniq(tile->order, tile->pix) << 32 |
+                               idx);
+    } else {
+        areas_add_ellipse(core->areas, win_pos, win_angle,
+                          win_size[0] / 2, win_size[1] / 2, (obj_t*)obj);
+    }
 
     // Don't display when DSO global fader is off
     // But the previous steps are still necessary as we want to be able to
@@ -574,7 +671,8 @@ static int dso_render_from_data(const dso_t *s,
     }
 
     if (vmag <= hints_limit_mag - 1.) {
-        dso_render_label(s, painter, win_size, win_angle);
+        dso_render_label(s, tile, idx, painter, selected, win_size,
+                         win_angle);
     }
     return 0;
 }
@@ -582,7 +680,7 @@ static int dso_render_from_data(const dso_t *s,
 static int dso_render(const obj_t *obj, const painter_t *painter)
 {
     const dso_t *dso = (const dso_t*)obj;
-    return dso_render_from_data(dso, painter, 0);
+    return dso_render_from_data(dso, NULL, 0, painter);
 }
 
 void dso_get_designations(
@@ -606,7 +704,6 @@ static int render_visitor(int order, int pix, void *user)
     survey_t *survey = USER_GET(user, 4);
     tile_t *tile;
     int i, ret, code;
-    uint64_t hint;
 
     // Early exit if the tile is clipped.
     if (painter_is_healpix_clipped(&painter, FRAME_ICRF, order, pix, true))
@@ -619,9 +716,8 @@ static int render_visitor(int order, int pix, void *user)
     if (!tile) return 0;
     if (tile->mag_min > painter.stars_limit_mag + 1.5) return 0;
 
-    hint = pix_to_nuniq(order, pix);
     for (i = 0; i < tile->nb; i++) {
-        ret = dso_render_from_data(&tile->sources[i], &painter, hint);
+        ret = dso_render_from_data(&tile->sources[i], tile, i, &painter);
         if (ret)
             break;
     }
@@ -652,6 +748,19 @@ static int dsos_render(const obj_t *obj, const painter_t *painter_)
     return 0;
 }
 
+// Pass the object of a DSO in a tile to a list callback.
+static int list_dso(tile_t *tile, int i, void *user,
+                    int (*f)(void *user, obj_t *obj))
+{
+    dso_t *dso;
+    int r;
+    dso = tile_get_dso(tile, i);
+    if (!dso) return 0;
+    r = f(user, &dso->obj);
+    obj_release(&dso->obj);
+    return r;
+}
+
 static int dsos_list(const obj_t *obj,
                      double max_mag, uint64_t hint, const char *source,
                      void *user, int (*f)(void *user, obj_t *obj))
@@ -675,22 +784,29 @@ static int dsos_list(const obj_t *obj,
     if (!survey) survey = dsos->surveys;
     if (!survey) return 0;
 
+    // Note: the objects are created on demand, and deleted after the
+    // callback unless it kept a reference to them.
+
     // Without hint, we have to iter all the tiles.
     if (!hint) {
         hips_iter_init(&iter);
         while (hips_iter_next(&iter, &order, &pix)) {
             tile = get_tile(dsos, survey, order, pix, false, &code);
-            if (!tile && !code) return MODULE_AGAIN;
+            if (!tile && !code) {
+                hips_iter_release(&iter);
+                return MODULE_AGAIN;
+            }
             if (!tile || tile->mag_min >= max_mag) continue;
             for (i = 0; i < tile->nb; i++) {
                 vmag = tile->sources[i].vmag;
                 if (!isnan(vmag) && vmag > max_mag) continue;
-                r = f(user, &tile->sources[i].obj);
+                r = list_dso(tile, i, user, f);
                 if (r) break;
             }
             if (i < tile->nb) break;
             hips_iter_push_children(&iter, order, pix);
         }
+        hips_iter_release(&iter);
         return 0;
     }
 
@@ -702,7 +818,7 @@ static int dsos_list(const obj_t *obj,
         return -1;
     }
     for (i = 0; i < tile->nb; i++) {
-        r = f(user, &tile->sources[i].obj);
+        r = list_dso(tile, i, user, f);
         if (r) break;
     }
     return 0;
@@ -736,6 +852,7 @@ static obj_klass_t dso_klass = {
     .id = "dso",
     .size = sizeof(dso_t),
     .init = dso_init,
+    .del = dso_del,
     .get_json_data = dso_get_json_data,
     .get_info = dso_get_info,
     .render = dso_render,
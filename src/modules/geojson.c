@@ -517,6 +517,7 @@ int geojson_survey_query_rendered_features(
                                        tiles + nb, index + nb);
         if (nb >= max_ret) break;
     }
+    hips_iter_release(&iter);
     return nb;
 }
 
@@ -641,6 +642,7 @@ static int survey_render(const obj_t *obj, const painter_t *painter)
         if (!tile) continue;
         image_render((obj_t*)tile, painter);
     }
+    hips_iter_release(&iter);
 
     progressbar_report(survey->hips->url, survey->hips->label,
                        nb_loaded, nb_tot, -1);
@@ -9,13 +9,35 @@
 
 #include "swe.h"
 
+/*
+ * The visible labels are put in a screen grid of GRID_CELL pixels cells so
+ * that we only test the overlaps with the labels in the same cells.  The
+ * cells are stored in a hash table of GRID_BUCKETS buckets.  Labels covering
+ * too many cells are put in a separate list that is always tested.
+ */
+#define GRID_CELL 64
+#define GRID_BUCKETS 256
+#define GRID_MAX_CELLS 16
+#define GRID_MAX 1e6
+
+/*
+ * Key used to find the label of a given object and text.
+ * The text directly follows this header in memory.
+ */
+typedef struct {
+    const obj_t *obj;
+    double      size;
+} label_key_t;
 
 typedef struct label label_t;
 struct label
 {
     label_t *next, *prev;
+    UT_hash_handle hh;    // Hash of (obj, size, text).
+    label_key_t *key;     // Key of the hash, also contains the text.
+    int     key_len;
     obj_t   *obj;         // Optional object.
-    char    *text;        // Original passed text.
+    char    *text;        // Original passed text (points into key).
     char    *render_text; // Processed text (can point to text).
     double  pos[3];       // 3D position in the given frame.
     double  win_pos[2];   // 2D position on screen (px).
@@ -34,9 +56,25 @@ struct label
     double  bounds[4];
 };
 
+typedef struct {
+    label_t *label;
+    int     cell[2];
+    int     next; // Next entry in the bucket, or -1.
+} grid_entry_t;
+
 typedef struct labels {
     obj_t obj;
     label_t *labels;
+    label_t *map; // Hash table of all the labels.
+
+    // Grid of the labels already placed during the current render.
+    struct {
+        int buckets[GRID_BUCKETS];
+        int large; // List of the labels too large for the grid.
+        grid_entry_t *entries;
+        int nb;
+        int allocated;
+    } grid;
 } labels_t;
 
 static labels_t *g_labels = NULL;
@@ -47,8 +85,9 @@ void labels_reset(void)
     DL_FOREACH_SAFE(g_labels->labels, label, tmp) {
         if (label->fader.target == false && label->fader.value == 0) {
             DL_DELETE(g_labels->labels, label);
+            HASH_DEL(g_labels->map, label);
             if (label->render_text != label->text) free(label->render_text);
-            free(label->text);
+            free(label->key);
             obj_release(label->obj);
             free(label);
         } else {
@@ -58,16 +97,52 @@ void labels_reset(void)
     }
 }
 
-static label_t *label_get(label_t *list, const char *txt, double size,
-                          const obj_t *obj)
+// Create a label key.  The returned value should be freed by the caller.
+static label_key_t *label_create_key(const char *txt, double size,
+                                     const obj_t *obj, int *len)
+{
+    label_key_t *key;
+    *len = sizeof(*key) + strlen(txt) + 1;
+    // Use calloc so that the padding bytes are set to zero.
+    key = calloc(1, *len);
+    key->obj = obj;
+    key->size = size;
+    strcpy((char*)(key + 1), txt);
+    return key;
+}
+
+static label_t *label_get_slow(const char *txt, double size,
+                               const obj_t *obj)
 {
     label_t *label;
-    DL_FOREACH(list, label) {
-        if (obj != label->obj) continue;
-        if (label->size == size && strcmp(txt, label->text) == 0)
-            return label;
-    }
-    return NULL;
+    label_key_t *key;
+    int len;
+    key = label_create_key(txt, size, obj, &len);
+    HASH_FIND(hh, g_labels->map, key, len, label);
+    free(key);
+    return label;
+}
+
+// Find the label of a given text, size and object.  The lookup key is
+// built on the stack, except for very long texts.
+static label_t *label_get(const char *txt, double size, const obj_t *obj)
+{
+    label_t *label;
+    union {
+        label_key_t key;
+        char        buf[256];
+    } tmp;
+    label_key_t *key = &tmp.key;
+    int len = sizeof(*key) + strlen(txt) + 1;
+
+    if (len > sizeof(tmp)) return label_get_slow(txt, size, obj);
+    // Zero the header so that the padding bytes match the stored keys.
+    memset(key, 0, sizeof(*key));
+    key->obj = obj;
+    key->size = size;
+    strcpy((char*)(key + 1), txt);
+    HASH_FIND(hh, g_labels->map, key, len, label);
+    return label;
 }
 
 static void label_get_bounds(const painter_t *painter, const label_t *label,
@@ -121,21 +196,99 @@ static double bounds_dist_point(const double rect[4], const double p[2])
     return sqrt(dx * dx + dy * dy);
 }
 
-static double test_label_overlaps(const label_t *label)
+static double label_overlap(const label_t *label, const label_t *other)
 {
-    label_t *other;
-    double ret = 0, overlap;
     double inter[4];
+    if (!bounds_intersection(label->bounds, other->bounds, inter))
+        return 0.0;
+    return max(inter[2] - inter[0], inter[3] - inter[1]);
+}
+
+// Compute the range of cells covered by some bounds.
+// Return false if the bounds are too large to be put in the grid.
+static bool grid_get_cells(const double bounds[4], int cells[4])
+{
+    int i;
+    for (i = 0; i < 4; i++) {
+        if (!(fabs(bounds[i]) < GRID_MAX)) return false;
+        cells[i] = (int)floor(bounds[i] / GRID_CELL);
+    }
+    return (cells[2] - cells[0] + 1) * (cells[3] - cells[1] + 1) <=
+            GRID_MAX_CELLS;
+}
+
+static int grid_get_bucket(int x, int y)
+{
+    return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u) %
+            GRID_BUCKETS;
+}
+
+static void grid_clear(void)
+{
+    memset(g_labels->grid.buckets, 0xff, sizeof(g_labels->grid.buckets));
+    g_labels->grid.large = -1;
+    g_labels->grid.nb = 0;
+}
+
+static void grid_add_entry(label_t *label, int x, int y, int *head)
+{
+    grid_entry_t *entry;
+    if (g_labels->grid.nb >= g_labels->grid.allocated) {
+        g_labels->grid.allocated = max(64, g_labels->grid.allocated * 2);
+        g_labels->grid.entries = realloc(g_labels->grid.entries,
+                g_labels->grid.allocated * sizeof(*g_labels->grid.entries));
+    }
+    entry = &g_labels->grid.entries[g_labels->grid.nb];
+    entry->label = label;
+    entry->cell[0] = x;
+    entry->cell[1] = y;
+    entry->next = *head;
+    *head = g_labels->grid.nb++;
+}
+
+static void grid_add(label_t *label)
+{
+    int x, y, cells[4];
+    if (!grid_get_cells(label->bounds, cells)) {
+        grid_add_entry(label, 0, 0, &g_labels->grid.large);
+        return;
+    }
+    for (y = cells[1]; y <= cells[3]; y++)
+    for (x = cells[0]; x <= cells[2]; x++) {
+        grid_add_entry(label, x, y,
+                       &g_labels->grid.buckets[grid_get_bucket(x, y)]);
+    }
+}
+
+/*
+ * Return the max overlap of a label with the labels already placed in the
+ * grid, that is all the visible labels with a higher priority.
+ */
+static double test_label_overlaps(const label_t *label)
+{
+    const grid_entry_t *entries = g_labels->grid.entries;
+    double ret = 0;
+    int i, x, y, cells[4];
 
     if (!(label->effects & TEXT_FLOAT)) return 0.0;
-    DL_FOREACH(g_labels->labels, other) {
-        if (other == label) break;
-        if (other->fader.target == false) continue;
-        if (!bounds_intersection(label->bounds, other->bounds, inter))
-            continue;
-        overlap = max(inter[2] - inter[0], inter[3] - inter[1]);
-        if (overlap > ret)
-            ret = overlap;
+
+    if (!grid_get_cells(label->bounds, cells)) {
+        for (i = 0; i < g_labels->grid.nb; i++)
+            ret = max(ret, label_overlap(label, entries[i].label));
+        return ret;
+    }
+
+    for (i = g_labels->grid.large; i != -1; i = entries[i].next)
+        ret = max(ret, label_overlap(label, entries[i].label));
+    for (y = cells[1]; y <= cells[3]; y++)
+    for (x = cells[0]; x <= cells[2]; x++) {
+        for (i = g_labels->grid.buckets[grid_get_bucket(x, y)]; i != -1;
+             i = entries[i].next) {
+            // Skip the entries of other cells sharing the same bucket.
+            if (entries[i].cell[0] != x || entries[i].cell[1] != y)
+                continue;
+            ret = max(ret, label_overlap(label, entries[i].label));
+        }
     }
     return ret;
 }
@@ -158,6 +311,7 @@ static int labels_render(const obj_t *obj, const painter_t *painter)
     const double max_overlap = 8;
 
     DL_SORT(g_labels->labels, label_cmp);
+    grid_clear();
     DL_FOREACH(g_labels->labels, label) {
         // Re-project label on screen
         if (label->frame != -1) {
@@ -168,6 +322,7 @@ static int labels_render(const obj_t *obj, const painter_t *painter)
                          label->bounds);
         label->fader.target = label->active &&
                                 (test_label_overlaps(label) <= max_overlap);
+        if (label->fader.target) grid_add(label);
         pos[0] = label->bounds[0];
         pos[1] = label->bounds[1];
         vec4_copy(label->color, color);
@@ -214,13 +369,16 @@ void labels_add_3d(const char *text, int frame, const double pos[3],
 
     if (!text || !*text) return;
 
-    label = label_get(g_labels->labels, text, size, obj);
+    label = label_get(text, size, obj);
     if (!label) {
         label = calloc(1, sizeof(*label));
         label->obj = obj_retain(obj);
         fader_init(&label->fader, false);
-        label->render_text = label->text = strdup(text);
+        label->key = label_create_key(text, size, obj, &label->key_len);
+        label->render_text = label->text = (char*)(label->key + 1);
         DL_APPEND(g_labels->labels, label);
+        HASH_ADD_KEYPTR(hh, g_labels->map, label->key, label->key_len,
+                        label);
     }
 
     if (frame == -1)
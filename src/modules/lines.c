@@ -149,6 +149,52 @@ static struct {
     },
 };
 
+// Size of the border labels.
+#define LABEL_TEXT_SIZE 12
+// Number of segments of each grid cell edge.
+#define EDGE_SPLIT 8
+// Max number of cells of a retained grid.  Finer grids are only rendered
+// with the recursion, that skips the clipped parts of the sphere.
+#define GRID_MAX_CELLS 4096
+
+/*
+ * Retained geometry of a grid at a given step level.
+ *
+ * The grid vertices only depend on the steps, so we compute them once in the
+ * frame of the line (before the line rotation).  Each frame we only have to
+ * rotate, clip and project them.
+ */
+typedef struct {
+    int     corners[4]; // Index of the cell corners in the grid verts.
+    int     edges[2];   // Index of the cell edges in the grid, or -1.
+} grid_cell_t;
+
+typedef struct {
+    double  lines[2][4];    // uv end points.
+    double  uv[2];          // uv of the first corner of the cell.
+    int     dir;
+    int     step;
+    double  samples[EDGE_SPLIT + 1][3];
+} grid_edge_t;
+
+typedef struct {
+    const step_t    *steps[2];
+    bool            skip_half;
+    int             nb_verts;
+    int             nb_cells;
+    int             nb_edges;
+    double          (*verts)[3];
+    grid_cell_t     *cells;
+    grid_edge_t     *edges;
+} grid_t;
+
+typedef struct {
+    char    text[32];
+    double  pos[2];
+    double  angle;
+    int     edge;   // Index of the edge in the visible edges.
+} grid_label_t;
+
 typedef struct lines lines_t;
 struct lines {
     obj_t       obj;
@@ -163,6 +209,12 @@ struct line {
     const char      *name;
     bool            grid;       // If true render the whole grid.
     double          color[4];
+
+    grid_t          *retained;  // Retained geometry of the last steps.
+    // Labels of the retained grid, recomputed only when the view changes.
+    uint32_t        labels_key;
+    int             nb_labels;
+    grid_label_t    *labels;
 };
 
 // Test if a shape in clipping coordinates is clipped or not.
@@ -347,7 +399,7 @@ static double segment_viewport_intersection(
  *   v      - Output of the normal of the window border at the intersection.
  *
  */
-static bool check_borders(const double a[3], const double b[3],
+static bool check_borders(const double a[4], const double b[4],
                           const projection_t *proj,
                           double p[2], // Window pos on the border.
                           double u[2], // Window direction of the line.
@@ -374,46 +426,56 @@ static bool check_borders(const double a[3], const double b[3],
 }
 
 
-static void spherical_project(
-        const uv_map_t *map, const double v[2], double out[4])
+// Position on the sphere of a grid uv coordinate, before the line rotation.
+static void uv_to_sphere(const double v[2], double out[3])
 {
-    const double (*rot)[3][3] = map->user;
     double az, al;
     az = v[0] * 360 * DD2R;
     al = (v[1] - 0.5) * 180 * DD2R;
     eraS2c(az, al, out);
+}
+
+static void spherical_project(
+        const uv_map_t *map, const double v[2], double out[4])
+{
+    const double (*rot)[3][3] = map->user;
+    uv_to_sphere(v, out);
     mat3_mul_vec3(*rot, out, out);
     out[3] = 0; // Project to infinity.
 }
 
 /*
- * Function: render_label
- * Render the border label
+ * Function: compute_label
+ * Compute the text and position of a border label
  *
  * Parameters:
  *   p      - Position of the border intersection.
  *   u      - Direction of the line.
  *   v      - Normal of the window border inward.
  *   dir    - 0: alt, 1: az
+ *   label  - Output label.
+ *
+ * Returns:
+ *   False if the label should not be rendered.
  */
-static void render_label(const double p[2], const double u[2],
-                         const double v[2], const double uv[2],
-                         int dir, line_t *line, int step,
-                         const painter_t *painter)
+static bool compute_label(const double p[2], const double u[2],
+                          const double v[2], const double uv[2],
+                          int dir, const line_t *line, int step,
+                          const painter_t *painter, grid_label_t *label)
 {
-    char buf[32];
-    double pos[2];
-    double a, color[4], label_angle;
+    char *buf = label->text;
+    const int buf_size = sizeof(label->text);
+    double *pos = label->pos;
+    double a, label_angle;
     char s;
     int h[4];
     double n[2];
     double bounds[4], size[2];
-    const double text_size = 12;
 
     vec2_normalize(u, n);
 
     // Give up if angle with screen is too acute.
-    if (fabs(vec2_dot(n, v)) < 0.25) return;
+    if (fabs(vec2_dot(n, v)) < 0.25) return false;
 
     if (vec2_dot(n, v) < 0) {
         vec2_mul(-1, u, u);
@@ -435,29 +497,29 @@ static void render_label(const double p[2], const double u[2],
         if (dir == 1 && s == '+')
             s = ' ';
         if (step <= 360)
-            snprintf(buf, sizeof(buf), "%c%d°", s, h[0]);
+            snprintf(buf, buf_size, "%c%d°", s, h[0]);
         else if (step <= 21600)
-            snprintf(buf, sizeof(buf), "%c%d°%02d'", s, h[0], h[1]);
+            snprintf(buf, buf_size, "%c%d°%02d'", s, h[0], h[1]);
         else
-            snprintf(buf, sizeof(buf), "%c%d°%02d'%02d\"", s, h[0], h[1], h[2]);
+            snprintf(buf, buf_size, "%c%d°%02d'%02d\"", s, h[0], h[1], h[2]);
     } else if (line->format == 'h') {
         eraA2tf(1, a, &s, h);
         if (s == '-')
             h[0] = -h[0];
         if (step <= 24)
-            snprintf(buf, sizeof(buf), "%dh", h[0]);
+            snprintf(buf, buf_size, "%dh", h[0]);
         else  if (step <= 1440)
-            snprintf(buf, sizeof(buf), "%dh%02d", h[0], h[1]);
+            snprintf(buf, buf_size, "%dh%02d", h[0], h[1]);
         else
-            snprintf(buf, sizeof(buf), "%dh%02dm%02ds", h[0], h[1], h[2]);
+            snprintf(buf, buf_size, "%dh%02dm%02ds", h[0], h[1], h[2]);
     } else if (line->format == 'n') {
-        snprintf(buf, sizeof(buf), "%s", sys_translate("gui", line->name));
+        snprintf(buf, buf_size, "%s", sys_translate("gui", line->name));
     } else {
         assert(false);
     }
 
     paint_text_bounds(painter, buf, p, ALIGN_CENTER | ALIGN_MIDDLE, 0,
-                      text_size, bounds);
+                      LABEL_TEXT_SIZE, bounds);
     size[0] = bounds[2] - bounds[0];
     size[1] = bounds[3] - bounds[1];
 
@@ -474,12 +536,28 @@ static void render_label(const double p[2], const double u[2],
     vec3_cross(n3, up, n3);
     pos[0] += n3[0] * size[1] / 2;
     pos[1] += n3[1] * size[1] / 2;
+    label->angle = label_angle;
+    return true;
+}
 
+static void paint_label(const grid_label_t *label, const painter_t *painter)
+{
+    double color[4];
     vec4_copy(painter->color, color);
-
     color[3] = 1.0;
-    paint_text(painter, buf, pos, ALIGN_CENTER | ALIGN_MIDDLE, 0,
-               text_size, color, label_angle);
+    paint_text(painter, label->text, label->pos,
+               ALIGN_CENTER | ALIGN_MIDDLE, 0, LABEL_TEXT_SIZE, color,
+               label->angle);
+}
+
+static void render_label(const double p[2], const double u[2],
+                         const double v[2], const double uv[2],
+                         int dir, const line_t *line, int step,
+                         const painter_t *painter)
+{
+    grid_label_t label;
+    if (compute_label(p, u, v, uv, dir, line, step, painter, &label))
+        paint_label(&label, painter);
 }
 
 /*
@@ -560,7 +638,7 @@ static void render_recursion(
                 (pos[1] == 0 || pos[1] == splits[1] - 1))
             continue;
 
-        paint_line(painter, line->frame, lines + dir * 2, &map, 8, 0);
+        paint_line(painter, line->frame, lines + dir * 2, &map, EDGE_SPLIT, 0);
         if (!line->format) continue;
         if (check_borders(pos_view[0], pos_view[2 - dir], painter->proj,
                           p, u, v)) {
@@ -586,6 +664,294 @@ keep_going:
     }
 }
 
+// Level of the recursion at which the lines are rendered.
+static int grid_get_level(const step_t *steps[2])
+{
+    return max(2, max(steps[0]->level, steps[1]->level));
+}
+
+// Index of a grid vertex, added the first time it is used by a cell.
+static int grid_get_vert(grid_t *grid, int *verts_idx, const int splits[2],
+                         int i, int j)
+{
+    int *idx = &verts_idx[j * (splits[0] + 1) + i];
+    if (*idx == -1) {
+        *idx = grid->nb_verts++;
+        uv_to_sphere(VEC((double)i / splits[0], (double)j / splits[1]),
+                     grid->verts[*idx]);
+    }
+    return *idx;
+}
+
+/*
+ * Add the cells of the grid that have edges to render, in the same order
+ * and with the same rules as render_recursion.
+ */
+static void grid_add_cells(grid_t *grid, const line_t *line, int level,
+                           const int splits[2], const int pos[2],
+                           int *verts_idx, const int total_splits[2])
+{
+    int i, j, k, dir;
+    int split_az, split_al, new_splits[2], new_pos[2];
+    double uv[4][2] = {{0.0, 1.0}, {1.0, 1.0}, {0.0, 0.0}, {1.0, 0.0}};
+    double mat[3][3] = MAT3_IDENTITY;
+    double lines[4][4] = {}, p[4];
+    grid_cell_t *cell;
+    grid_edge_t *edge;
+
+    if (level < grid_get_level(grid->steps)) {
+        split_az = grid->steps[0]->splits[level] ?: 1;
+        split_al = grid->steps[1]->splits[level + 1] ?: 1;
+        new_splits[0] = splits[0] * split_az;
+        new_splits[1] = splits[1] * split_al;
+        for (i = 0; i < split_al; i++)
+        for (j = 0; j < split_az; j++) {
+            new_pos[0] = pos[0] * split_az + j;
+            new_pos[1] = pos[1] * split_al + i;
+            grid_add_cells(grid, line, level + 1, new_splits, new_pos,
+                           verts_idx, total_splits);
+        }
+        return;
+    }
+
+    mat3_iscale(mat, 1. / splits[0], 1. / splits[1], 0);
+    mat3_itranslate(mat, pos[0], pos[1]);
+    for (i = 0; i < 4; i++) mat3_mul_vec2(mat, uv[i], uv[i]);
+    vec2_copy(uv[0], lines[0]);
+    vec2_copy(uv[2], lines[1]);
+    vec2_copy(uv[0], lines[2]);
+    vec2_copy(uv[1], lines[3]);
+
+    cell = &grid->cells[grid->nb_cells];
+    cell->edges[0] = cell->edges[1] = -1;
+    for (dir = 0; dir < 2; dir++) {
+        if (!line->grid && dir == 0) continue;
+        if (!line->grid && pos[1] != splits[1] / 2 - 1) continue;
+        if (dir == 1 && pos[1] == splits[1] - 1) continue;
+        if (dir == 1 && grid->skip_half && (pos[1] % 2)) continue;
+        if (    line->grid && dir == 0 &&
+                (pos[0] % (splits[0] / 4) != 0) &&
+                (pos[1] == 0 || pos[1] == splits[1] - 1))
+            continue;
+
+        edge = &grid->edges[grid->nb_edges];
+        cell->edges[dir] = grid->nb_edges++;
+        memcpy(edge->lines, lines + dir * 2, sizeof(edge->lines));
+        vec2_copy(uv[0], edge->uv);
+        edge->dir = dir;
+        edge->step = splits[dir] * (dir + 1);
+        for (k = 0; k <= EDGE_SPLIT; k++) {
+            vec4_mix(edge->lines[0], edge->lines[1], (double)k / EDGE_SPLIT,
+                     p);
+            uv_to_sphere(p, edge->samples[k]);
+        }
+    }
+    if (cell->edges[0] == -1 && cell->edges[1] == -1) return;
+
+    cell->corners[0] = grid_get_vert(grid, verts_idx, splits,
+                                     pos[0], pos[1] + 1);
+    cell->corners[1] = grid_get_vert(grid, verts_idx, splits,
+                                     pos[0] + 1, pos[1] + 1);
+    cell->corners[2] = grid_get_vert(grid, verts_idx, splits,
+                                     pos[0], pos[1]);
+    cell->corners[3] = grid_get_vert(grid, verts_idx, splits,
+                                     pos[0] + 1, pos[1]);
+    grid->nb_cells++;
+}
+
+/*
+ * Create the retained geometry of a grid for some steps.
+ *
+ * Return NULL if the grid has too many cells, in which case we use the
+ * recursion that only visits the visible parts.
+ */
+static grid_t *grid_create(const line_t *line, const step_t *steps[2],
+                           bool skip_half)
+{
+    int l, splits[2] = {1, 1}, nb_cells, nb_verts, *verts_idx;
+    grid_t *grid;
+
+    for (l = 0; l < grid_get_level(steps); l++) {
+        splits[0] *= steps[0]->splits[l] ?: 1;
+        splits[1] *= steps[1]->splits[l + 1] ?: 1;
+    }
+    nb_cells = splits[0] * splits[1];
+    if (nb_cells > GRID_MAX_CELLS) return NULL;
+    nb_verts = (splits[0] + 1) * (splits[1] + 1);
+
+    grid = calloc(1, sizeof(*grid));
+    grid->steps[0] = steps[0];
+    grid->steps[1] = steps[1];
+    grid->skip_half = skip_half;
+    grid->verts = malloc(nb_verts * sizeof(*grid->verts));
+    grid->cells = malloc(nb_cells * sizeof(*grid->cells));
+    grid->edges = malloc(nb_cells * 2 * sizeof(*grid->edges));
+    verts_idx = malloc(nb_verts * sizeof(*verts_idx));
+    memset(verts_idx, -1, nb_verts * sizeof(*verts_idx));
+    grid_add_cells(grid, line, 0, (int[]){1, 1}, (int[]){0, 0}, verts_idx,
+                   splits);
+    free(verts_idx);
+    return grid;
+}
+
+static void grid_delete(grid_t *grid)
+{
+    if (!grid) return;
+    free(grid->verts);
+    free(grid->cells);
+    free(grid->edges);
+    free(grid);
+}
+
+/*
+ * Key of the labels of a retained grid.
+ *
+ * The labels only depend on the grid rotation, the observer rotations to
+ * the view frame, the projection, the label format and the language, so
+ * we don't need to look at the grid vertices.
+ */
+static uint32_t get_labels_key(const line_t *line, const grid_t *grid,
+                               const painter_t *painter,
+                               const double rot[3][3])
+{
+    const observer_t *obs = painter->obs;
+    const projection_t *proj = painter->proj;
+    const char *lang = sys_get_lang();
+    uint32_t key = 0;
+
+    #define H(a) key = crc32(key, (void*)&(a), sizeof(a))
+    H(grid);
+    H(line->frame);
+    H(line->format);
+    key = crc32(key, (void*)rot, 9 * sizeof(double));
+    H(obs->rc2v);
+    H(obs->ri2v);
+    H(obs->rc2h);
+    H(obs->ri2h);
+    H(obs->ro2v);
+    H(obs->ro2m);
+    H(obs->rnp);
+    H(obs->pressure);
+    H(obs->refa);
+    H(obs->refb);
+    H(proj->type);
+    H(proj->flags);
+    H(proj->scaling);
+    H(proj->mat);
+    H(proj->window_size);
+    #undef H
+    if (lang) key = crc32(key, (void*)lang, strlen(lang));
+    return key;
+}
+
+/*
+ * Render a retained grid.
+ *
+ * All the vertices are rotated and projected in one pass, then we clip the
+ * cells as render_recursion does, and project the samples of the visible
+ * edges.  The labels are only recomputed when the view changes.
+ */
+static void render_grid(line_t *line, const painter_t *painter,
+                        const double rot[3][3], const grid_t *grid)
+{
+    const int m = EDGE_SPLIT + 1;
+    double (*view)[3], (*clip)[4], (*samples)[3], (*win)[4];
+    double pos_view[4][4], pos_clip[4][4], a[4] = {}, b[4] = {};
+    double p[2], u[2], v[2];
+    int i, j, nb = 0, *visible;
+    const grid_cell_t *cell;
+    const grid_edge_t *edge;
+    uint32_t key;
+    uv_map_t map = {
+        .map   = spherical_project,
+        .user  = (void*)rot,
+    };
+
+    view = malloc(grid->nb_verts * sizeof(*view));
+    clip = malloc(grid->nb_verts * sizeof(*clip));
+    for (i = 0; i < grid->nb_verts; i++)
+        mat3_mul_vec3(rot, grid->verts[i], view[i]);
+    convert_frame_many(painter->obs, line->frame, FRAME_VIEW, true,
+                       grid->nb_verts, view, view);
+    for (i = 0; i < grid->nb_verts; i++) {
+        vec3_copy(view[i], clip[i]);
+        clip[i][3] = 0;
+    }
+    project_many(painter->proj, 0, grid->nb_verts, clip, clip);
+
+    visible = malloc(grid->nb_edges * sizeof(*visible));
+    for (i = 0; i < grid->nb_cells; i++) {
+        cell = &grid->cells[i];
+        for (j = 0; j < 4; j++) {
+            vec3_copy(view[cell->corners[j]], pos_view[j]);
+            pos_view[j][3] = 0;
+            vec4_copy(clip[cell->corners[j]], pos_clip[j]);
+        }
+        if (is_clipped(pos_view, pos_clip)) continue;
+        for (j = 0; j < 2; j++) {
+            if (cell->edges[j] != -1) visible[nb++] = cell->edges[j];
+        }
+    }
+
+    samples = malloc(nb * m * sizeof(*samples));
+    win = malloc(nb * m * sizeof(*win));
+    for (i = 0; i < nb; i++) {
+        edge = &grid->edges[visible[i]];
+        for (j = 0; j < m; j++)
+            mat3_mul_vec3(rot, edge->samples[j], samples[i * m + j]);
+    }
+    convert_frame_many(painter->obs, line->frame, FRAME_VIEW, true, nb * m,
+                       samples, samples);
+
+    // The labels are at the intersections of the edges with the viewport.
+    key = line->format ? get_labels_key(line, grid, painter, rot) : 0;
+    if (line->format && (key != line->labels_key || !line->labels)) {
+        line->labels_key = key;
+        line->nb_labels = 0;
+        line->labels = realloc(line->labels,
+                               max(nb, 1) * sizeof(*line->labels));
+        for (i = 0; i < nb; i++) {
+            edge = &grid->edges[visible[i]];
+            vec3_copy(samples[i * m], a);
+            vec3_copy(samples[i * m + EDGE_SPLIT], b);
+            if (!check_borders(a, b, painter->proj, p, u, v)) continue;
+            if (compute_label(p, u, v, edge->uv, 1 - edge->dir, line,
+                              edge->step, painter,
+                              &line->labels[line->nb_labels]))
+                line->labels[line->nb_labels++].edge = i;
+        }
+    }
+
+    if (!(painter->proj->flags & PROJ_HAS_DISCONTINUITY)) {
+        for (i = 0; i < nb * m; i++) {
+            vec3_copy(samples[i], win[i]);
+            win[i][3] = 0;
+        }
+        project_many(painter->proj, PROJ_TO_WINDOW_SPACE, nb * m, win, win);
+        for (i = 0; i < nb * m; i++) vec3_copy(win[i], samples[i]);
+    }
+
+    // Render each edge followed by its label, like render_recursion.
+    for (i = 0, j = 0; i < nb; i++) {
+        edge = &grid->edges[visible[i]];
+        if (painter->proj->flags & PROJ_HAS_DISCONTINUITY) {
+            // Let paint_line split the edges around the discontinuity.
+            paint_line(painter, line->frame, edge->lines, &map, EDGE_SPLIT,
+                       0);
+        } else {
+            paint_projected_line(painter, m, samples + i * m);
+        }
+        for (; j < line->nb_labels && line->labels[j].edge == i; j++)
+            paint_label(&line->labels[j], painter);
+    }
+
+    free(view);
+    free(clip);
+    free(visible);
+    free(samples);
+    free(win);
+}
+
 /*
  * Compute an estimation of the visible range of azimuthal and altitude angles.
  *
@@ -758,6 +1124,18 @@ static int line_render(const obj_t *obj, const painter_t *painter_)
         skip_half = true;
     }
 
+    // Use the retained geometry if the grid is not too fine.
+    if (!line->retained || line->retained->steps[0] != steps[0] ||
+            line->retained->steps[1] != steps[1] ||
+            line->retained->skip_half != skip_half) {
+        grid_delete(line->retained);
+        line->retained = grid_create(line, steps, skip_half);
+    }
+    if (line->retained) {
+        render_grid(line, &painter, rot, line->retained);
+        return 0;
+    }
+
     render_recursion(line, &painter, rot, 0, splits, pos, steps, skip_half);
     return 0;
 }
@@ -792,3 +1170,137 @@ static obj_klass_t lines_klass = {
     .render_order = 35, // just before landscape.
 };
 OBJ_REGISTER(lines_klass)
+
+
+/******* TESTS **********************************************************/
+#if COMPILE_TESTS
+
+static void test_grid_create(void)
+{
+    const step_t *steps[2] = {&STEPS_AZ[0], &STEPS_ALT[1]}; // 15°, 10°.
+    const step_t *fine_steps[2] = {&STEPS_RA[8], &STEPS_DEC[11]};
+    line_t line = {.grid = true};
+    const grid_cell_t *cell;
+    const grid_edge_t *edge;
+    grid_t *grid;
+    int i, j;
+
+    // Full grid: 24 x 18 cells, the meridians stop at the poles except
+    // every 90°.
+    grid = grid_create(&line, steps, false);
+    assert(grid);
+    // The cells of the last row without meridian have no edges.
+    assert(grid->nb_cells == 24 * 18 - 20);
+    assert(grid->nb_verts <= 25 * 19);
+    assert(grid->nb_edges == 24 * 16 + 2 * 4 + 24 * 17);
+    for (i = 0; i < grid->nb_verts; i++)
+        assert(fabs(vec3_norm(grid->verts[i]) - 1) < 1e-12);
+    for (i = 0; i < grid->nb_cells; i++) {
+        cell = &grid->cells[i];
+        for (j = 0; j < 4; j++)
+            assert(cell->corners[j] >= 0 && cell->corners[j] <
+                   grid->nb_verts);
+        assert(cell->edges[0] != -1 || cell->edges[1] != -1);
+        // The edges start at the first corner, and end at the third one
+        // for the meridians, or the second one for the parallels.
+        for (j = 0; j < 2; j++) {
+            if (cell->edges[j] == -1) continue;
+            assert(cell->edges[j] < grid->nb_edges);
+            edge = &grid->edges[cell->edges[j]];
+            assert(edge->dir == j);
+            assert(vec3_dist(edge->samples[0],
+                             grid->verts[cell->corners[0]]) < 1e-12);
+            assert(vec3_dist(edge->samples[EDGE_SPLIT],
+                             grid->verts[cell->corners[j ? 1 : 2]]) < 1e-12);
+        }
+    }
+    grid_delete(grid);
+
+    // Skip every other parallel.
+    grid = grid_create(&line, steps, true);
+    assert(grid->nb_edges == 24 * 16 + 2 * 4 + 24 * 9);
+    grid_delete(grid);
+
+    // Single line: only the parallels of the middle row.
+    line.grid = false;
+    grid = grid_create(&line, steps, false);
+    assert(grid->nb_cells == 24 && grid->nb_edges == 24);
+    grid_delete(grid);
+
+    // Too many cells: we use the recursion instead.
+    line.grid = true;
+    assert(!grid_create(&line, fine_steps, false));
+}
+
+static void test_grid_clipping(void)
+{
+    const double inside[4][4] = {
+        {-0.5, -0.5, 0, 1}, {0.5, -0.5, 0, 1},
+        {-0.5,  0.5, 0, 1}, {0.5,  0.5, 0, 1}};
+    const double right[4][4] = {
+        {2, -0.5, 0, 1}, {3, -0.5, 0, 1},
+        {2,  0.5, 0, 1}, {3,  0.5, 0, 1}};
+    const double around[4][4] = {
+        {-2, 0, 0, 1}, {2, 0, 0, 1},
+        { 0, -2, 0, 1}, {0, 2, 0, 1}};
+    double front[4][4] = {{0, 0, -1}, {0, 0, -1}, {0, 0, -1}, {0, 0, -1}};
+    double back[4][4] = {{0, 0, 1}, {0, 0, 1}, {0, 0, 1}, {0, 0, 1}};
+    double clip[4][4];
+
+    memcpy(clip, inside, sizeof(clip));
+    assert(!is_clipped(front, clip));
+    memcpy(clip, right, sizeof(clip));
+    assert(is_clipped(front, clip));
+    // Shape around the viewport: only clipped if it's behind us.
+    memcpy(clip, around, sizeof(clip));
+    assert(!is_clipped(front, clip));
+    assert(is_clipped(back, clip));
+}
+
+static const char *test_get_lang(void)
+{
+    return "fr";
+}
+
+static void test_grid_labels_key(void)
+{
+    const step_t *steps[2] = {&STEPS_AZ[0], &STEPS_ALT[1]};
+    line_t line = {.grid = true, .format = 'd', .frame = FRAME_OBSERVED};
+    double rot[3][3] = MAT3_IDENTITY;
+    observer_t obs = {};
+    projection_t proj;
+    painter_t painter = {.obs = &obs, .proj = &proj};
+    const char *(*get_lang)() = sys_callbacks.get_lang;
+    grid_t *grid;
+    uint32_t key;
+
+    grid = grid_create(&line, steps, false);
+    mat3_set_identity(obs.ro2v);
+    projection_init(&proj, PROJ_PERSPECTIVE, 60 * DD2R, 800, 600);
+    key = get_labels_key(&line, grid, &painter, rot);
+    assert(get_labels_key(&line, grid, &painter, rot) == key);
+
+    mat3_rz(0.1, rot, rot);
+    assert(get_labels_key(&line, grid, &painter, rot) != key);
+    mat3_set_identity(rot);
+    mat3_rx(0.1, obs.ro2v, obs.ro2v);
+    assert(get_labels_key(&line, grid, &painter, rot) != key);
+    mat3_set_identity(obs.ro2v);
+    projection_init(&proj, PROJ_PERSPECTIVE, 60 * DD2R, 1024, 600);
+    assert(get_labels_key(&line, grid, &painter, rot) != key);
+    projection_init(&proj, PROJ_PERSPECTIVE, 60 * DD2R, 800, 600);
+    line.format = 'h';
+    assert(get_labels_key(&line, grid, &painter, rot) != key);
+    line.format = 'd';
+    sys_callbacks.get_lang = test_get_lang;
+    assert(get_labels_key(&line, grid, &painter, rot) != key);
+    sys_callbacks.get_lang = get_lang;
+    assert(get_labels_key(&line, grid, &painter, rot) == key);
+    grid_delete(grid);
+}
+
+TEST_REGISTER(NULL, test_grid_create, TEST_AUTO);
+TEST_REGISTER(NULL, test_grid_clipping, TEST_AUTO);
+TEST_REGISTER(NULL, test_grid_labels_key, TEST_AUTO);
+
+#endif
@@ -14,6 +14,9 @@
 
 // Minor planets module
 
+// Number of snapshot bodies we test for visibility per frame.
+#define SNAPSHOT_SCAN_NB 1024
+
 typedef struct orbit_t {
     float d;    // date (julian day).
     float i;    // inclination (rad).
@@ -62,6 +65,12 @@ typedef struct mplanets {
 
     mplanet_t *render_current;
     mplanet_t *visibles; // Linked list of currently visible minor planets.
+
+    // Set if the data source is a binary snapshot.  In that case the
+    // objects are only created when they get visible or are searched.
+    mpc_snapshot_t  snapshot;
+    mplanet_t       **snapshot_objs;
+    int             snapshot_pos; // Next body to test for visibility.
 } mplanets_t;
 
 // Static instance.
@@ -155,6 +164,7 @@ static void load_data(mplanets_t *mplanets, const char *data, int size)
             _Static_assert(sizeof(desig) == sizeof(mplanet->desig), "");
             memcpy(mplanet->desig, desig, sizeof(desig));
         }
+        search_index_add_obj(&mplanet->obj);
     }
     if (nb_err) {
         LOG_W("Minor planet data got %d errors lines.", nb_err);
@@ -163,11 +173,108 @@ static void load_data(mplanets_t *mplanets, const char *data, int size)
     LOG_I("Parsed %d asteroids", nb);
 }
 
+static void mplanet_set_from_snapshot(mplanet_t *mplanet,
+                                      const mpc_snapshot_t *snap, int idx)
+{
+    mplanet->orbit.d = snap->epoch[idx];
+    mplanet->orbit.m = snap->m[idx];
+    mplanet->orbit.w = snap->peri[idx];
+    mplanet->orbit.o = snap->node[idx];
+    mplanet->orbit.i = snap->i[idx];
+    mplanet->orbit.e = snap->e[idx];
+    mplanet->orbit.n = snap->n[idx];
+    mplanet->orbit.a = snap->a[idx];
+    mplanet->h = snap->h[idx];
+    mplanet->g = snap->g[idx];
+    mplanet->mpl_number = snap->number[idx];
+    memcpy(mplanet->obj.type, snap->otype[idx], 4);
+    snprintf(mplanet->name, sizeof(mplanet->name), "%s",
+             snap->strings + snap->name[idx]);
+    snprintf(mplanet->desig, sizeof(mplanet->desig), "%s",
+             snap->strings + snap->desig[idx]);
+    if (mplanet->name[0]) {
+        snprintf(mplanet->model, sizeof(mplanet->model), "%d_%s",
+                 mplanet->mpl_number, mplanet->name);
+    }
+}
+
+// Return the object of a snapshot body, creating it if needed.
+static mplanet_t *get_snapshot_obj(mplanets_t *mplanets, int idx)
+{
+    mplanet_t *mplanet = mplanets->snapshot_objs[idx];
+    if (mplanet) return mplanet;
+    mplanet = (void*)module_add_new(&mplanets->obj, "asteroid", NULL);
+    mplanet_set_from_snapshot(mplanet, &mplanets->snapshot, idx);
+    // Keep a reference, in case the object gets removed from the module.
+    mplanets->snapshot_objs[idx] = (void*)obj_retain(&mplanet->obj);
+    return mplanet;
+}
+
+static int on_snapshot_search(void *user, int idx, const char *dsgn)
+{
+    mplanets_t *mplanets = USER_GET(user, 0);
+    void *f_user = USER_GET(user, 1);
+    int (*f)(void *user, const char *dsgn, obj_t *obj) = USER_GET(user, 2);
+    return f(f_user, dsgn, &get_snapshot_obj(mplanets, idx)->obj);
+}
+
+static void snapshot_search(void *user, const char *key, bool prefix,
+                            void *f_user,
+                            int (*f)(void *f_user, const char *dsgn,
+                                     obj_t *obj))
+{
+    mplanets_t *mplanets = user;
+    mpc_snapshot_search(&mplanets->snapshot, key, prefix,
+                        USER_PASS(mplanets, f_user, f), on_snapshot_search);
+}
+
+static void load_snapshot(mplanets_t *mplanets, const char *data, int size)
+{
+    mpc_snapshot_t *snap = &mplanets->snapshot;
+    if (mpc_snapshot_open(snap, data, size) ||
+            snap->type != MPC_SNAPSHOT_ASTEROIDS) {
+        LOG_E("Invalid asteroids snapshot");
+        memset(snap, 0, sizeof(*snap));
+        return;
+    }
+    mplanets->snapshot_objs = calloc(snap->nb,
+                                     sizeof(*mplanets->snapshot_objs));
+    search_index_add_source(mplanets, snapshot_search);
+    LOG_I("Loaded %d asteroids snapshot", snap->nb);
+}
+
+// Remove all the objects of the current data source.
+static void release_data(mplanets_t *mplanets)
+{
+    obj_t *child, *tmp;
+    int i;
+
+    DL_FOREACH_SAFE(mplanets->obj.children, child, tmp)
+        module_remove(&mplanets->obj, child);
+    mplanets->visibles = NULL;
+    mplanets->render_current = NULL;
+    if (mplanets->snapshot_objs) {
+        search_index_remove_source(mplanets, snapshot_search);
+        for (i = 0; i < mplanets->snapshot.nb; i++)
+            obj_release((void*)mplanets->snapshot_objs[i]);
+        free(mplanets->snapshot_objs);
+        mplanets->snapshot_objs = NULL;
+        memset(&mplanets->snapshot, 0, sizeof(mplanets->snapshot));
+        mplanets->snapshot_pos = 0;
+        asset_release(mplanets->source_url);
+    }
+    mplanets->parsed = false;
+}
+
 static int mplanets_add_data_source(
         obj_t *obj, const char *url, const char *key)
 {
     mplanets_t *mplanets = (void*)obj;
     if (strcmp(key, "mpc_asteroids") != 0) return 1;
+    if (mplanets->source_url) {
+        release_data(mplanets);
+        free(mplanets->source_url);
+    }
     mplanets->source_url = strdup(url);
     return 0;
 }
@@ -364,6 +471,14 @@ static int mplanets_init(obj_t *obj, json_value *args)
     return 0;
 }
 
+static void mplanets_del(obj_t *obj)
+{
+    mplanets_t *mps = (void*)obj;
+    release_data(mps);
+    free(mps->source_url);
+    g_mplanets = NULL;
+}
+
 static int mplanets_update(obj_t *obj, double dt)
 {
     int size, code;
@@ -378,6 +493,11 @@ static int mplanets_update(obj_t *obj, double dt)
             LOG_W("Cannot read asteroids data: %s (%d)", mps->source_url, code);
             return 0;
         }
+        // The snapshot points directly into the data, so we keep it.
+        if (mpc_snapshot_is(data, size)) {
+            load_snapshot(mps, data, size);
+            return 0;
+        }
         load_data(mps, data, size);
         asset_release(mps->source_url);
     }
@@ -390,6 +510,50 @@ static void add_to_visible(mplanets_t *mps, mplanet_t *mplanet)
     DL_APPEND2(mps->visibles, mplanet, visible_prev, visible_next);
 }
 
+/*
+ * Approximate magnitude of a snapshot body.
+ *
+ * We ignore the light time and the aberration, and use the Earth center
+ * instead of the observer, which is good enough to know if the body could
+ * be visible.
+ */
+static double snapshot_get_vmag(const mpc_snapshot_t *snap, int idx,
+                                const observer_t *obs)
+{
+    double ph[3], po[3];
+    orbit_compute_pv(0, obs->tt, ph, NULL,
+                     snap->epoch[idx], snap->i[idx], snap->node[idx],
+                     snap->peri[idx], snap->a[idx], snap->n[idx],
+                     snap->e[idx], snap->m[idx], 0, 0);
+    mat3_mul_vec3(obs->re2i, ph, ph);
+    vec3_sub(ph, obs->earth_pvh[0], po);
+    return compute_magnitude(snap->h[idx], snap->g[idx], ph, po);
+}
+
+// Test the visibility of the next snapshot bodies, and render the ones that
+// could be visible.
+static void render_snapshot(mplanets_t *mps, const painter_t *painter)
+{
+    const mpc_snapshot_t *snap = &mps->snapshot;
+    mplanet_t *mplanet;
+    double max_vmag = painter->stars_limit_mag + 1.4 + mps->hints_mag_offset;
+    int i, idx;
+
+    for (i = 0; i < min(SNAPSHOT_SCAN_NB, snap->nb); i++) {
+        idx = (mps->snapshot_pos + i) % snap->nb;
+        mplanet = mps->snapshot_objs[idx];
+        if (mplanet && mplanet->visible_prev) continue; // Already rendered.
+        // Add a margin for the approximation.
+        if (snapshot_get_vmag(snap, idx, painter->obs) > max_vmag + 0.5)
+            continue;
+        mplanet = get_snapshot_obj(mps, idx);
+        if (mplanet_render(&mplanet->obj, painter) == 1)
+            add_to_visible(mps, mplanet);
+    }
+    if (snap->nb)
+        mps->snapshot_pos = (mps->snapshot_pos + i) % snap->nb;
+}
+
 static int mplanets_render(const obj_t *obj, const painter_t *painter)
 {
     PROFILE(mplanets_render, 0);
@@ -417,6 +581,11 @@ static int mplanets_render(const obj_t *obj, const painter_t *painter)
         }
     }
 
+    if (mps->snapshot.nb) {
+        render_snapshot(mps, painter);
+        return 0;
+    }
+
     // Then iter part of the full list as well.
     for (   i = 0, child = mps->render_current ?: (void*)mps->obj.children;
             child && i < update_nb;
@@ -430,6 +599,29 @@ static int mplanets_render(const obj_t *obj, const painter_t *painter)
     return 0;
 }
 
+static int mplanets_list(const obj_t *obj,
+                         double max_mag, uint64_t hint, const char *source,
+                         void *user, int (*f)(void *user, obj_t *obj))
+{
+    mplanets_t *mps = (void*)obj;
+    obj_t *child;
+    int i;
+
+    // With a snapshot, we only create the objects bright enough to be
+    // listed.
+    for (i = 0; i < mps->snapshot.nb; i++) {
+        if (!isnan(max_mag) &&
+            snapshot_get_vmag(&mps->snapshot, i, core->observer) > max_mag)
+            continue;
+        if (f(user, &get_snapshot_obj(mps, i)->obj)) return 0;
+    }
+    if (mps->snapshot.nb) return 0;
+    DL_FOREACH(obj->children, child) {
+        if (f(user, child)) break;
+    }
+    return 0;
+}
+
 /*
  * Meta class declarations.
  */
@@ -448,11 +640,14 @@ OBJ_REGISTER(mplanet_klass)
 static obj_klass_t mplanets_klass = {
     .id             = "minor_planets",
     .size           = sizeof(mplanets_t),
-    .flags          = OBJ_IN_JSON_TREE | OBJ_MODULE | OBJ_LISTABLE,
+    .flags          = OBJ_IN_JSON_TREE | OBJ_MODULE | OBJ_LISTABLE |
+                      OBJ_INDEXED,
     .init           = mplanets_init,
+    .del            = mplanets_del,
     .add_data_source    = mplanets_add_data_source,
     .update         = mplanets_update,
     .render         = mplanets_render,
+    .list           = mplanets_list,
     .render_order   = 20,
     .attributes = (attribute_t[]) {
         PROPERTY(visible, TYPE_BOOL, MEMBER(mplanets_t, visible)),
@@ -47,6 +47,7 @@ struct planet {
     double      mass;       // kg (0 if unknown).
 
     // Optimizations vars
+    ephcache_t *eph; // Ephemeris cache of the position relative to parent.
     float update_delta_s;    // Number of seconds between 2 orbits full update
     double last_full_update; // Time of last full orbit update (TT)
     double last_full_pvh[2][3]; // equ, J2000.0, AU heliocentric pos and speed.
@@ -182,6 +183,81 @@ static void moon_icrf_geocentric_pos(double tt, double pos[3])
 }
 
 
+/*
+ * Ephemeris function of the planets that have an ephemeris cache.
+ * Return the position of the body relative to its parent (relative to the
+ * Earth for the Moon).
+ */
+static void planet_eph_compute(void *user, double tt, double pos[3])
+{
+    const planet_t *planet = user;
+    double pv[2][3];
+
+    switch (planet->id) {
+    case MOON:
+        moon_icrf_geocentric_pos(tt, pos);
+        return;
+    case MERCURY:
+    case VENUS:
+    case MARS:
+    case JUPITER:
+    case SATURN:
+    case URANUS:
+    case NEPTUNE:
+        eraPlan94(DJM0, tt, (planet->id - MERCURY) / 100 + 1, pv);
+        break;
+    case PLUTO:
+        pluto_pos(tt, pos);
+        return;
+    case IO:
+    case EUROPA:
+    case GANYMEDE:
+    case CALLISTO:
+        l12(DJM0, tt, planet->id - IO + 1, pv);
+        break;
+    default:
+        assert(false);
+        return;
+    }
+    vec3_copy(pv[0], pos);
+}
+
+/*
+ * Create the ephemeris cache of a planet if we support it.
+ *
+ * The segments lengths and orders keep the position errors under 1e-9 AU
+ * (150 m), well below the precision of the models themselves.
+ */
+static void planet_init_eph(planet_t *planet)
+{
+    double seg_len;
+    int order;
+
+    switch (planet->id) {
+    case MOON:
+        seg_len = 4; order = 12; break;
+    case MERCURY:
+        seg_len = 8; order = 12; break;
+    case VENUS:
+    case MARS:
+        seg_len = 16; order = 10; break;
+    case JUPITER:
+    case SATURN:
+    case URANUS:
+    case NEPTUNE:
+    case PLUTO:
+        seg_len = 32; order = 8; break;
+    case IO:
+    case EUROPA:
+    case GANYMEDE:
+    case CALLISTO:
+        seg_len = 1; order = 12; break;
+    default:
+        return;
+    }
+    planet->eph = ephcache_create(seg_len, order, planet, planet_eph_compute);
+}
+
 /*
  * Function: planet_get_pvh
  * Get the heliocentric (ICRF) position of a planet at a given time.
@@ -190,7 +266,17 @@ static void planet_get_pvh(const planet_t *planet, const observer_t *obs,
                            double pvh[2][3])
 {
     double dt, parent_pvh[2][3];
-    int n;
+
+    if (planet->eph) {
+        ephcache_get(planet->eph, obs->tt, pvh);
+        if (planet->id == MOON) {
+            eraPvppv(pvh, obs->earth_pvh, pvh);
+        } else if (planet->parent->id != SUN) {
+            planet_get_pvh(planet->parent, obs, parent_pvh);
+            eraPvppv(pvh, parent_pvh, pvh);
+        }
+        return;
+    }
 
     // Use cached value if possible.
     if (planet->last_full_update) {
@@ -208,39 +294,6 @@ static void planet_get_pvh(const planet_t *planet, const observer_t *obs,
     case SUN:
         eraZpv(pvh);
         return;
-    case MOON:
-        moon_icrf_geocentric_pos(obs->tt, pvh[0]);
-        moon_icrf_geocentric_pos(obs->tt + 1, pvh[1]);
-        vec3_sub(pvh[1], pvh[0], pvh[1]);
-        eraPvppv(pvh, obs->earth_pvh, pvh);
-        return;
-
-    case MERCURY:
-    case VENUS:
-    case MARS:
-    case JUPITER:
-    case SATURN:
-    case URANUS:
-    case NEPTUNE:
-        n = (planet->id - MERCURY) / 100 + 1;
-        eraPlan94(DJM0, obs->tt, n, pvh);
-        break;
-
-    case PLUTO:
-        pluto_pos(obs->tt, pvh[0]);
-        pluto_pos(obs->tt + 1, pvh[1]);
-        vec3_sub(pvh[1], pvh[0], pvh[1]);
-        break;
-
-    case IO:
-    case EUROPA:
-    case GANYMEDE:
-    case CALLISTO:
-        planet_get_pvh(planet->parent, obs, parent_pvh);
-        l12(DJM0, obs->tt, planet->id - IO + 1, pvh);
-        vec3_add(pvh[0], parent_pvh[0], pvh[0]);
-        vec3_add(pvh[1], parent_pvh[1], pvh[1]);
-        break;
 
     default:
         planet_get_pvh(planet->parent, obs, parent_pvh);
@@ -1316,6 +1369,10 @@ static int planets_init(obj_t *obj, json_value *args)
         texture_from_url("asset://textures/halo.png", TF_LAZY_LOAD);
 
 
+    PLANETS_ITER(obj, p) {
+        planet_init_eph(p);
+    }
+
     // Some data check.
     PLANETS_ITER(obj, p) {
         assert(*p->obj.type);
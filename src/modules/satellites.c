@@ -11,7 +11,60 @@
 #include "sgp4.h"
 #include "designation.h"
 
+#include <limits.h>
+
 #define SATELLITE_DEFAULT_MAG 7.0
+
+/*
+ * The positions of all the satellites are regularly recomputed in chunks
+ * of SCAN_CHUNK_SIZE satellites, in the worker threads if available.  This
+ * gives an approximate magnitude that we use to find the satellites to add
+ * to the list of visible satellites.  Only the satellites of that list get
+ * their exact position computed at each frame.
+ */
+#define SCAN_CHUNK_SIZE 512
+// Max number of scan chunks we start per frame.
+#define SCAN_MAX_STARTS 2
+
+// Size of the TLE lines in the binary catalogue, including the final null.
+#define TLE_LINE_SIZE 70
+
+/*
+ * Type: tle_catalogue_t
+ * A binary catalogue of satellites.
+ *
+ * The catalogues are created with tools/make-tle-catalogue.py from the
+ * jsonl files.  Like the MPC snapshots (see src/mpc.h), the values are
+ * stored as a structure of arrays that we use directly from the file data.
+ * All the values are little endian.  The layout is:
+ *
+ *   - A 32 bytes header: the magic 'TLEC', then the uint32 values version,
+ *     nb, and strings_size.
+ *   - One array of nb values for each of the attributes, in the order of
+ *     the structure below.
+ *   - The strings table.
+ *
+ * Each array but the strings table is padded to a multiple of eight bytes.
+ *
+ * The names and the types are offsets in the strings table of a list of
+ * null terminated strings, that ends with an empty string.  The TLE lines
+ * are null terminated, so that we can pass them to sgp4_twoline2rv as they
+ * are.
+ */
+typedef struct tle_catalogue {
+    int             nb;
+    const double    *epoch;         // TLE epoch (UTC MJD).
+    const double    *launch_date;   // UTC MJD, or zero if not known.
+    const double    *decay_date;    // UTC MJD, or zero if not known.
+    const int32_t   *number;        // NORAD number.
+    const float     *stdmag;        // Standard magnitude, or NAN.
+    const float     *perigee;       // Perigee height (km).
+    const char      (*tle)[2][TLE_LINE_SIZE];
+    const uint32_t  *names;
+    const uint32_t  *types;
+    const char      *strings;
+} tle_catalogue_t;
+
 /*
  * Artificial satellites module
  */
@@ -24,6 +77,9 @@ typedef struct satellite satellite_t;
 struct satellite {
     obj_t obj;
     sgp4_elsetrec_t *elsetrec; // Orbit elements.
+    // TLE lines, if the elements have not been computed yet.
+    const char (*tle)[TLE_LINE_SIZE];
+    double epoch; // TLE epoch (UTC MJD).
     int number;
     double stdmag;
     double pvg[2][3];
@@ -37,24 +93,56 @@ struct satellite {
 
     bool error; // Set if we got an error computing the position.
     json_value *data; // Data passed in the constructor.
+    const char *names; // Names list from a binary catalogue.
     double max_brightness; // Cached max_brightness value.
 
     // Linked list of currently visible on screen.
     satellite_t *visible_next, *visible_prev;
 };
 
+/*
+ * Type: scan_chunk_t
+ * A chunk of satellites that we propagate together in a worker.
+ */
+typedef struct scan_chunk {
+    worker_t    worker;
+    bool        started;
+    int         nb;
+    satellite_t *sats[SCAN_CHUNK_SIZE];
+    const sgp4_elsetrec_t *elsetrecs[SCAN_CHUNK_SIZE];
+
+    // Observer values copied when we start the worker.
+    double      utc;
+    double      rnp[3][3];
+    double      obs_pvg[3];
+    double      earth_pvh[3];
+    double      sun_pvo[3];
+
+    // Output of the worker.
+    double      r[SCAN_CHUNK_SIZE][3];
+    double      v[SCAN_CHUNK_SIZE][3];
+    int         errors[SCAN_CHUNK_SIZE];
+    double      vmag[SCAN_CHUNK_SIZE]; // NAN if below the horizon.
+} scan_chunk_t;
+
 // Module class.
 typedef struct satellites {
     obj_t   obj;
-    char    *jsonl_url;   // jsonl file in noctuasky server format.
+    // jsonl file in noctuasky server format, or binary catalogue.
+    char    *jsonl_url;
     bool    loaded;
     int     update_pos; // Index of the position for iterative update.
     bool    visible;
     double  hints_mag_offset;
     bool    hints_visible;
 
-    satellite_t *render_current;
     satellite_t *visibles; // Linked list of currently visible satellites.
+
+    scan_chunk_t *scan; // Array of all the scan chunks.
+    int         scan_nb;
+    int         scan_pos; // Next chunk to start.
+
+    tle_catalogue_t catalogue; // Set if we loaded a binary catalogue.
 } satellites_t;
 
 // Static instance.
@@ -112,7 +200,8 @@ static int load_jsonl_data(satellites_t *sats, const char *data, int size,
         sat = (void*)module_add_new(&sats->obj, "tle_satellite", json);
         json_value_free(json);
         if (!sat) goto error;
-        *last_epoch = max(*last_epoch, sgp4_get_satepoch(sat->elsetrec));
+        search_index_add_obj(&sat->obj);
+        *last_epoch = max(*last_epoch, sat->epoch);
         nb++;
         continue;
 error:
@@ -123,6 +212,142 @@ error:
     return nb;
 }
 
+static bool tle_catalogue_is(const void *data, int size)
+{
+    return size >= 32 && memcmp(data, "TLEC", 4) == 0;
+}
+
+static int tle_catalogue_open(tle_catalogue_t *cat, const void *data,
+                              int size)
+{
+    const uint32_t *header = data;
+    uint32_t nb, strings_size;
+    uint64_t ofs = 32; // 64 bits so that a bad header can't overflow it.
+    int i;
+
+    memset(cat, 0, sizeof(*cat));
+    if (!tle_catalogue_is(data, size)) return -1;
+    if (header[1] != 1) return -1; // Version.
+    nb = header[2];
+    strings_size = header[3];
+    if (nb > INT_MAX) return -1;
+    cat->nb = nb;
+
+#define COLUMN(col_, n_) do { \
+        if (ofs > size) goto error; \
+        cat->col_ = (const void*)((const char*)data + ofs); \
+        ofs += ((uint64_t)(n_) * sizeof(*cat->col_) + 7) / 8 * 8; \
+    } while (0)
+
+    COLUMN(epoch, nb);
+    COLUMN(launch_date, nb);
+    COLUMN(decay_date, nb);
+    COLUMN(number, nb);
+    COLUMN(stdmag, nb);
+    COLUMN(perigee, nb);
+    COLUMN(tle, nb);
+    COLUMN(names, nb);
+    COLUMN(types, nb);
+#undef COLUMN
+
+    // Make sure we don't read past the end of the data, and that the
+    // strings table ends with an empty string, so that any list of strings
+    // in it is terminated.
+    if (strings_size < 2 || ofs + strings_size > size) goto error;
+    cat->strings = (const char*)data + ofs;
+    if (cat->strings[strings_size - 1] != '\0' ||
+            cat->strings[strings_size - 2] != '\0') goto error;
+
+    for (i = 0; i < cat->nb; i++) {
+        if (cat->names[i] >= strings_size) goto error;
+        if (cat->types[i] >= strings_size) goto error;
+        if (!memchr(cat->tle[i][0], '\0', TLE_LINE_SIZE)) goto error;
+        if (!memchr(cat->tle[i][1], '\0', TLE_LINE_SIZE)) goto error;
+    }
+    return 0;
+
+error:
+    memset(cat, 0, sizeof(*cat));
+    return -1;
+}
+
+static double compute_max_brightness(double perigree, double stdmag);
+static void satellite_set_model(satellite_t *sat);
+
+// Compute the otype from a catalogue types list.
+static const char *otype_from_list(const char *list, const char *base)
+{
+    for (; *list; list += strlen(list) + 1) {
+        if (otype_match(list, base)) return list;
+    }
+    return base;
+}
+
+static void satellite_set_from_catalogue(satellite_t *sat,
+                                         const tle_catalogue_t *cat, int idx)
+{
+    sat->tle = cat->tle[idx];
+    sat->epoch = cat->epoch[idx];
+    sat->number = cat->number[idx];
+    sat->launch_date = cat->launch_date[idx];
+    sat->decay_date = cat->decay_date[idx];
+    if (!isnan(cat->stdmag[idx])) sat->stdmag = cat->stdmag[idx];
+    sat->names = cat->strings + cat->names[idx];
+    strncpy(sat->obj.type,
+            otype_from_list(cat->strings + cat->types[idx], "Asa"), 4);
+    sat->max_brightness = compute_max_brightness(cat->perigee[idx],
+                                                 sat->stdmag);
+    satellite_set_model(sat);
+}
+
+/*
+ * Create all the satellites of a binary catalogue.
+ *
+ * We don't compute the orbit elements here, this is done the first time
+ * we propagate each satellite.
+ */
+static int load_catalogue(satellites_t *sats, const char *data, int size,
+                          const char *url, double *last_epoch)
+{
+    tle_catalogue_t *cat = &sats->catalogue;
+    satellite_t *sat;
+    int i;
+
+    *last_epoch = 0;
+    if (tle_catalogue_open(cat, data, size)) {
+        LOG_E("Invalid satellites catalogue: %s", url);
+        return -1;
+    }
+    for (i = 0; i < cat->nb; i++) {
+        sat = (void*)module_add_new(&sats->obj, "tle_satellite", NULL);
+        satellite_set_from_catalogue(sat, cat, i);
+        search_index_add_obj(&sat->obj);
+        *last_epoch = max(*last_epoch, sat->epoch);
+    }
+    return cat->nb;
+}
+
+static void scan_init(satellites_t *sats)
+{
+    obj_t *child;
+    satellite_t *sat;
+    scan_chunk_t *chunk = NULL;
+    int nb = 0;
+
+    DL_COUNT(sats->obj.children, child, nb);
+    sats->scan = calloc((nb + SCAN_CHUNK_SIZE - 1) / SCAN_CHUNK_SIZE,
+                        sizeof(*sats->scan));
+    DL_FOREACH(sats->obj.children, child) {
+        sat = (void*)child;
+        if (!sat->elsetrec && !sat->tle) continue;
+        if (!chunk || chunk->nb == SCAN_CHUNK_SIZE)
+            chunk = &sats->scan[sats->scan_nb++];
+        // The elements are set when we start the chunk.
+        chunk->sats[chunk->nb] = sat;
+        chunk->nb++;
+    }
+}
+
 static int satellites_update(obj_t *obj, double dt)
 {
     PROFILE(satellites_update, 0);
@@ -135,14 +360,21 @@ static int satellites_update(obj_t *obj, double dt)
     if (sats->loaded) return 0;
     if (!sats->jsonl_url) return 0;
 
-    data = asset_get_data2(sats->jsonl_url, ASSET_USED_ONCE, &size, &code);
+    data = asset_get_data(sats->jsonl_url, &size, &code);
     if (!code) return 0; // Sill loading.
     if (!data) return 0; // Got error;
-    nb = load_jsonl_data(sats, data, size, sats->jsonl_url, &last_epoch);
+    // The catalogue satellites point directly into the data, so we keep it.
+    if (tle_catalogue_is(data, size)) {
+        nb = load_catalogue(sats, data, size, sats->jsonl_url, &last_epoch);
+    } else {
+        nb = load_jsonl_data(sats, data, size, sats->jsonl_url, &last_epoch);
+        asset_release(sats->jsonl_url);
+    }
     LOG_I("Parsed %d satellites (latest epoch: %s)", nb,
           format_time(buf, last_epoch, 0, "YYYY-MM-DD"));
     if (last_epoch < unix_to_mjd(sys_get_unix_time()) - 2)
         LOG_W("Warning: satellites data seems outdated.");
+    scan_init(sats);
     sats->loaded = true;
     return 0;
 }
@@ -154,14 +386,14 @@ static void add_to_visible(satellites_t *sats, satellite_t *sat)
 }
 
 static int satellite_render(const obj_t *obj, const painter_t *painter);
+static void scan_update(satellites_t *sats, const painter_t *painter);
 
 static int satellites_render(const obj_t *obj, const painter_t *painter)
 {
     PROFILE(satellites_render, 0);
 
     satellites_t *sats = (void*)obj;
-    int i, r;
-    const int update_nb = 32;
+    int r;
     satellite_t *child, *tmp;
 
     if (!sats->visible) return false;
@@ -182,15 +414,9 @@ static int satellites_render(const obj_t *obj, const painter_t *painter)
         }
     }
 
-    // Then iter part of the full list as well.
-    for (   i = 0, child = sats->render_current ?: (void*)sats->obj.children;
-            child && i < update_nb;
-            i++, child = (void*)child->obj.next) {
-        if (child->visible_prev) continue; // Was already rendered.
-        r = satellite_render(&child->obj, painter);
-        if (r == 1) add_to_visible(sats, child);
-    }
-    sats->render_current = child;
+    // Then add the new visible satellites from the scan, they will be
+    // rendered in the next frame.
+    scan_update(sats, painter);
     return 0;
 }
 
@@ -198,9 +424,13 @@ static int satellites_render(const obj_t *obj, const painter_t *painter)
  * Compute the amount of light the satellite receives from the Sun, taking
  * into account the Earth shadow.  Return a value from 0 (totally eclipsed)
  * to 1 (totally illuminated).
+ *
+ * Parameters:
+ *   pvg        - Geocentric position of the satellite (ICRF, AU).
+ *   earth_pvh  - Heliocentric position of the Earth (ICRF, AU).
  */
-static double satellite_compute_earth_shadow(const satellite_t *sat,
-                                             const observer_t *obs)
+static double compute_earth_shadow(const double pvg[3],
+                                   const double earth_pvh[3])
 {
     double e_pos[3]; // Earth position from sat.
     double s_pos[3]; // Sun position from sat.
@@ -210,8 +440,8 @@ static double satellite_compute_earth_shadow(const satellite_t *sat,
     const double EARTH_RADIUS = 6371000; // (m).
 
 
-    vec3_mul(-DAU, sat->pvg[0], e_pos);
-    vec3_add(obs->earth_pvh[0], sat->pvg[0], s_pos);
+    vec3_mul(-DAU, pvg, e_pos);
+    vec3_add(earth_pvh, pvg, s_pos);
     vec3_mul(-DAU, s_pos, s_pos);
     elong = eraSepp(e_pos, s_pos);
     e_r = asin(EARTH_RADIUS / vec3_norm(e_pos));
@@ -223,35 +453,36 @@ static double satellite_compute_earth_shadow(const satellite_t *sat,
     return 0.0;
 }
 
-static double compute_max_brightness(
-        const sgp4_elsetrec_t *elsetrec, double stdmag)
+static double compute_max_brightness(double perigree, double stdmag)
 {
-    double perigree;
-    perigree = sgp4_get_perigree_height(elsetrec);
     return stdmag - 15.75 + 2.5 * log10(perigree * perigree);
 }
 
-static double satellite_compute_vmag(const satellite_t *sat,
-                                     const observer_t *obs)
+/*
+ * Compute the vmag of a satellite above the horizon.
+ *
+ * Parameters:
+ *   stdmag         - Standard magnitude of the satellite, or NAN.
+ *   pvo            - Position of the satellite from the observer (AU).
+ *   sun_pvo        - Position of the Sun from the observer (AU).
+ *   illumination   - Value returned by compute_earth_shadow.
+ */
+static double compute_vmag(double stdmag, const double pvo[3],
+                           const double sun_pvo[3], double illumination)
 {
-    double illumination, fracil, phase_angle, range;
-    double observed[3];
+    double fracil, phase_angle, range;
     double ph[3];
 
-    convert_frame(obs, FRAME_ICRF, FRAME_OBSERVED, false,
-                        sat->pvo[0], observed);
-    if (observed[2] < 0.0) return 99; // Below horizon.
-    illumination = satellite_compute_earth_shadow(sat, obs);
     if (illumination == 0.0) {
         // Eclipsed.
         return 17.0;
     }
-    if (isnan(sat->stdmag)) return SATELLITE_DEFAULT_MAG;
+    if (isnan(stdmag)) return SATELLITE_DEFAULT_MAG;
 
-    vec3_sub(sat->pvo[0], obs->sun_pvo[0], ph);
-    phase_angle = eraSepp(sat->pvo[0], ph);
+    vec3_sub(pvo, sun_pvo, ph);
+    phase_angle = eraSepp(pvo, ph);
     fracil = 0.5 * cos(phase_angle) + 0.5;
-    range = vec3_norm(sat->pvo[0]) * DAU / 1000; // Distance in km.
+    range = vec3_norm(pvo) * DAU / 1000; // Distance in km.
 
     // If we have a std mag value,
     // We use the formula:
@@ -262,7 +493,21 @@ static double satellite_compute_vmag(const satellite_t *sat,
     //                  [ 0 <= fracil <= 1 ]
     // (https://www.prismnet.com/~mmccants/tles/mccdesc.html)
 
-    return sat->stdmag - 15.75 + 2.5 * log10(range * range / fracil);
+    return stdmag - 15.75 + 2.5 * log10(range * range / fracil);
+}
+
+static double satellite_compute_vmag(const satellite_t *sat,
+                                     const observer_t *obs)
+{
+    double illumination;
+    double observed[3];
+
+    convert_frame(obs, FRAME_ICRF, FRAME_OBSERVED, false,
+                        sat->pvo[0], observed);
+    if (observed[2] < 0.0) return 99; // Below horizon.
+    illumination = compute_earth_shadow(sat->pvg[0], obs->earth_pvh[0]);
+    return compute_vmag(sat->stdmag, sat->pvo[0], obs->sun_pvo[0],
+                        illumination);
 }
 
 /*
@@ -315,8 +560,7 @@ static int satellite_init(obj_t *obj, json_value *args)
 {
     // Support creating a satellite using noctuasky model data json values.
     satellite_t *sat = (satellite_t*)obj;
-    const char *tle1, *tle2, *name = NULL,
-               *launch_date = NULL, *decay_date = NULL;
+    const char *tle1, *tle2, *launch_date = NULL, *decay_date = NULL;
     double startmfe, stopmfe, deltamin;
     int r;
     const json_value *types = NULL;
@@ -334,7 +578,6 @@ static int satellite_init(obj_t *obj, json_value *args)
                 "?launch_date", JCON_STR(launch_date),
                 "?decay_date", JCON_STR(decay_date),
             "}",
-            "?names", "[", JCON_STR(name), "]",
         "}");
         if (r) {
             LOG_E("Cannot parse satellite json data");
@@ -343,25 +586,69 @@ static int satellite_init(obj_t *obj, json_value *args)
         }
         sat->elsetrec = sgp4_twoline2rv(tle1, tle2, 'c', 'm', 'i',
                                         &startmfe, &stopmfe, &deltamin);
+        sat->epoch = sgp4_get_satepoch(sat->elsetrec);
         strncpy(sat->obj.type, otype_from_json(types, "Asa"), 4);
 
         sat->data = json_copy(args);
         sat->max_brightness = compute_max_brightness(
-                sat->elsetrec, sat->stdmag);
+                sgp4_get_perigree_height(sat->elsetrec), sat->stdmag);
 
         if (launch_date) parse_date(launch_date, &sat->launch_date);
         if (decay_date) parse_date(decay_date, &sat->decay_date);
-
-        // Determin what 3d model to use.
-        if (name && strncmp(name, "NAME STARLINK", 13) == 0)
-            sat->model = "Starlink";
-        if (sat->number == 25544) sat->model = "ISS";
-        if (sat->number == 20580) sat->model = "HST";
+        satellite_set_model(sat);
     }
 
     return 0;
 }
 
+/*
+ * Return the name at a given index in the satellite names, or NULL.
+ */
+static const char *satellite_get_name_at(const satellite_t *sat, int i)
+{
+    const char *name;
+    const json_value *jnames;
+
+    if (sat->names) {
+        for (name = sat->names; *name; name += strlen(name) + 1) {
+            if (i-- == 0) return name;
+        }
+        return NULL;
+    }
+    if (!sat->data) return NULL;
+    jnames = json_get_attr(sat->data, "names", json_array);
+    if (!jnames || i >= jnames->u.array.length) return NULL;
+    if (jnames->u.array.values[i]->type != json_string) return NULL;
+    return jnames->u.array.values[i]->u.string.ptr;
+}
+
+// Determine what 3d model to use.
+static void satellite_set_model(satellite_t *sat)
+{
+    const char *name = satellite_get_name_at(sat, 0);
+    if (name && strncmp(name, "NAME STARLINK", 13) == 0)
+        sat->model = "Starlink";
+    if (sat->number == 25544) sat->model = "ISS";
+    if (sat->number == 20580) sat->model = "HST";
+}
+
+/*
+ * Return the orbit elements of a satellite.
+ *
+ * For the satellites of a binary catalogue, we only parse the TLE the first
+ * time we need the elements.
+ */
+static sgp4_elsetrec_t *satellite_get_elsetrec(satellite_t *sat)
+{
+    double startmfe, stopmfe, deltamin;
+    if (!sat->elsetrec && sat->tle) {
+        sat->elsetrec = sgp4_twoline2rv(sat->tle[0], sat->tle[1],
+                                        'c', 'm', 'i',
+                                        &startmfe, &stopmfe, &deltamin);
+    }
+    return sat->elsetrec;
+}
+
 static void satellite_del(obj_t *obj)
 {
     satellite_t *sat = (satellite_t*)obj;
@@ -386,10 +673,9 @@ static bool satellite_is_operational(const satellite_t *sat, double utc)
 {
     // For the moment, if we don't know the launch or decay date, we 10
     // years before/after the satellite epoch.
-    double start, end, epoch;
-    epoch = sgp4_get_satepoch(sat->elsetrec);
-    start = sat->launch_date ? sat->launch_date - 1 : epoch - 3600;
-    end = sat->decay_date ? sat->decay_date + 1 : epoch + 3600;
+    double start, end;
+    start = sat->launch_date ? sat->launch_date - 1 : sat->epoch - 3600;
+    end = sat->decay_date ? sat->decay_date + 1 : sat->epoch + 3600;
     return utc > start && utc < end;
 }
 
@@ -398,16 +684,18 @@ static bool satellite_is_operational(const satellite_t *sat, double utc)
  */
 static int satellite_update(satellite_t *sat, const observer_t *obs)
 {
+    sgp4_elsetrec_t *elsetrec;
     double pv[2][3];
     char buf[128];
     int r;
 
     if (sat->error) return 0;
-    assert(sat->elsetrec);
     if (!satellite_is_operational(sat, obs->utc)) return 0;
 
     // Orbit computation.
-    r = sgp4(sat->elsetrec, obs->utc, pv[0],  pv[1]);
+    elsetrec = satellite_get_elsetrec(sat);
+    assert(elsetrec);
+    r = sgp4(elsetrec, obs->utc, pv[0],  pv[1]);
     if (r && r != 6) { // 6 = satellite decayed, don't log this case.
         obj_get_name((obj_t*)sat, buf, sizeof(buf));
         LOG_W("Satellite position error for %s (%d), err=%d",
@@ -434,6 +722,84 @@ static int satellite_update(satellite_t *sat, const observer_t *obs)
     return 0;
 }
 
+static int scan_chunk_worker(worker_t *worker)
+{
+    scan_chunk_t *chunk = (void*)worker;
+    const satellite_t *sat;
+    double pvg[3], pvo[3], up[3], illumination;
+    int i;
+
+    sgp4_propagate_many(chunk->elsetrecs, chunk->nb, chunk->utc,
+                        chunk->r, chunk->v, chunk->errors);
+    vec3_normalize(chunk->obs_pvg, up);
+    for (i = 0; i < chunk->nb; i++) {
+        sat = chunk->sats[i];
+        chunk->vmag[i] = NAN;
+        if (chunk->errors[i]) continue;
+        if (!satellite_is_operational(sat, chunk->utc)) continue;
+        vec3_mul(1000.0 / DAU, chunk->r[i], pvg);
+        mat3_mul_vec3(chunk->rnp, pvg, pvg);
+        // Geometric position from the observer, with a margin of about one
+        // degree below the horizon.  Good enough to cull the satellites.
+        vec3_sub(pvg, chunk->obs_pvg, pvo);
+        if (vec3_dot(pvo, up) < -0.02 * vec3_norm(pvo)) continue;
+        illumination = compute_earth_shadow(pvg, chunk->earth_pvh);
+        chunk->vmag[i] = compute_vmag(sat->stdmag, pvo, chunk->sun_pvo,
+                                      illumination);
+    }
+    return 0;
+}
+
+static void scan_chunk_start(scan_chunk_t *chunk, const observer_t *obs)
+{
+    int i;
+    for (i = 0; i < chunk->nb; i++)
+        chunk->elsetrecs[i] = satellite_get_elsetrec(chunk->sats[i]);
+    worker_init(&chunk->worker, scan_chunk_worker);
+    chunk->utc = obs->utc;
+    mat3_copy(obs->rnp, chunk->rnp);
+    vec3_copy(obs->obs_pvg[0], chunk->obs_pvg);
+    vec3_copy(obs->earth_pvh[0], chunk->earth_pvh);
+    vec3_copy(obs->sun_pvo[0], chunk->sun_pvo);
+    chunk->started = true;
+}
+
+/*
+ * Start the scan of the next chunks, and add the satellites that could be
+ * visible from the finished ones to the visible list.
+ */
+static void scan_update(satellites_t *sats, const painter_t *painter)
+{
+    scan_chunk_t *chunk;
+    satellite_t *sat;
+    int i, j, idx, nb_started = 0, next_pos = sats->scan_pos;
+    // Same test as in satellite_render, with one magnitude margin since
+    // the scan values are approximate.
+    const double limit_mag = max(painter->stars_limit_mag,
+                                 painter->hints_limit_mag +
+                                 sats->hints_mag_offset - 2.5) + 1.0;
+
+    for (i = 0; i < sats->scan_nb; i++) {
+        idx = (sats->scan_pos + i) % sats->scan_nb;
+        chunk = &sats->scan[idx];
+        if (!chunk->started) {
+            if (nb_started >= SCAN_MAX_STARTS) continue;
+            scan_chunk_start(chunk, painter->obs);
+            nb_started++;
+            next_pos = (idx + 1) % sats->scan_nb;
+        }
+        if (!worker_iter(&chunk->worker)) continue; // Still running.
+        for (j = 0; j < chunk->nb; j++) {
+            sat = chunk->sats[j];
+            if (isnan(chunk->vmag[j])) continue;
+            if (chunk->vmag[j] > limit_mag && !sat->model) continue;
+            add_to_visible(sats, sat);
+        }
+        chunk->started = false;
+    }
+    sats->scan_pos = next_pos;
+}
+
 static int satellite_get_info(const obj_t *obj, const observer_t *obs, int info,
                               void *out)
 {
@@ -471,9 +837,39 @@ static int satellite_get_info(const obj_t *obj, const observer_t *obs, int info,
 static json_value *satellite_get_json_data(const obj_t *obj)
 {
     satellite_t *sat = (satellite_t*)obj;
+    json_value *ret, *md, *tle, *names, *types;
+    const char *name;
+    char buf[32];
+    int i;
+
     if (sat->data)
         return json_copy(sat->data);
-    return json_object_new(0);
+    ret = json_object_new(0);
+    if (!sat->tle) return ret;
+
+    // Same structure as the jsonl data, with only the values that we store
+    // in the binary catalogue.
+    types = json_object_push(ret, "types", json_array_new(0));
+    json_array_push(types, json_string_new(sat->obj.type));
+    md = json_object_push(ret, "model_data", json_object_new(0));
+    json_object_push(md, "norad_number", json_integer_new(sat->number));
+    if (!isnan(sat->stdmag) && sat->stdmag != SATELLITE_DEFAULT_MAG)
+        json_object_push(md, "mag", json_double_new(sat->stdmag));
+    tle = json_object_push(md, "tle", json_array_new(2));
+    json_array_push(tle, json_string_new(sat->tle[0]));
+    json_array_push(tle, json_string_new(sat->tle[1]));
+    if (sat->launch_date) {
+        format_time(buf, sat->launch_date, 0, "YYYY-MM-DD");
+        json_object_push(md, "launch_date", json_string_new(buf));
+    }
+    if (sat->decay_date) {
+        format_time(buf, sat->decay_date, 0, "YYYY-MM-DD");
+        json_object_push(md, "decay_date", json_string_new(buf));
+    }
+    names = json_object_push(ret, "names", json_array_new(0));
+    for (i = 0; (name = satellite_get_name_at(sat, i)); i++)
+        json_array_push(names, json_string_new(name));
+    return ret;
 }
 
 /*
@@ -488,20 +884,15 @@ static bool satellite_get_short_name(const satellite_t *sat, bool selected,
                                      char *out, int size)
 {
     int i;
-    json_value *jnames;
     const char* name;
     char buf[256];
     int len, best_name_len = size;
 
     *out = '\0';
-    if (!sat->data) return false;
-    jnames = json_get_attr(sat->data, "names", json_array);
-    if (!jnames || jnames->u.array.length == 0) return false;
+    if (!satellite_get_name_at(sat, 0)) return false;
     if (selected) goto use_first_dsgn;
 
-    for (i = 0; i < jnames->u.array.length; ++i) {
-        if (jnames->u.array.values[i]->type != json_string) continue;
-        name = jnames->u.array.values[i]->u.string.ptr;
+    for (i = 0; (name = satellite_get_name_at(sat, i)); ++i) {
         if (strncmp(name, "NAME ", 5) != 0) continue;
         designation_cleanup(name, buf, sizeof(buf), DSGN_TRANSLATE);
         len = strlen(buf);
@@ -514,8 +905,7 @@ static bool satellite_get_short_name(const satellite_t *sat, bool selected,
     if (*out) return true;
 
 use_first_dsgn:
-    if (jnames->u.array.values[0]->type != json_string) return false;
-    name = jnames->u.array.values[0]->u.string.ptr;
+    name = satellite_get_name_at(sat, 0);
     designation_cleanup(name, out, size, DSGN_TRANSLATE);
     return true;
 }
@@ -673,22 +1063,14 @@ static void satellite_get_designations(
              const char *cat, const char *str))
 {
     satellite_t *sat = (void*)obj;
-    json_value *names;
-    char *name;
+    const char *name;
     int i;
     char buf[32];
 
-    if (!sat->data) goto fallback;
-    names = json_get_attr(sat->data, "names", json_array);
-    if (!names || names->u.array.length == 0) goto fallback;
-    for (i = 0; i < names->u.array.length; i++) {
-        if (names->u.array.values[i]->type != json_string) goto fallback;
-        name = names->u.array.values[i]->u.string.ptr;
+    for (i = 0; (name = satellite_get_name_at(sat, i)); i++)
         f(obj, user, NULL, name);
-    }
-    return;
+    if (i) return;
 
-fallback:
     snprintf(buf, sizeof(buf), "%05d", sat->number);
     f(obj, user, "NORAD", buf);
 }
@@ -724,9 +1106,9 @@ int satellite_get_altitude(const obj_t *obj, const observer_t *obs,
     bool r;
 
     if (sat->error) return -1;
-    assert(sat->elsetrec);
+    assert(sat->elsetrec || sat->tle);
 
-    r = sgp4(sat->elsetrec, obs->utc, pos, speed);
+    r = sgp4(satellite_get_elsetrec(sat), obs->utc, pos, speed);
     if (r != 0) return -1;
     vec3_mul(1000.0 / DAU, pos, pos);
 
@@ -766,7 +1148,8 @@ OBJ_REGISTER(satellite_klass)
 static obj_klass_t satellites_klass = {
     .id             = "satellites",
     .size           = sizeof(satellites_t),
-    .flags          = OBJ_IN_JSON_TREE | OBJ_MODULE | OBJ_LISTABLE,
+    .flags          = OBJ_IN_JSON_TREE | OBJ_MODULE | OBJ_LISTABLE |
+                      OBJ_INDEXED,
     .init           = satellites_init,
     .add_data_source = satellites_add_data_source,
     .render_order   = 30,
@@ -890,6 +1273,128 @@ static void test_satellites(void)
         1, 1, 3, 1);
 }
 
+/*
+ * Create a one satellite catalogue in memory, with the same layout as the
+ * one of tools/make-tle-catalogue.py.  Use the values of a satellite
+ * created from json data.
+ */
+static char *test_make_catalogue(const satellite_t *sat,
+                                 const char *tle1, const char *tle2,
+                                 int *size)
+{
+    // Names list, types list, and final empty string.
+    const char strings[] =
+        "\0NAME ISS\0NAME ISS (ZARYA)\0NORAD 25544\0\0Asa\0\0";
+    const uint32_t names_ofs = 1, types_ofs = sizeof(strings) - 6;
+    const float stdmag = sat->stdmag;
+    const float perigee = sgp4_get_perigree_height(sat->elsetrec);
+    char *data, *p;
+
+    *size = 32 + 6 * 8 + 2 * TLE_LINE_SIZE + 4 + 2 * 8 + sizeof(strings);
+    data = calloc(1, *size);
+    memcpy(data, "TLEC", 4);
+    ((uint32_t*)data)[1] = 1; // Version.
+    ((uint32_t*)data)[2] = 1;
+    ((uint32_t*)data)[3] = sizeof(strings);
+    p = data + 32;
+    memcpy(p, &sat->epoch, 8);          p += 8;
+    memcpy(p, &sat->launch_date, 8);    p += 8;
+    memcpy(p, &sat->decay_date, 8);     p += 8;
+    memcpy(p, &sat->number, 4);         p += 8;
+    memcpy(p, &stdmag, 4);              p += 8;
+    memcpy(p, &perigee, 4);             p += 8;
+    strcpy(p, tle1);
+    strcpy(p + TLE_LINE_SIZE, tle2);
+    p += 2 * TLE_LINE_SIZE + 4;
+    memcpy(p, &names_ofs, 4);           p += 8;
+    memcpy(p, &types_ofs, 4);           p += 8;
+    memcpy(p, strings, sizeof(strings));
+    return data;
+}
+
+// Modify a copy of a catalogue and check that it gets rejected.
+#define TEST_BAD_CATALOGUE(data_, size_, type_, ptr_, value_) do { \
+        char *copy_ = malloc(size_); \
+        tle_catalogue_t bad_; \
+        memcpy(copy_, data_, size_); \
+        *(type_*)(copy_ + ((const char*)(ptr_) - (data_))) = (value_); \
+        assert(tle_catalogue_open(&bad_, copy_, size_) == -1); \
+        assert(bad_.nb == 0 && !bad_.strings); \
+        free(copy_); \
+    } while (0)
+
+static void test_satellites_catalogue(void)
+{
+    const char *tle1 =
+        "1 25544U 98067A   20029.69572272  .00004768  00000-0  94250-4 0  9992";
+    const char *tle2 =
+        "2 25544  51.6452 318.6562 0005196 207.4446 220.3378 15.49124691210396";
+    char json[1024], buf[2][64], *data;
+    satellite_t *sats[2];
+    tle_catalogue_t cat;
+    observer_t obs;
+    double pos[2][4], vmag[2];
+    int i, size;
+    uint32_t strings_size;
+
+    core_init(100, 100, 1.0);
+    snprintf(json, sizeof(json),
+             "{\"types\": [\"Asa\"], \"model_data\": {"
+             "\"norad_number\": 25544, \"mag\": -0.5,"
+             "\"tle\": [\"%s\", \"%s\"], \"launch_date\": \"1998-11-20\"},"
+             "\"names\": [\"NAME ISS\", \"NAME ISS (ZARYA)\","
+             " \"NORAD 25544\"]}",
+             tle1, tle2);
+    sats[0] = (void*)obj_create_str("tle_satellite", json);
+    assert(sats[0]);
+
+    data = test_make_catalogue(sats[0], tle1, tle2, &size);
+    assert(tle_catalogue_is(data, size));
+    assert(tle_catalogue_open(&cat, data, size) == 0);
+    assert(cat.nb == 1);
+    sats[1] = (void*)obj_create("tle_satellite", NULL);
+    satellite_set_from_catalogue(sats[1], &cat, 0);
+
+    obs = *core->observer;
+    obj_set_attr((obj_t*)&obs, "utc", 58878.2);
+    observer_update(&obs, false);
+    for (i = 0; i < 2; i++) {
+        obj_get_name(&sats[i]->obj, buf[i], sizeof(buf[i]));
+        obj_get_pos(&sats[i]->obj, &obs, FRAME_ICRF, pos[i]);
+        obj_get_info(&sats[i]->obj, &obs, INFO_VMAG, &vmag[i]);
+    }
+    test_str(buf[0], "ISS");
+    test_str(buf[1], buf[0]);
+    test_str(sats[1]->obj.type, sats[0]->obj.type);
+    assert(sats[1]->number == 25544);
+    assert(sats[1]->launch_date == sats[0]->launch_date);
+    test_float(sats[1]->max_brightness, sats[0]->max_brightness, 1e-4);
+    test_float(vmag[1], vmag[0], 1e-4);
+    assert(vec3_dist(pos[0], pos[1]) * DAU < 1e-3);
+    assert(vec3_norm(pos[0]) * DAU > 400e3); // Sanity check, not at zero.
+    for (i = 0; i < 2; i++) obj_release(&sats[i]->obj);
+
+    // Truncated data.
+    assert(tle_catalogue_open(&cat, data, size - 1) == -1);
+    assert(tle_catalogue_open(&cat, data, 100) == -1);
+    assert(tle_catalogue_open(&cat, data, 16) == -1);
+
+    // Corrupted header, offsets, and TLE lines.
+    assert(tle_catalogue_open(&cat, data, size) == 0);
+    strings_size = ((uint32_t*)data)[3];
+    TEST_BAD_CATALOGUE(data, size, uint32_t, data + 4, 2);
+    TEST_BAD_CATALOGUE(data, size, uint32_t, data + 8, 0x80000000);
+    TEST_BAD_CATALOGUE(data, size, uint32_t, data + 8, 1000);
+    TEST_BAD_CATALOGUE(data, size, uint32_t, data + 12, 0xffffffff);
+    TEST_BAD_CATALOGUE(data, size, uint32_t, &cat.names[0], strings_size);
+    TEST_BAD_CATALOGUE(data, size, uint32_t, &cat.types[0], 0xffffffff);
+    TEST_BAD_CATALOGUE(data, size, char, &cat.tle[0][1][TLE_LINE_SIZE - 1],
+                       'x');
+    TEST_BAD_CATALOGUE(data, size, char, &cat.strings[strings_size - 2], 'x');
+    free(data);
+}
+
 TEST_REGISTER(NULL, test_satellites, TEST_AUTO);
+TEST_REGISTER(NULL, test_satellites_catalogue, TEST_AUTO);
 
 #endif // COMPILE_TESTS
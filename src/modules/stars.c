@@ -18,6 +18,11 @@
 
 #define URL_MAX_SIZE 4096
 
+// Max observer time change before we recompute the cached astrometric
+// positions of the stars (day).  In one minute the parallax of the closest
+// stars changes by less than 0.0001 arcsec.
+#define ASTROM_TOLERANCE (1.0 / 1440)
+
 static const double LABEL_SPACING = 4;
 
 static obj_klass_t star_klass;
@@ -69,9 +74,30 @@ struct stars {
 // Static instance.
 static stars_t *g_stars = NULL;
 
+/*
+ * Type: star_data_t
+ * Per star data of a tile that is not needed by the render loop.
+ *
+ * Only used when a star object gets created from the tile.
+ */
+typedef struct {
+    char        type[4];
+    uint64_t    gaia;
+    int         hip;
+    float       plx;
+    double      distance;
+    char        *names;
+    char        *sp_type;
+} star_data_t;
+
 /*
  * Type: tile_t
  * Custom tile structure for the stars hips survey.
+ *
+ * The stars are stored as a structure of arrays sorted by vmag, so that
+ * the render loop only walks the few columns it actually needs.  The
+ * star_t objects are only created on demand with <tile_get_star>, for
+ * example when a star gets selected or labeled.
  */
 typedef struct tile {
     int         flags;
@@ -79,9 +105,34 @@ typedef struct tile {
     double      mag_max;
     double      illuminance; // Totall illuminance (lux).
     int         nb;
-    star_t      *sources;
+
+    // Hot columns used in the render loop.
+    struct {
+        double  *pos[3];        // Position at J2000 (AU), one per axis.
+        double  *vel[3];        // Velocity (AU/day), one per axis.
+        float   *vmag;
+        float   *bv;
+        float   *illuminance;   // (lux)
+        uint8_t (*color)[4];    // RGBA color computed from the B-V.
+    } cols;
+
+    star_data_t *data;          // Cold data.
+    star_t      **objs;         // Lazily created objects, can be NULL.
+
+    // Astrometric directions of the first astrom.nb stars, computed at
+    // the observer time astrom.tt.  See <tile_get_astrom>.
+    struct {
+        double  tt;
+        int     nb;
+        double  (*v)[3];
+    } astrom;
 } tile_t;
 
+static uint64_t pix_to_nuniq(int order, int pix)
+{
+    return pix + 4 * (1L << (2 * order));
+}
+
 static void nuniq_to_pix(uint64_t nuniq, int *order, int *pix)
 {
     *order = log2(nuniq / 4) / 2;
@@ -96,9 +147,13 @@ static void nuniq_to_pix(uint64_t nuniq, int *order, int *pix)
  *   pra    - Proper motion (rad/year).
  *   pde    - Proper motion (rad/year).
  *   plx    - Parallax (arcseconds).
+ *   epoch  - Catalog epoch (besselian year).
+ *   pvo    - Output astrometric position and speed at J2000.
+ *   dist   - Output distance (AU), or NAN if unknown.
  */
 static void compute_pv(double ra, double de, double pra, double pde,
-                       double plx, double epoch, star_t *s)
+                       double plx, double epoch, double pvo[2][3],
+                       double *dist)
 {
     int r;
     double djm0, djm = 0;
@@ -114,7 +169,7 @@ static void compute_pv(double ra, double de, double pra, double pde,
 
     // Pre-compute 3D position and speed in catalog/barycentric position
     // at epoch 2000, to broadly match DSS images.
-    r = eraStarpv(ra, de, pra / cos(de), pde, plx, 0, s->pvo);
+    r = eraStarpv(ra, de, pra / cos(de), pde, plx, 0, pvo);
     if (r & (2 | 4)) {
         LOG_W("Wrong star coordinates");
         if (r & 2) LOG_W("Excessive speed");
@@ -125,15 +180,15 @@ static void compute_pv(double ra, double de, double pra, double pde,
               plx * 1000);
     }
     if (r & 1) {
-        s->distance = NAN;
+        *dist = NAN;
     } else {
-        s->distance = vec3_norm(s->pvo[0]);
+        *dist = vec3_norm(pvo[0]);
     }
 
     // Apply proper motion to bring from catalog epoch to 2000.0 epoch
     eraEpb2jd(epoch, &djm0, &djm);
     double dt = ERFA_DJM00 - djm;
-    vec3_addk(s->pvo[0], s->pvo[1], dt, s->pvo[0]);
+    vec3_addk(pvo[0], pvo[1], dt, pvo[0]);
 }
 
 // Turn a json array of string into a '\0' separated C string.
@@ -172,7 +227,8 @@ static int star_init(obj_t *obj, json_value *args)
         if (isnan(star->vmag))
             star->vmag = json_get_attr_f(model, "Bmag", NAN);
         star->illuminance = core_mag_to_illuminance(star->vmag);
-        compute_pv(ra, de, pra, pde, star->plx, epoch, star);
+        compute_pv(ra, de, pra, pde, star->plx, epoch, star->pvo,
+                   &star->distance);
     }
 
     names = json_get_attr(args, "names", json_array);
@@ -181,6 +237,13 @@ static int star_init(obj_t *obj, json_value *args)
     return 0;
 }
 
+static void star_del(obj_t *obj)
+{
+    star_t *star = (star_t*)obj;
+    free(star->names);
+    free(star->sp_type);
+}
+
 // Return the star astrometric position, that is as seen from earth center
 // after applying proper motion and parallax.
 static void star_get_astrom(const star_t *s, const observer_t *obs,
@@ -308,6 +371,20 @@ static bool star_get_bayer_name(const star_t *s, char *out, int size,
 }
 
 
+/*
+ * Function: star_has_label
+ * Decide whether a star with a given vmag should get a label.
+ *
+ * This can be used before creating the actual star object.
+ */
+static bool star_has_label(const painter_t *painter, double vmag,
+                           bool selected, const double win_pos[2])
+{
+    const double hints_mag_offset = g_stars->hints_mag_offset +
+                                    core_get_hints_mag_offset(win_pos);
+    return selected || vmag <= painter->hints_limit_mag - 5 + hints_mag_offset;
+}
+
 static void star_render_name(const painter_t *painter, const star_t *s,
                              int frame, const double pos[3],
                              const double win_pos[2], double radius,
@@ -323,12 +400,11 @@ static void star_render_name(const painter_t *painter, const star_t *s,
     int flags = DSGN_TRANSLATE;
     const char *first_name = NULL;
 
-    double lim_mag = painter->hints_limit_mag - 5 + hints_mag_offset;
     double lim_mag2 = painter->hints_limit_mag - 7.5 + hints_mag_offset;
     double lim_mag3 = painter->hints_limit_mag - 9.0 + hints_mag_offset;
 
     // Decide whether a label must be displayed
-    if (!selected && s->vmag > lim_mag)
+    if (!star_has_label(painter, s->vmag, selected, win_pos))
         return;
 
     buf[0] = 0;
@@ -422,29 +498,165 @@ void star_get_designations(
     }
 }
 
+/*
+ * Function: tile_get_star
+ * Return the star object of a tile, creating it if needed.
+ *
+ * The returned object is owned by the tile, so the caller should call
+ * obj_retain if it wants to keep it after the tile is released.
+ */
+static star_t *tile_get_star(tile_t *tile, int i)
+{
+    star_t *s;
+    const star_data_t *d = &tile->data[i];
+    const char *name;
+
+    assert(i >= 0 && i < tile->nb);
+    if (!tile->objs) tile->objs = calloc(tile->nb, sizeof(*tile->objs));
+    if (tile->objs[i]) return tile->objs[i];
+
+    s = calloc(1, sizeof(*s));
+    s->obj.ref = 1;
+    s->obj.klass = &star_klass;
+    memcpy(s->obj.type, d->type, 4);
+    s->gaia = d->gaia;
+    s->hip = d->hip;
+    s->plx = d->plx;
+    s->distance = d->distance;
+    s->vmag = tile->cols.vmag[i];
+    s->bv = tile->cols.bv[i];
+    s->illuminance = tile->cols.illuminance[i];
+    s->pvo[0][0] = tile->cols.pos[0][i];
+    s->pvo[0][1] = tile->cols.pos[1][i];
+    s->pvo[0][2] = tile->cols.pos[2][i];
+    s->pvo[1][0] = tile->cols.vel[0][i];
+    s->pvo[1][1] = tile->cols.vel[1][i];
+    s->pvo[1][2] = tile->cols.vel[2][i];
+    if (d->names) {
+        for (name = d->names; *name; name += strlen(name) + 1) {}
+        s->names = malloc(name - d->names + 1);
+        memcpy(s->names, d->names, name - d->names + 1);
+    }
+    if (d->sp_type) s->sp_type = strdup(d->sp_type);
+    tile->objs[i] = s;
+    return s;
+}
+
+/*
+ * Test if a given object is the star at index i of a tile.
+ *
+ * We compare the catalog ids, since the object could have been created
+ * from a previous instance of the tile that got removed from the cache.
+ */
+static bool tile_star_is(const tile_t *tile, int i, const obj_t *obj)
+{
+    const star_t *s = (const star_t*)obj;
+    if (!obj || obj->klass != &star_klass) return false;
+    if (tile->objs && tile->objs[i] == s) return true;
+    if (tile->data[i].gaia) return s->gaia == tile->data[i].gaia;
+    return tile->data[i].hip && s->hip == tile->data[i].hip;
+}
+
 // Used by the cache.
 static int del_tile(void *data)
 {
     int i;
     tile_t *tile = data;
 
-    // Don't delete the tile if any contained star is used somehwere else.
+    // The star objects don't reference the tile data, so the ones that
+    // are still used somewhere else can outlive the tile.
     for (i = 0; i < tile->nb; i++) {
-        if (tile->sources[i].obj.ref > 1) return CACHE_KEEP;
+        if (tile->objs) obj_release((obj_t*)tile->objs[i]);
+        free(tile->data[i].names);
+        free(tile->data[i].sp_type);
     }
-
-    for (i = 0; i < tile->nb; i++) {
-        free(tile->sources[i].names);
-        free(tile->sources[i].sp_type);
+    free(tile->objs);
+    free(tile->data);
+    for (i = 0; i < 3; i++) {
+        free(tile->cols.pos[i]);
+        free(tile->cols.vel[i]);
     }
-    free(tile->sources);
+    free(tile->cols.vmag);
+    free(tile->cols.bv);
+    free(tile->astrom.v);
+    free(tile->cols.illuminance);
+    free(tile->cols.color);
     free(tile);
     return 0;
 }
 
-static int star_data_cmp(const void *a, const void *b)
+/*
+ * Function: tile_compute_astrom
+ * Compute the astrometric direction of the stars [start, end) of a tile.
+ *
+ * This is the batched version of star_get_astrom.  The loop only reads the
+ * tile columns and doesn't call any function except sqrt, so that the
+ * compiler can vectorize it.
+ */
+static void tile_compute_astrom(const tile_t *tile, int start, int end,
+                                const observer_t *obs, double (*out)[3])
+{
+    int i;
+    double x, y, z, k;
+    const double dt = obs->tt - ERFA_DJM00;
+    const double ex = obs->earth_pvb[0][0];
+    const double ey = obs->earth_pvb[0][1];
+    const double ez = obs->earth_pvb[0][2];
+    const double *restrict px = tile->cols.pos[0];
+    const double *restrict py = tile->cols.pos[1];
+    const double *restrict pz = tile->cols.pos[2];
+    const double *restrict vx = tile->cols.vel[0];
+    const double *restrict vy = tile->cols.vel[1];
+    const double *restrict vz = tile->cols.vel[2];
+
+    for (i = start; i < end; i++) {
+        x = px[i] + vx[i] * dt - ex;
+        y = py[i] + vy[i] * dt - ey;
+        z = pz[i] + vz[i] * dt - ez;
+        k = 1.0 / sqrt(x * x + y * y + z * z);
+        out[i][0] = x * k;
+        out[i][1] = y * k;
+        out[i][2] = z * k;
+    }
+}
+
+/*
+ * Function: tile_get_astrom
+ * Return the astrometric directions of the n brightest stars of a tile.
+ *
+ * The directions are kept in the tile, and only recomputed when the
+ * observer time moves by more than ASTROM_TOLERANCE, so that panning and
+ * zooming don't pay for it.  If we need more stars than the last time
+ * (because the limit magnitude changed) only the new ones are computed.
+ */
+static const double (*tile_get_astrom(tile_t *tile, int n,
+                                      const observer_t *obs))[3]
 {
-    return cmp(((const star_t*)a)->vmag, ((const star_t*)b)->vmag);
+    if (!tile->astrom.v)
+        tile->astrom.v = malloc(tile->nb * sizeof(*tile->astrom.v));
+    if (fabs(obs->tt - tile->astrom.tt) > ASTROM_TOLERANCE) {
+        tile->astrom.tt = obs->tt;
+        tile->astrom.nb = 0;
+    }
+    if (n > tile->astrom.nb) {
+        tile_compute_astrom(tile, tile->astrom.nb, n, obs, tile->astrom.v);
+        tile->astrom.nb = n;
+    }
+    return (const double (*)[3])tile->astrom.v;
+}
+
+// Temporary row structure used when we parse a tile.
+typedef struct {
+    star_data_t data;
+    double      pvo[2][3];
+    float       vmag;
+    float       bv;
+    float       illuminance;
+} star_row_t;
+
+static int star_row_cmp(const void *a, const void *b)
+{
+    return cmp(((const star_row_t*)a)->vmag, ((const star_row_t*)b)->vmag);
 }
 
 static int on_file_tile_loaded(const char type[4],
@@ -454,7 +666,7 @@ static int on_file_tile_loaded(const char type[4],
 {
     int version, nb, data_ofs = 0, row_size, flags, i, j, order, pix;
     int children_mask;
-    double vmag, gmag, ra, de, pra, pde, plx, bv, epoch;
+    double vmag, gmag, ra, de, pra, pde, plx, bv, epoch, color[3];
     char ids[256] = {};
     char sp_type[32] = {};
     survey_t *survey = USER_GET(user, 0);
@@ -462,7 +674,7 @@ static int on_file_tile_loaded(const char type[4],
     int *transparency = USER_GET(user, 2);
     tile_t *tile;
     void *table_data;
-    star_t *s;
+    star_row_t *rows, *s;
 
     // All the columns we care about in the source file.
     eph_table_column_t columns[] = {
@@ -506,17 +718,15 @@ static int on_file_tile_loaded(const char type[4],
     if (flags & 1) eph_shuffle_bytes(table_data, row_size, nb);
 
     tile = calloc(1, sizeof(*tile));
-    tile->sources = calloc(nb, sizeof(*tile->sources));
+    rows = calloc(nb, sizeof(*rows));
     tile->mag_min = DBL_MAX;
     tile->mag_max = -DBL_MAX;
 
     for (i = 0; i < nb; i++) {
-        s = &tile->sources[tile->nb];
-        s->obj.ref = 1;
-        s->obj.klass = &star_klass;
+        s = &rows[tile->nb];
         eph_read_table_row(
                 table_data, size, &data_ofs, ARRAY_SIZE(columns), columns,
-                s->obj.type, &s->gaia, &s->hip, &vmag, &gmag,
+                s->data.type, &s->data.gaia, &s->data.hip, &vmag, &gmag,
                 &ra, &de, &plx, &pra, &pde, &epoch, &bv, ids, sp_type);
         assert(!isnan(ra));
         assert(!isnan(de));
@@ -530,23 +740,23 @@ static int on_file_tile_loaded(const char type[4],
         // Avoid overlapping stars from Gaia survey.
         if (survey->is_gaia && vmag < survey->min_vmag) continue;
 
-        if (!*s->obj.type) strncpy(s->obj.type, "*", 4); // Default type.
+        if (!*s->data.type) strncpy(s->data.type, "*", 4); // Default type.
         epoch = epoch ?: 2000; // Default epoch.
         s->vmag = vmag;
-        s->plx = plx;
+        s->data.plx = plx;
         s->bv = bv;
 
         // Turn '|' separated ids into '\0' separated values.
         if (*ids) {
-            s->names = calloc(1, 2 + strlen(ids));
+            s->data.names = calloc(1, 2 + strlen(ids));
             for (j = 0; ids[j]; j++)
-                s->names[j] = ids[j] != '|' ? ids[j] : '\0';
+                s->data.names[j] = ids[j] != '|' ? ids[j] : '\0';
         }
         if (*sp_type) {
-            s->sp_type = strdup(sp_type);
+            s->data.sp_type = strdup(sp_type);
         }
 
-        compute_pv(ra, de, pra, pde, plx, epoch, s);
+        compute_pv(ra, de, pra, pde, plx, epoch, s->pvo, &s->data.distance);
         s->illuminance = core_mag_to_illuminance(vmag);
 
         tile->illuminance += s->illuminance;
@@ -554,10 +764,36 @@ static int on_file_tile_loaded(const char type[4],
         tile->mag_max = max(tile->mag_max, vmag);
         tile->nb++;
     }
+    free(table_data);
 
     // Sort the data by vmag, so that we can early exit during render.
-    qsort(tile->sources, tile->nb, sizeof(*tile->sources), star_data_cmp);
-    free(table_data);
+    qsort(rows, tile->nb, sizeof(*rows), star_row_cmp);
+
+    // Split the rows into the tile columns.
+    for (j = 0; j < 3; j++) {
+        tile->cols.pos[j] = malloc(tile->nb * sizeof(double));
+        tile->cols.vel[j] = malloc(tile->nb * sizeof(double));
+    }
+    tile->cols.vmag = malloc(tile->nb * sizeof(float));
+    tile->cols.bv = malloc(tile->nb * sizeof(float));
+    tile->cols.illuminance = malloc(tile->nb * sizeof(float));
+    tile->cols.color = malloc(tile->nb * sizeof(*tile->cols.color));
+    tile->data = malloc(tile->nb * sizeof(*tile->data));
+    for (i = 0; i < tile->nb; i++) {
+        for (j = 0; j < 3; j++) {
+            tile->cols.pos[j][i] = rows[i].pvo[0][j];
+            tile->cols.vel[j][i] = rows[i].pvo[1][j];
+        }
+        tile->cols.vmag[i] = rows[i].vmag;
+        tile->cols.bv[i] = rows[i].bv;
+        tile->cols.illuminance[i] = rows[i].illuminance;
+        bv_to_rgb(isnan(rows[i].bv) ? 0 : rows[i].bv, color);
+        for (j = 0; j < 3; j++)
+            tile->cols.color[i][j] = color[j] * 255;
+        tile->cols.color[i][3] = 255;
+        tile->data[i] = rows[i].data;
+    }
+    free(rows);
 
     // If we have a json header, check for a children mask value.
     if (json) {
@@ -579,7 +815,9 @@ static const void *stars_create_tile(
     survey_t *survey = user;
     eph_load(data, size, USER_PASS(survey, &tile, transparency),
              on_file_tile_loaded);
-    if (tile) *cost = tile->nb * sizeof(*tile->sources);
+    if (tile) *cost = tile->nb * (9 * sizeof(double) + 3 * sizeof(float) +
+                                  sizeof(*tile->cols.color) +
+                                  sizeof(*tile->data));
     return tile;
 }
 
@@ -634,6 +872,25 @@ static tile_t *get_tile(stars_t *stars, survey_t *survey, int order, int pix,
     return tile;
 }
 
+/*
+ * Return a new reference to a rendered star, from its survey and the id
+ * set in render_visitor (tile nuniq and star index).
+ *
+ * Only called when the star gets picked, so that we don't have to create
+ * the objects of all the rendered stars.
+ */
+static obj_t *get_rendered_star(void *user, uint64_t id)
+{
+    survey_t *survey = user;
+    int order, pix, code, i = id & 0xffffffff;
+    tile_t *tile;
+
+    nuniq_to_pix(id >> 32, &order, &pix);
+    tile = hips_get_tile(survey->hips, order, pix, HIPS_CACHED_ONLY, &code);
+    if (!tile || i >= tile->nb) return NULL;
+    return obj_retain(&tile_get_star(tile, i)->obj);
+}
+
 static int render_visitor(int order, int pix, void *user)
 {
     PROFILE(stars_render_visitor, PROFILE_AGGREGATE);
@@ -644,13 +901,16 @@ static int render_visitor(int order, int pix, void *user)
     int *nb_loaded = USER_GET(user, 4);
     double *illuminance = USER_GET(user, 5);
     tile_t *tile;
-    int i, n = 0, code;
+    int i, n = 0, nb, code;
     star_t *s;
-    double p_win[4], size = 0, luminance = 0, vmag = -DBL_MAX;
-    double color[3];
-    double v[3];
+    double size = 0, luminance = 0, vmag = -DBL_MAX;
+    double color[3], (*win)[2];
+    const double *p_win;
+    const uint8_t *c;
+    const double (*v)[3];
     double limit_mag = min(painter.stars_limit_mag, painter.hard_limit_mag);
-    bool selected;
+    bool selected, *visible;
+    point_t *points;
 
     // Early exit if the tile is clipped.
     if (painter_is_healpix_clipped(&painter, FRAME_ASTROM, order, pix, true))
@@ -664,44 +924,63 @@ static int render_visitor(int order, int pix, void *user)
     if (!tile) goto end;
     if (tile->mag_min > limit_mag) goto end;
 
-    point_t *points = malloc(tile->nb * sizeof(*points));
-    for (i = 0; i < tile->nb; i++) {
-        s = &tile->sources[i];
-        if (s->vmag > limit_mag) break;
+    // Since the stars are sorted by vmag, we only need to process the
+    // first nb stars.
+    for (nb = 0; nb < tile->nb; nb++) {
+        if (tile->cols.vmag[nb] > limit_mag) break;
+    }
 
-        star_get_astrom(s, painter.obs, v);
-        if (!painter_project(&painter, FRAME_ASTROM, v, true, true, p_win))
-            continue;
+    points = malloc(nb * sizeof(*points));
+    win = malloc(nb * sizeof(*win));
+    visible = malloc(nb * sizeof(*visible));
+    v = tile_get_astrom(tile, nb, painter.obs);
+    painter_project_many(&painter, FRAME_ASTROM, nb, v, true, true,
+                         win, visible);
 
-        (*illuminance) += s->illuminance;
+    for (i = 0; i < nb; i++) {
+        if (!visible[i]) continue;
+        p_win = win[i];
+
+        (*illuminance) += tile->cols.illuminance[i];
 
         // No need to recompute the point size and luminance if the last
         // star had the same vmag (often the case since we sort by vmag).
-        if (s->vmag != vmag) {
-            vmag = s->vmag;
+        if (tile->cols.vmag[i] != vmag) {
+            vmag = tile->cols.vmag[i];
             core_get_point_for_mag(vmag, &size, &luminance);
         }
         if (size == 0.0 || luminance == 0.0)
             continue;
 
-        bv_to_rgb(isnan(s->bv) ? 0 : s->bv, color);
+        c = tile->cols.color[i];
         points[n] = (point_t) {
             .pos = {p_win[0], p_win[1]},
             .size = size,
-            .color = {color[0] * 255, color[1] * 255, color[2] * 255,
-                      luminance * 255},
-            // This makes very faint stars not selectable
-            .obj = (luminance > 0.5 && size > 1) ? &s->obj : NULL,
+            .color = {c[0], c[1], c[2], luminance * 255},
         };
+        // This makes very faint stars not selectable
+        if (luminance > 0.5 && size > 1) {
+            points[n].get_obj = get_rendered_star;
+            points[n].get_obj_user = (void*)survey;
+            points[n].get_obj_id = pix_to_nuniq(order, pix) << 32 | i;
+        }
         n++;
-        selected = (&s->obj == core->selection);
-        if (selected || (stars->hints_visible && !survey->is_gaia))
-            star_render_name(&painter, s, FRAME_ASTROM, v, p_win, size, color);
+        selected = tile_star_is(tile, i, core->selection);
+        if (!selected && (!stars->hints_visible || survey->is_gaia))
+            continue;
+        if (!star_has_label(&painter, vmag, selected, p_win))
+            continue;
+        // Use the selection object so that the label gets attached to it.
+        s = selected ? (star_t*)core->selection : tile_get_star(tile, i);
+        vec3_set(color, c[0] / 255.0, c[1] / 255.0, c[2] / 255.0);
+        star_render_name(&painter, s, FRAME_ASTROM, v[i], p_win, size, color);
     }
     if (n > 0) {
         paint_2d_points(&painter, n, points);
     }
     free(points);
+    free(win);
+    free(visible);
 
 end:
     // Test if we should go into higher order tiles.
@@ -774,13 +1053,14 @@ static int stars_list(const obj_t *obj,
             tile = get_tile(stars, survey, order, pix, false, &code);
             if (!tile || tile->mag_min >= max_mag) continue;
             for (i = 0; i < tile->nb; i++) {
-                if (tile->sources[i].vmag > max_mag) continue;
-                r = f(user, &tile->sources[i].obj);
+                if (tile->cols.vmag[i] > max_mag) continue;
+                r = f(user, &tile_get_star(tile, i)->obj);
                 if (r) break;
             }
             if (i < tile->nb) break;
             hips_iter_push_children(&iter, order, pix);
         }
+        hips_iter_release(&iter);
         return 0;
     }
 
@@ -792,7 +1072,7 @@ static int stars_list(const obj_t *obj,
         return -1;
     }
     for (i = 0; i < tile->nb; i++) {
-        r = f(user, &tile->sources[i].obj);
+        r = f(user, &tile_get_star(tile, i)->obj);
         if (r) break;
     }
     return 0;
@@ -931,8 +1211,8 @@ obj_t *obj_get_by_hip(int hip, int *code)
             if (code == 0) return NULL; // Still loading.
             if (!tile) return NULL;
             for (i = 0; i < tile->nb; i++) {
-                if (tile->sources[i].hip == hip) {
-                    return obj_retain(&tile->sources[i].obj);
+                if (tile->data[i].hip == hip) {
+                    return obj_retain(&tile_get_star(tile, i)->obj);
                 }
             }
         }
@@ -948,6 +1228,7 @@ obj_t *obj_get_by_hip(int hip, int *code)
 static obj_klass_t star_klass = {
     .id         = "star",
     .init       = star_init,
+    .del        = star_del,
     .size       = sizeof(star_t),
     .get_info   = star_get_info,
     .get_json_data = star_get_json_data,
@@ -11,10 +11,14 @@
 
 #include "erfa.h" // Used for eraDtf2d.
 
+#include <ctype.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define SNAPSHOT_VERSION 1
+
 // Faster than atof.
 static inline int parse_float(const char *str, double *ret)
 {
@@ -345,6 +349,110 @@ int mpc_parse_comet_line(const char *line, int len,
     return 0;
 }
 
+bool mpc_snapshot_is(const void *data, int size)
+{
+    return size >= 32 && memcmp(data, "MPCS", 4) == 0;
+}
+
+int mpc_snapshot_open(mpc_snapshot_t *snap, const void *data, int size)
+{
+    const uint32_t *header = data;
+    uint32_t nb, nb_keys, strings_size;
+    uint64_t ofs = 32; // 64 bits so that a bad header can't overflow it.
+    int i;
+
+    memset(snap, 0, sizeof(*snap));
+    if (!mpc_snapshot_is(data, size)) return -1;
+    if (header[1] != SNAPSHOT_VERSION) return -1;
+    nb = header[3];
+    nb_keys = header[4];
+    strings_size = header[5];
+    if (nb > INT_MAX || nb_keys > INT_MAX) return -1;
+    snap->type = header[2];
+    snap->nb = nb;
+    snap->nb_keys = nb_keys;
+
+#define COLUMN(col_, n_) do { \
+        if (ofs > size) goto error; \
+        snap->col_ = (const void*)((const char*)data + ofs); \
+        ofs += ((uint64_t)(n_) * sizeof(*snap->col_) + 7) / 8 * 8; \
+    } while (0)
+
+    COLUMN(epoch, nb);
+    COLUMN(i, nb);
+    COLUMN(node, nb);
+    COLUMN(peri, nb);
+    COLUMN(a, nb);
+    COLUMN(e, nb);
+    COLUMN(n, nb);
+    COLUMN(m, nb);
+    COLUMN(h, nb);
+    COLUMN(g, nb);
+    COLUMN(number, nb);
+    COLUMN(name, nb);
+    COLUMN(desig, nb);
+    COLUMN(otype, nb);
+    COLUMN(keys, nb_keys);
+    COLUMN(keys_body, nb_keys);
+#undef COLUMN
+
+    // The strings table is the last block, without any padding.  Make sure
+    // we don't read past the end of the data, and that the last string is
+    // properly terminated.
+    if (strings_size == 0 || ofs + strings_size > size) goto error;
+    snap->strings = (const char*)data + ofs;
+    if (snap->strings[strings_size - 1] != '\0') goto error;
+
+    // Since the strings table ends with a null, any offset inside it points
+    // to a valid string.
+    for (i = 0; i < snap->nb; i++) {
+        if (snap->name[i] >= strings_size) goto error;
+        if (snap->desig[i] >= strings_size) goto error;
+    }
+    for (i = 0; i < snap->nb_keys; i++) {
+        if (snap->keys[i] >= strings_size) goto error;
+        if (snap->keys_body[i] >= nb) goto error;
+    }
+    return 0;
+
+error:
+    memset(snap, 0, sizeof(*snap));
+    return -1;
+}
+
+// Compare a designation to a lower case key.
+static int dsgn_cmp(const char *dsgn, const char *key, bool prefix)
+{
+    unsigned char a, b;
+    for (;; dsgn++, key++) {
+        b = *key;
+        if (prefix && !b) return 0;
+        a = tolower(*(unsigned char*)dsgn);
+        if (a != b || !a) return a - b;
+    }
+}
+
+void mpc_snapshot_search(const mpc_snapshot_t *snap, const char *key,
+                         bool prefix, void *user,
+                         int (*f)(void *user, int idx, const char *dsgn))
+{
+    int lo = 0, hi = snap->nb_keys, mid;
+    const char *dsgn;
+
+    // Binary search of the first matching key.
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        dsgn = snap->strings + snap->keys[mid];
+        if (dsgn_cmp(dsgn, key, prefix) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    for (; lo < snap->nb_keys; lo++) {
+        dsgn = snap->strings + snap->keys[lo];
+        if (dsgn_cmp(dsgn, key, prefix) != 0) break;
+        if (f(user, snap->keys_body[lo], dsgn)) break;
+    }
+}
+
 /******* TESTS **********************************************************/
 
 #if COMPILE_TESTS
@@ -393,6 +501,213 @@ static void test_parse_comet(void)
     assert(strcmp(desig, "C/1995 O1 (Hale-Bopp)") == 0);
 }
 
+/*
+ * Create a snapshot in memory, with the same layout as the one of
+ * tools/make-mpc-snapshot.py.  Each body only has a 'NAME' designation, so
+ * the names have to be sorted case insensitively.
+ */
+static char *test_make_snapshot(int type, int nb, const char *names[],
+                                int *size)
+{
+    char *data, *p, *strings;
+    int i, strings_size = 1, names_ofs[8], keys_ofs[8];
+    uint32_t *header;
+
+    assert(nb <= 8);
+    strings = calloc(1, 1024);
+    for (i = 0; i < nb; i++) {
+        names_ofs[i] = strings_size;
+        strings_size += sprintf(strings + strings_size, "%s", names[i]) + 1;
+        keys_ofs[i] = strings_size;
+        strings_size += sprintf(strings + strings_size, "NAME %s",
+                                names[i]) + 1;
+    }
+
+    *size = 32 + (nb * 8 + 7) / 8 * 8 + 15 * ((nb * 4 + 7) / 8 * 8) +
+            strings_size;
+    data = calloc(1, *size);
+    header = (uint32_t*)data;
+    memcpy(data, "MPCS", 4);
+    header[1] = SNAPSHOT_VERSION;
+    header[2] = type;
+    header[3] = nb;
+    header[4] = nb;
+    header[5] = strings_size;
+    p = data + 32;
+
+#define COLUMN(type_, expr_) do { \
+        for (i = 0; i < nb; i++) ((type_*)p)[i] = (expr_); \
+        p += (nb * sizeof(type_) + 7) / 8 * 8; \
+    } while (0)
+
+    COLUMN(double, 59000.5);        // epoch
+    COLUMN(float, 0.1);             // i
+    COLUMN(float, 1.0);             // node
+    COLUMN(float, 2.0);             // peri
+    COLUMN(float, 2.5 + i);         // a
+    COLUMN(float, 0.1);             // e
+    COLUMN(float, 0.005);           // n
+    COLUMN(float, 0.5);             // m
+    COLUMN(float, 5.0 + i);         // h
+    COLUMN(float, 0.15);            // g
+    COLUMN(int32_t, i + 1);         // number
+    COLUMN(uint32_t, names_ofs[i]); // name
+    COLUMN(uint32_t, 0);            // desig
+    for (i = 0; i < nb; i++) memcpy(p + i * 4, "MBA", 4);
+    p += (nb * 4 + 7) / 8 * 8;
+    COLUMN(uint32_t, keys_ofs[i]);  // keys
+    COLUMN(uint32_t, i);            // keys_body
+#undef COLUMN
+
+    memcpy(p, strings, strings_size);
+    assert(p + strings_size == data + *size);
+    free(strings);
+    return data;
+}
+
+static int test_on_search(void *user, int idx, const char *dsgn)
+{
+    int *found = user;
+    found[found[0]++ + 1] = idx;
+    return 0;
+}
+
+// Modify a copy of a snapshot and check that it gets rejected.
+#define TEST_BAD_SNAPSHOT(data_, size_, type_, ptr_, value_) do { \
+        char *copy_ = malloc(size_); \
+        mpc_snapshot_t bad_; \
+        memcpy(copy_, data_, size_); \
+        *(type_*)(copy_ + ((const char*)(ptr_) - (data_))) = (value_); \
+        assert(mpc_snapshot_open(&bad_, copy_, size_) == -1); \
+        assert(bad_.nb == 0 && !bad_.strings); \
+        free(copy_); \
+    } while (0)
+
+static void test_snapshot(void)
+{
+    const char *names[] = {"Alpha", "Beta", "Betelgeuse"};
+    mpc_snapshot_t snap;
+    char *data;
+    int size, found[4];
+    uint32_t strings_size;
+
+    data = test_make_snapshot(MPC_SNAPSHOT_ASTEROIDS, 3, names, &size);
+    assert(mpc_snapshot_is(data, size));
+    assert(mpc_snapshot_open(&snap, data, size) == 0);
+    assert(snap.type == MPC_SNAPSHOT_ASTEROIDS);
+    assert(snap.nb == 3 && snap.nb_keys == 3);
+    assert(snap.epoch[2] == 59000.5);
+    assert(snap.a[1] == 3.5f && snap.h[2] == 7.0f);
+    assert(snap.number[2] == 3);
+    assert(memcmp(snap.otype[1], "MBA", 4) == 0);
+    test_str(snap.strings + snap.name[1], "Beta");
+    test_str(snap.strings + snap.desig[1], "");
+
+    // Exact and prefix search.
+    found[0] = 0;
+    mpc_snapshot_search(&snap, "name beta", false, found, test_on_search);
+    assert(found[0] == 1 && found[1] == 1);
+    found[0] = 0;
+    mpc_snapshot_search(&snap, "name bet", true, found, test_on_search);
+    assert(found[0] == 2 && found[1] == 1 && found[2] == 2);
+    found[0] = 0;
+    mpc_snapshot_search(&snap, "name bet", false, found, test_on_search);
+    mpc_snapshot_search(&snap, "name x", true, found, test_on_search);
+    assert(found[0] == 0);
+
+    // Truncated data.
+    assert(mpc_snapshot_open(&snap, data, size - 1) == -1);
+    assert(mpc_snapshot_open(&snap, data, 64) == -1);
+    assert(mpc_snapshot_open(&snap, data, 16) == -1);
+
+    // Bad header and offsets.
+    assert(mpc_snapshot_open(&snap, data, size) == 0);
+    strings_size = ((uint32_t*)data)[5];
+    TEST_BAD_SNAPSHOT(data, size, uint32_t, data + 4, 2);
+    TEST_BAD_SNAPSHOT(data, size, uint32_t, data + 12, 0x80000000);
+    TEST_BAD_SNAPSHOT(data, size, uint32_t, data + 16, 0x80000000);
+    TEST_BAD_SNAPSHOT(data, size, uint32_t, data + 20, 0xffffffff);
+    TEST_BAD_SNAPSHOT(data, size, uint32_t, &snap.name[2], strings_size);
+    TEST_BAD_SNAPSHOT(data, size, uint32_t, &snap.desig[0], strings_size);
+    TEST_BAD_SNAPSHOT(data, size, uint32_t, &snap.keys[1], 0xffffffff);
+    TEST_BAD_SNAPSHOT(data, size, uint32_t, &snap.keys_body[2], 3);
+    TEST_BAD_SNAPSHOT(data, size, char, &snap.strings[strings_size - 1], 'x');
+    free(data);
+}
+
+static int test_on_prefix(void *user, const char *dsgn, obj_t *obj)
+{
+    (*(int*)user)++;
+    return 0;
+}
+
+static int test_on_list(void *user, obj_t *obj)
+{
+    (*(int*)user)++;
+    return 0;
+}
+
+// Load a snapshot in the minor planets module, and check that the objects
+// are only created when we search for them.
+static void test_snapshot_source(void)
+{
+    const char *names[] = {"Test Alpha", "Test Beta", "Test Betelgeuse"};
+    const char *url = "asset://test_asteroids.mpcs";
+    obj_t *module, *obj, *obj2, *tmp;
+    char *data, buf[64];
+    int size, nb;
+
+    core_init(100, 100, 1.0);
+    module = core_get_module("minor_planets");
+    data = test_make_snapshot(MPC_SNAPSHOT_ASTEROIDS, 3, names, &size);
+    asset_register(url, data, size, false);
+    module_add_data_source(module, url, "mpc_asteroids");
+    module_update(module, 0);
+    assert(!module->children);
+
+    obj = search_index_find("name test beta");
+    assert(obj && strcmp(obj->klass->id, "asteroid") == 0);
+    test_str(obj_get_name(obj, buf, sizeof(buf)), "Test Beta");
+    obj2 = search_index_find("NAME Test Beta");
+    assert(obj2 == obj);
+    obj_release(obj2);
+    assert(module->children == obj && !obj->next);
+
+    nb = 0;
+    assert(search_index_find_prefix("NAME TEST BET", 0, &nb,
+                                    test_on_prefix) == 2);
+    assert(nb == 2);
+    DL_COUNT(module->children, tmp, nb);
+    assert(nb == 2);
+
+    // Setting the source again releases all the created objects.
+    module_add_data_source(module, url, "mpc_asteroids");
+    assert(!obj->parent && obj->ref == 1);
+    assert(!search_index_find("NAME Test Beta"));
+    assert(!module->children);
+    obj_release(obj);
+
+    // And it gets loaded again on the next update.
+    module_update(module, 0);
+    obj = search_index_find("NAME Test Alpha");
+    assert(obj);
+    obj_release(obj);
+
+    // Listing only creates the objects brighter than the limit.
+    nb = 0;
+    module_list_objs(module, -100, 0, NULL, &nb, test_on_list);
+    assert(nb == 0);
+    DL_COUNT(module->children, tmp, nb);
+    assert(nb == 1);
+    nb = 0;
+    module_list_objs(module, NAN, 0, NULL, &nb, test_on_list);
+    assert(nb == 3);
+    DL_COUNT(module->children, tmp, nb);
+    assert(nb == 3);
+}
+
 TEST_REGISTER(NULL, test_parse_float, TEST_AUTO);
 TEST_REGISTER(NULL, test_parse_comet, TEST_AUTO);
+TEST_REGISTER(NULL, test_snapshot, TEST_AUTO);
+TEST_REGISTER(NULL, test_snapshot_source, TEST_AUTO);
 #endif
@@ -12,6 +12,7 @@
  */
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /*
  * Enum: MPC_ORBIT_TYPE
@@ -109,3 +110,98 @@ int mpc_parse_comet_line(const char *line, int len,
                          double *h,
                          double *g,
                          char   desig[static 64]);
+
+/*
+ * Enum: MPC_SNAPSHOT_TYPE
+ * Type of bodies of a <mpc_snapshot_t>.
+ */
+enum {
+    MPC_SNAPSHOT_ASTEROIDS = 0,
+    MPC_SNAPSHOT_COMETS    = 1,
+};
+
+/*
+ * Type: mpc_snapshot_t
+ * A binary snapshot of a MPC orbits file.
+ *
+ * The snapshots are created with tools/make-mpc-snapshot.py.  They contain
+ * the parsed orbits as a structure of arrays, so that they can be used
+ * directly from a memory mapped file, without any parsing.  All the values
+ * are little endian.  The layout is:
+ *
+ *   - A 32 bytes header: the magic 'MPCS', then the uint32 values version,
+ *     type, nb, nb_keys, and strings_size.
+ *   - One array of nb values for each of the bodies attributes, in the
+ *     order of the structure below.  The names and designations are
+ *     offsets in the strings table.
+ *   - The designations index: two arrays of nb_keys uint32 with the offset
+ *     of the designations and the index of their bodies, sorted by lower
+ *     case designation.
+ *   - The strings table: null terminated strings.
+ *
+ * Each array but the strings table is padded to a multiple of eight bytes.
+ *
+ * The angles are in radians and the distances in AU.  For the comets the
+ * epoch is the time of perihelion, the semi major axis is the perihelion
+ * distance, and the mean motion and mean anomaly are not used.
+ */
+typedef struct mpc_snapshot {
+    int             type;       // One of <MPC_SNAPSHOT_TYPE>.
+    int             nb;         // Number of bodies.
+    const double    *epoch;     // MJD TT.
+    const float     *i;         // Inclination.
+    const float     *node;      // Longitude of the ascending node.
+    const float     *peri;      // Argument of perihelion.
+    const float     *a;         // Semi major axis.
+    const float     *e;         // Eccentricity.
+    const float     *n;         // Mean daily motion (rad/day).
+    const float     *m;         // Mean anomaly at the epoch.
+    const float     *h;         // Absolute magnitude.
+    const float     *g;         // Slope parameter.
+    const int32_t   *number;    // Zero if the body has no number.
+    const uint32_t  *name;
+    const uint32_t  *desig;
+    const char      (*otype)[4];
+
+    int             nb_keys;
+    const uint32_t  *keys;
+    const uint32_t  *keys_body;
+    const char      *strings;
+} mpc_snapshot_t;
+
+/*
+ * Function: mpc_snapshot_open
+ * Setup a snapshot from its binary data.
+ *
+ * The snapshot points directly into the data, so the data has to stay
+ * valid as long as the snapshot is used.
+ *
+ * Return:
+ *   0 in case of success, an error code if the data is not a valid
+ *   snapshot.
+ */
+int mpc_snapshot_open(mpc_snapshot_t *snap, const void *data, int size);
+
+/*
+ * Function: mpc_snapshot_is
+ * Test if some data is a binary snapshot.
+ */
+bool mpc_snapshot_is(const void *data, int size);
+
+/*
+ * Function: mpc_snapshot_search
+ * Iterate the bodies having a given designation, using the index.
+ *
+ * The designations are compared case insensitively.
+ *
+ * Parameters:
+ *   snap   - A snapshot.
+ *   key    - A lower case designation.
+ *   prefix - If set, iterate all the designations starting with key.
+ *   user   - Data passed to the callback.
+ *   f      - Callback called with the body index and its designation.
+ *            If it returns a non zero value the iteration stops.
+ */
+void mpc_snapshot_search(const mpc_snapshot_t *snap, const char *key,
+                         bool prefix, void *user,
+                         int (*f)(void *user, int idx, const char *dsgn));
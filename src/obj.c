@@ -404,6 +404,13 @@ char *obj_get_json_data_str(const obj_t *obj)
     return ret;
 }
 
+// Called after an attribute value changed.
+static void attr_changed(obj_t *obj, const attribute_t *attr)
+{
+    if (attr->on_changed) attr->on_changed(obj, attr);
+    module_changed(obj, attr->name);
+}
+
 // XXX: cleanup this code.
 static json_value *obj_fn_default(obj_t *obj, const attribute_t *attr,
                                   const json_value *args)
@@ -452,8 +459,7 @@ static json_value *obj_fn_default(obj_t *obj, const attribute_t *attr,
                 if (o) o->ref++;
             }
             memcpy(p, buf, attr->member.size);
-            if (attr->on_changed) attr->on_changed(obj, attr);
-            module_changed(obj, attr->name);
+            attr_changed(obj, attr);
         }
         return NULL;
     }
@@ -542,25 +548,140 @@ char *obj_call_json_str(obj_t *obj, const char *attr, const char *args)
     return ret;
 }
 
-int obj_get_attr(const obj_t *obj, const char *name, ...)
+/*
+ * Return the base type of an attribute if we can access it directly as
+ * a struct member, without going through json, or 0 otherwise.
+ */
+EMSCRIPTEN_KEEPALIVE
+int obj_attr_get_direct_type(const attribute_t *attr)
+{
+    int type;
+    if (!attr || !attr->is_prop || attr->fn || !attr->member.size) return 0;
+    type = attr->type % 16;
+    switch (type) {
+    case TYPE_BOOL:
+        return attr->member.size == sizeof(bool) ? type : 0;
+    case TYPE_INT:
+        return attr->member.size == sizeof(int) ? type : 0;
+    case TYPE_FLOAT:
+        return (attr->member.size == sizeof(double) ||
+                attr->member.size == sizeof(float)) ? type : 0;
+    case TYPE_V2:
+        return attr->member.size == 2 * sizeof(double) ? type : 0;
+    case TYPE_V3:
+        return attr->member.size == 3 * sizeof(double) ? type : 0;
+    case TYPE_V4:
+        return attr->member.size == 4 * sizeof(double) ? type : 0;
+    default:
+        return 0;
+    }
+}
+
+static int obj_attr_vget(const obj_t *obj, const attribute_t *attr,
+                         va_list *ap)
 {
     json_value *ret;
+    const void *p = ((const void*)obj) + attr->member.offset;
+
+    switch (obj_attr_get_direct_type(attr)) {
+    case TYPE_BOOL:
+        *va_arg(*ap, bool*) = *(bool*)p;
+        return 0;
+    case TYPE_INT:
+        *va_arg(*ap, int*) = *(int*)p;
+        return 0;
+    case TYPE_FLOAT:
+        if (attr->member.size == sizeof(double))
+            *va_arg(*ap, double*) = *(double*)p;
+        else
+            *va_arg(*ap, double*) = *(float*)p;
+        return 0;
+    case TYPE_V2:
+    case TYPE_V3:
+    case TYPE_V4:
+        memcpy(va_arg(*ap, double*), p, attr->member.size);
+        return 0;
+    }
+
+    ret = (attr->fn ?: obj_fn_default)((obj_t*)obj, attr, NULL);
+    assert(ret);
+    args_vget(ret, attr->type, ap);
+    json_builder_free(ret);
+    return 0;
+}
+
+static int obj_attr_vset(const obj_t *obj, const attribute_t *attr,
+                         va_list *ap)
+{
+    json_value *arg, *ret;
+    void *p = ((void*)obj) + attr->member.offset;
+    bool b;
+    int i;
+    double f;
+    float ff;
+    const double *v;
+
+    switch (obj_attr_get_direct_type(attr)) {
+    case TYPE_BOOL:
+        b = va_arg(*ap, int);
+        if (*(bool*)p == b) return 0;
+        *(bool*)p = b;
+        attr_changed((obj_t*)obj, attr);
+        return 0;
+    case TYPE_INT:
+        i = va_arg(*ap, int);
+        if (*(int*)p == i) return 0;
+        *(int*)p = i;
+        attr_changed((obj_t*)obj, attr);
+        return 0;
+    case TYPE_FLOAT:
+        f = va_arg(*ap, double);
+        if (attr->member.size == sizeof(double)) {
+            if (memcmp(p, &f, sizeof(f)) == 0) return 0;
+            memcpy(p, &f, sizeof(f));
+        } else {
+            ff = f;
+            if (memcmp(p, &ff, sizeof(ff)) == 0) return 0;
+            memcpy(p, &ff, sizeof(ff));
+        }
+        attr_changed((obj_t*)obj, attr);
+        return 0;
+    case TYPE_V2:
+    case TYPE_V3:
+    case TYPE_V4:
+        v = va_arg(*ap, const double*);
+        if (memcmp(p, v, attr->member.size) == 0) return 0;
+        memcpy(p, v, attr->member.size);
+        attr_changed((obj_t*)obj, attr);
+        return 0;
+    }
+
+    arg = args_vvalue_new(attr->type, ap);
+    ret = (attr->fn ?: obj_fn_default)((obj_t*)obj, attr, arg);
+    json_builder_free(arg);
+    json_builder_free(ret);
+    return 0;
+}
+
+int obj_get_attr(const obj_t *obj, const char *name, ...)
+{
     const attribute_t *attr;
     va_list ap;
 
     attr = obj_get_attr_(obj, name);
+    if (!attr) {
+        LOG_E("Cannot find attribute %s of object %s", name, obj->id);
+        assert(false);
+        return -1;
+    }
     va_start(ap, name);
-    ret = obj_call_json(obj, name, NULL);
-    assert(ret);
-    args_vget(ret, attr->type, &ap);
-    json_builder_free(ret);
+    obj_attr_vget(obj, attr, &ap);
     va_end(ap);
     return 0;
 }
 
 int obj_set_attr(const obj_t *obj, const char *name, ...)
 {
-    json_value *arg, *ret;
     va_list ap;
     const attribute_t *attr;
 
@@ -568,16 +689,75 @@ int obj_set_attr(const obj_t *obj, const char *name, ...)
     if (!attr) {
         LOG_E("Unknow attribute %s", name);
         assert(false);
+        return -1;
     }
     va_start(ap, name);
-    arg = args_vvalue_new(attr->type, &ap);
-    ret = obj_call_json(obj, name, arg);
-    json_builder_free(arg);
-    json_builder_free(ret);
+    obj_attr_vset(obj, attr, &ap);
+    va_end(ap);
+    return 0;
+}
+
+int obj_attr_get(const obj_t *obj, const attribute_t *attr, ...)
+{
+    va_list ap;
+    assert(obj && attr);
+    va_start(ap, attr);
+    obj_attr_vget(obj, attr, &ap);
+    va_end(ap);
+    return 0;
+}
+
+int obj_attr_set(const obj_t *obj, const attribute_t *attr, ...)
+{
+    va_list ap;
+    assert(obj && attr);
+    va_start(ap, attr);
+    obj_attr_vset(obj, attr, &ap);
     va_end(ap);
     return 0;
 }
 
+EMSCRIPTEN_KEEPALIVE
+double obj_attr_get_number(const obj_t *obj, const attribute_t *attr)
+{
+    bool b;
+    int i;
+    double f;
+
+    switch (attr->type % 16) {
+    case TYPE_BOOL:
+        obj_attr_get(obj, attr, &b);
+        return b;
+    case TYPE_INT:
+        obj_attr_get(obj, attr, &i);
+        return i;
+    case TYPE_FLOAT:
+        obj_attr_get(obj, attr, &f);
+        return f;
+    default:
+        assert(false);
+        return NAN;
+    }
+}
+
+EMSCRIPTEN_KEEPALIVE
+void obj_attr_set_number(obj_t *obj, const attribute_t *attr, double v)
+{
+    switch (attr->type % 16) {
+    case TYPE_BOOL:
+        obj_attr_set(obj, attr, (bool)v);
+        break;
+    case TYPE_INT:
+        obj_attr_set(obj, attr, (int)v);
+        break;
+    case TYPE_FLOAT:
+        obj_attr_set(obj, attr, v);
+        break;
+    default:
+        assert(false);
+    }
+}
+
 void obj_register_(obj_klass_t *klass)
 {
     assert(klass->size);
@@ -715,6 +895,7 @@ static void test_simple(void)
 {
     test_t test = {};
     double alt;
+    const attribute_t *attr;
 
     test.obj.klass = &test_klass;
     test.alt = 10.0;
@@ -730,6 +911,22 @@ static void test_simple(void)
     assert(test.nb_changes == 1);
     obj_set_attr(&test.obj, "my_attr", 30.0);
     assert(test.nb_changes == 2);
+
+    // Same thing using attribute handles.
+    attr = obj_get_attr_(&test.obj, "my_attr");
+    assert(obj_attr_get_direct_type(attr) == TYPE_FLOAT);
+    obj_attr_set(&test.obj, attr, 30.0);
+    assert(test.nb_changes == 2);
+    obj_attr_set_number(&test.obj, attr, 40.0);
+    assert(test.my_attr == 40.0 && test.nb_changes == 3);
+    obj_attr_get(&test.obj, attr, &alt);
+    assert(alt == 40.0);
+    attr = obj_get_attr_(&test.obj, "projection");
+    obj_attr_set_number(&test.obj, attr, 2);
+    assert(test.proj == 2);
+    assert(obj_attr_get_number(&test.obj, attr) == 2);
+    attr = obj_get_attr_(&test.obj, "lookat");
+    assert(obj_attr_get_direct_type(attr) == 0);
 }
 
 TEST_REGISTER(NULL, test_simple, TEST_AUTO);
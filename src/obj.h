@@ -46,11 +46,14 @@
  * OBJ_LISTABLE         - For modules that maintain a list of children objects,
  *                        like comets, this allows obj_list to directly do
  *                        the listing.
+ * OBJ_INDEXED          - For modules that add all their children in the
+ *                        search index (see <search_index.h>).
  */
 enum {
     OBJ_IN_JSON_TREE = 1 << 0,
     OBJ_MODULE       = 1 << 1,
     OBJ_LISTABLE     = 1 << 2,
+    OBJ_INDEXED      = 1 << 3,
 };
 
 typedef struct _json_value json_value;
@@ -439,6 +442,54 @@ int obj_get_attr(const obj_t *obj, const char *attr, ...);
  */
 int obj_set_attr(const obj_t *obj, const char *attr, ...);
 
+/*
+ * Function: obj_attr_get
+ * Same as <obj_get_attr>, but using an attribute handle.
+ *
+ * The handle is the <attribute_t> pointer returned by <obj_get_attr_>, and
+ * can be kept to skip the name lookup.  Properties that map directly to a
+ * boolean, integer, float or vector struct member are read without any
+ * json conversion.
+ *
+ * Parameters:
+ *   obj    - An object.
+ *   attr   - An attribute of the object class.
+ *   ...    - Pointer to the output value.
+ */
+int obj_attr_get(const obj_t *obj, const attribute_t *attr, ...);
+
+/*
+ * Function: obj_attr_set
+ * Same as <obj_set_attr>, but using an attribute handle.
+ *
+ * Parameters:
+ *   obj    - An object.
+ *   attr   - An attribute of the object class.
+ *   ...    - The new value.
+ */
+int obj_attr_set(const obj_t *obj, const attribute_t *attr, ...);
+
+/*
+ * Function: obj_attr_get_direct_type
+ * Return the base type of a property if <obj_attr_get> and <obj_attr_set>
+ * access it directly as a struct member, or zero otherwise.
+ */
+int obj_attr_get_direct_type(const attribute_t *attr);
+
+/*
+ * Function: obj_attr_get_number
+ * Get the value of a boolean, integer or float attribute as a double.
+ *
+ * Mostly for the javascript binding, that cannot use variadic functions.
+ */
+double obj_attr_get_number(const obj_t *obj, const attribute_t *attr);
+
+/*
+ * Function: obj_attr_set_number
+ * Set the value of a boolean, integer or float attribute from a double.
+ */
+void obj_attr_set_number(obj_t *obj, const attribute_t *attr, double v);
+
 
 /*
  * Function: obj_has_attr
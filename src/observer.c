@@ -39,6 +39,7 @@ static void update_matrices(observer_t *obs)
     double ri2e[3][3];  // Equatorial J2000 (ICRF) to ecliptic.
     double re2i[3][3];  // Eclipic to Equatorial J2000 (ICRF).
     double rc2v[3][3];
+    double rc2h[3][3];
     double view_rot[3][3];
 
     quat_to_mat3(obs->mount_quat, ro2m);
@@ -83,10 +84,10 @@ static void update_matrices(observer_t *obs)
     mat3_rx(eraObl80(DJM0, obs->ut1), re2i, re2i);
     mat3_invert(re2i, ri2e);
 
-    // ICRF to view (ignoring refraction).
-    mat3_transpose(astrom->bpn, rc2v);
-    mat3_mul(ri2h, rc2v, rc2v);
-    mat3_mul(ro2v, rc2v, rc2v);
+    // ICRF to horizontal, and to view (ignoring refraction).
+    mat3_transpose(astrom->bpn, rc2h);
+    mat3_mul(ri2h, rc2h, rc2h);
+    mat3_mul(ro2v, rc2h, rc2v);
 
     // Copy all
     mat3_copy(ro2m, obs->ro2m);
@@ -98,6 +99,7 @@ static void update_matrices(observer_t *obs)
     mat3_copy(ri2e, obs->ri2e);
     mat3_copy(re2i, obs->re2i);
     mat3_copy(rc2v, obs->rc2v);
+    mat3_copy(rc2h, obs->rc2h);
 }
 
 static void observer_compute_hash(observer_t *obs, uint64_t* hash_partial,
@@ -186,7 +188,8 @@ void observer_update(observer_t *obs, bool fast)
         // Update earth position.
         eraCp(obs->astrom.eb, obs->obs_pvb[0]);
         vec3_mul(ERFA_DC, obs->astrom.v, obs->obs_pvb[1]);
-        eraPvmpv(obs->obs_pvb, obs->earth_pvb, obs->obs_pvg);
+        vec3_sub(obs->obs_pvb[0], obs->earth_pvb[0], obs->obs_pvg[0]);
+        vec3_sub(obs->obs_pvb[1], obs->earth_pvb[1], obs->obs_pvg[1]);
         // Update refraction constants.
         refraction_prepare(obs->pressure, 15, 0.5, &obs->refa, &obs->refb);
     }
@@ -207,14 +210,16 @@ void observer_update(observer_t *obs, bool fast)
         eraSxp(ERFA_DAYSEC / DAU, obs->obs_pvg[1], obs->obs_pvg[1]);
 
         // Compute the observer's barycentric position
-        eraPvppv(obs->earth_pvb, obs->obs_pvg, obs->obs_pvb);
+        vec3_add(obs->earth_pvb[0], obs->obs_pvg[0], obs->obs_pvb[0]);
+        vec3_add(obs->earth_pvb[1], obs->obs_pvg[1], obs->obs_pvb[1]);
     }
 
     update_matrices(obs);
     if (!fast) update_nutation_precession_mat(obs);
 
     // Compute sun's apparent position in observer reference frame
-    eraPvmpv(obs->sun_pvb, obs->obs_pvb, obs->sun_pvo);
+    vec3_sub(obs->sun_pvb[0], obs->obs_pvb[0], obs->sun_pvo[0]);
+    vec3_sub(obs->sun_pvb[1], obs->obs_pvb[1], obs->sun_pvo[1]);
     // Correct in one shot space motion, annual & diurnal abberrations
     correct_speed_of_light(obs->sun_pvo);
 
@@ -108,6 +108,7 @@ struct observer
     double re2i[3][3];  // Eclipic to Equatorial J2000 (ICRF).
     double rnp[3][3];   // Nutation/Precession rotation.
     double rc2v[3][3];  // Equatorial J2000 (ICRS) to view (no refraction).
+    double rc2h[3][3];  // Equatorial J2000 (ICRS) to horizontal.
 };
 
 void observer_update(observer_t *obs, bool fast);
@@ -15,6 +15,36 @@
 
 static bool g_debug = false;
 
+// Size of the healpix clipping tests cache (must be a power of two).
+#define CLIP_CACHE_SIZE 4096
+// Number of points converted and projected together by
+// painter_project_many.
+#define PAINTER_PROJECT_CHUNK 256
+
+/*
+ * Cache of the healpix clipping tests results.
+ *
+ * Each call to painter_update_clip_info gives a new id to the painter, and
+ * the entries are only valid for painters with the same id, so the cache
+ * is implicitly cleared every frame.
+ */
+static struct {
+    uint64_t    id; // Last given id, never wraps back to zero in practice.
+    struct {
+        uint64_t    key;
+        uint64_t    id;
+        bool        clipped;
+    } entries[CLIP_CACHE_SIZE];
+    uint64_t    nb_tests;
+    uint64_t    nb_saved;
+} g_clip_cache = {};
+
+/*
+ * Scratch arena used by paint_line to tesselate the lines, so that we don't
+ * allocate memory for each line.
+ */
+static line_tesselator_t g_line_tess = {};
+
 #define REND(rend, f, ...) do { \
         if ((rend)->f) (rend)->f((rend), ##__VA_ARGS__); \
     } while (0)
@@ -128,6 +158,7 @@ void painter_update_clip_info(painter_t *painter)
         compute_viewport_cap(painter, i);
         compute_sky_cap(painter->obs, i, painter->clip_info[i].sky_cap);
     }
+    painter->clip_id = ++g_clip_cache.id;
 }
 
 int paint_prepare(painter_t *painter, double win_w, double win_h,
@@ -296,9 +327,8 @@ int paint_line(const painter_t *painter,
                double line[2][4], const uv_map_t *map,
                int split, int flags)
 {
-    int i, size;
+    int i, size, ofs;
     double view_pos[2][4];
-    double (*win_line)[3] = NULL;
     bool discontinuous = false;
     double splits[2][2][4];
 
@@ -321,12 +351,13 @@ int paint_line(const painter_t *painter,
     if (discontinuous)
         goto split;
 
-    size = line_tesselate(line_func, painter->proj,
-                          USER_PASS(painter, &frame, line, map),
-                          split, &win_line);
-    if (size < 0) goto split;
-    REND(painter->rend, line, painter, win_line, size);
-    free(win_line);
+    size = line_tesselator_add(&g_line_tess, line_func, painter->proj,
+                               USER_PASS(painter, &frame, line, map),
+                               split, &ofs);
+    REND(painter->rend, line, painter,
+         (const double (*)[3])g_line_tess.points + ofs, size);
+    // The renderer copies the points, so we can reuse the arena.
+    g_line_tess.nb = ofs;
     return 0;
 
 split:
@@ -342,6 +373,13 @@ split:
     return 0;
 }
 
+int paint_projected_line(const painter_t *painter, int size,
+                         const double (*win_line)[3])
+{
+    REND(painter->rend, line, painter, win_line, size);
+    return 0;
+}
+
 /*
  * Function: paint_mesh
  * Render a 3d mesh
@@ -375,6 +413,11 @@ int paint_mesh(const painter_t *painter_, int frame, int mode,
         }
     }
 
+    if (painter.rend->mesh_retained &&
+            painter.rend->mesh_retained(painter.rend, &painter, frame, mode,
+                                        mesh, use_stencil))
+        return 0;
+
     switch (mode) {
     case MODE_TRIANGLES:
         REND(painter.rend, mesh, &painter, frame, mode,
@@ -561,8 +604,47 @@ bool painter_is_healpix_clipped(const painter_t *painter, int frame,
                                 int order, int pix, bool outside)
 {
     uv_map_t map;
+    uint64_t key;
+    bool hide_below_horizon, clipped;
+    typeof(g_clip_cache.entries[0]) *entry = NULL;
+
+    // The result only depends on the clip info, the projection, and the
+    // below horizon flag, so we can reuse it for the whole frame.
+    if (painter->clip_id && order <= 24) {
+        hide_below_horizon = painter->flags & PAINTER_HIDE_BELOW_HORIZON;
+        key = ((pix + 4 * (1ULL << (2 * order))) << 5) | (frame << 2) |
+              (outside << 1) | hide_below_horizon;
+        entry = &g_clip_cache.entries[
+            (key * 11400714819323198485ULL >> 32) % CLIP_CACHE_SIZE];
+        g_clip_cache.nb_tests++;
+        if (entry->id == painter->clip_id && entry->key == key) {
+            g_clip_cache.nb_saved++;
+            return entry->clipped;
+        }
+    }
+
     uv_map_init_healpix(&map, order, pix, false, false);
-    return painter_is_quad_clipped(painter, frame, &map, outside);
+    clipped = painter_is_quad_clipped(painter, frame, &map, outside);
+    if (entry) {
+        entry->key = key;
+        entry->id = painter->clip_id;
+        entry->clipped = clipped;
+    }
+    return clipped;
+}
+
+void painter_get_clip_cache_stats(uint64_t *nb_tests, uint64_t *nb_saved)
+{
+    *nb_tests = g_clip_cache.nb_tests;
+    *nb_saved = g_clip_cache.nb_saved;
+}
+
+void painter_get_lines_stats(uint64_t *nb_lines, uint64_t *nb_points,
+                             uint64_t *nb_evals)
+{
+    *nb_lines = g_line_tess.nb_lines;
+    *nb_points = g_line_tess.nb_points;
+    *nb_evals = g_line_tess.nb_evals;
 }
 
 /* Draw the contour lines of a shape.
@@ -895,6 +977,58 @@ bool painter_project(const painter_t *painter, int frame,
     return ret;
 }
 
+// Convert and project a chunk of points gathered by painter_project_many.
+static int project_chunk(const painter_t *painter, int frame, bool at_inf,
+                         int n, double (*p)[3], const int *idx,
+                         double (*win_pos)[2], bool *visible)
+{
+    double v[PAINTER_PROJECT_CHUNK][4];
+    int i, ret;
+    const int flags = (at_inf ? PROJ_ALREADY_NORMALIZED : 0) |
+                      PROJ_TO_WINDOW_SPACE;
+
+    convert_frame_many(painter->obs, frame, FRAME_VIEW, at_inf, n, p, p);
+    for (i = 0; i < n; i++) {
+        vec3_copy(p[i], v[i]);
+        v[i][3] = 1.0;
+    }
+    ret = project_many(painter->proj, flags, n, v, v);
+    for (i = 0; i < n; i++) {
+        vec2_copy(v[i], win_pos[idx[i]]);
+        visible[idx[i]] = v[i][3] != 0.0;
+    }
+    return ret;
+}
+
+int painter_project_many(const painter_t *painter, int frame, int n,
+                         const double (*pos)[3], bool at_inf,
+                         bool clip_first, double (*win_pos)[2],
+                         bool *visible)
+{
+    PROFILE(painter_project_many, PROFILE_AGGREGATE);
+    double p[PAINTER_PROJECT_CHUNK][3];
+    int idx[PAINTER_PROJECT_CHUNK];
+    int i, nb = 0, ret = 0;
+
+    for (i = 0; i < n; i++) {
+        visible[i] = false;
+        if (clip_first &&
+                painter_is_point_clipped_fast(painter, frame, pos[i], at_inf))
+            continue;
+        vec3_copy(pos[i], p[nb]);
+        idx[nb++] = i;
+        if (nb == PAINTER_PROJECT_CHUNK) {
+            ret += project_chunk(painter, frame, at_inf, nb, p, idx,
+                                 win_pos, visible);
+            nb = 0;
+        }
+    }
+    if (nb)
+        ret += project_chunk(painter, frame, at_inf, nb, p, idx,
+                             win_pos, visible);
+    return ret;
+}
+
 bool painter_unproject(const painter_t *painter, int frame,
                      const double win_pos[2], double pos[3]) {
     double p[4];
@@ -126,6 +126,17 @@ struct renderer
                  const uint16_t      indices[],
                  bool                use_stencil);
 
+    // Render a mesh keeping a copy of its vertices in the renderer, so that
+    // they don't have to be projected again at each frame.  Optional, and
+    // can return false if the frame or projection is not supported, in
+    // which case we fall back to the mesh function.
+    bool (*mesh_retained)(renderer_t         *rend,
+                          const painter_t    *painter,
+                          int                frame,
+                          int                mode,
+                          const mesh_t       *mesh,
+                          bool               use_stencil);
+
     void (*ellipse_2d)(renderer_t       *rend,
                        const painter_t  *painter,
                        const double     pos[2],
@@ -164,6 +175,11 @@ struct point
     double  size;       // Radius in window pixel (pixel with density scale).
     uint8_t color[4];
     obj_t   *obj;
+    // Can be set instead of obj, so that the object is only created if
+    // the point gets picked.  See <areas_add_circle_lazy>.
+    obj_t   *(*get_obj)(void *user, uint64_t id);
+    void    *get_obj_user;
+    uint64_t get_obj_id;
 };
 
 // Painter flags
@@ -229,6 +245,7 @@ struct painter
         // take refraction into account).
         double sky_cap[4];
     } clip_info[FRAMES_NB];
+    uint64_t clip_id; // Set by painter_update_clip_info, used for caching.
 
     union {
         // For planet rendering only.
@@ -366,6 +383,18 @@ int paint_line(const painter_t *painter,
                double line[2][4], const uv_map_t *map,
                int split, int flags);
 
+/*
+ * Function: paint_projected_line
+ * Render a line already projected in windows coordinates.
+ *
+ * Parameters:
+ *   painter    - A painter instance.
+ *   size       - Number of points in the line.
+ *   win_line   - The line points in windows coordinates (Z is the depth).
+ */
+int paint_projected_line(const painter_t *painter, int size,
+                         const double (*win_line)[3]);
+
 /*
  * Function: paint_mesh
  * Render a 3d mesh
@@ -462,6 +491,32 @@ bool painter_is_quad_clipped(const painter_t *painter, int frame,
 bool painter_is_healpix_clipped(const painter_t *painter, int frame,
                                 int order, int pix, bool outside);
 
+/*
+ * Function: painter_get_clip_cache_stats
+ * Return the number of cached healpix clipping tests since the start.
+ *
+ * The results of <painter_is_healpix_clipped> are cached for each call to
+ * <painter_update_clip_info>, so the modules that traverse the same
+ * healpix pixels in the same frame only compute them once.
+ *
+ * Parameters:
+ *   nb_tests   - Number of tests that went through the cache.
+ *   nb_saved   - Number of tests that were found in the cache.
+ */
+void painter_get_clip_cache_stats(uint64_t *nb_tests, uint64_t *nb_saved);
+
+/*
+ * Function: painter_get_lines_stats
+ * Return the number of lines tesselated by <paint_line> since the start.
+ *
+ * Parameters:
+ *   nb_lines   - Number of tesselated lines.
+ *   nb_points  - Total number of points of the tesselated lines.
+ *   nb_evals   - Total number of evaluated and projected samples.
+ */
+void painter_get_lines_stats(uint64_t *nb_lines, uint64_t *nb_points,
+                             uint64_t *nb_evals);
+
 // Function: painter_is_point_clipped_fast
 //
 // Convenience function that checks if a 3D point is visible.
@@ -668,6 +723,34 @@ void painter_project_ellipse(const painter_t *painter, int frame,
 bool painter_project(const painter_t *painter, int frame, const double pos[3],
                      bool at_inf, bool clip_first, double win_pos[2]);
 
+/*
+ * Function: painter_project_many
+ * Project a list of points defined on the sphere to the screen.
+ *
+ * Same as calling <painter_project> on each point, but the frame
+ * conversions and the projection are done by chunks with
+ * <convert_frame_many> and <project_many>.
+ *
+ * Parameters:
+ *   painter    - The painter.
+ *   frame      - The frame in which the points are defined.
+ *   n          - Number of points.
+ *   pos        - The points 3D coordinates.
+ *   at_inf     - true for fixed objects (far away from the solar system).
+ *                For such objects, pos is assumed to be normalized.
+ *   clip_first - If a point is identified as clipped, skip its projection.
+ *                Its win_pos content is then undefined.
+ *   win_pos    - The points positions in screen coordinates (px).
+ *   visible    - Set to false for the clipped points, true otherwise.
+ *
+ * Returns:
+ *   The number of visible points.
+ */
+int painter_project_many(const painter_t *painter, int frame, int n,
+                         const double (*pos)[3], bool at_inf,
+                         bool clip_first, double (*win_pos)[2],
+                         bool *visible);
+
 
 /*
  * Function: painter_unproject
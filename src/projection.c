@@ -11,12 +11,17 @@
 #include "profiler.h"
 
 #include "tests.h"
+#include "utils/utils.h"
 #include "utils/vec.h"
 
 #include <assert.h>
 #include <math.h>
 #include <string.h>
 
+// Number of points processed together by project_many, so that we can keep
+// the view space z values when the output overwrites the input.
+#define PROJECT_MANY_CHUNK 64
+
 
 /* Degrees to radians */
 #define DD2R (1.745329251994329576923691e-2)
@@ -133,3 +138,100 @@ bool project(const projection_t *proj, int flags,
     memcpy(out, p, 4 * sizeof(double));
     return visible;
 }
+
+int project_many(const projection_t *proj, int flags, int n,
+                 const double (*v)[4], double (*out)[4])
+{
+    PROFILE(project_many, PROFILE_AGGREGATE);
+    double z[PROJECT_MANY_CHUNK], *p;
+    int i, j, nb, ret = 0;
+    bool visible;
+
+    assert(!(flags & PROJ_BACKWARD));
+    assert(proj->project);
+    for (i = 0; i < n; i += PROJECT_MANY_CHUNK) {
+        nb = min(PROJECT_MANY_CHUNK, n - i);
+        for (j = 0; j < nb; j++) z[j] = v[i + j][2];
+        if (proj->project_many) {
+            proj->project_many(proj, flags, nb, v + i, out + i);
+        } else {
+            for (j = 0; j < nb; j++)
+                proj->project(proj, flags, v[i + j], out[i + j]);
+        }
+        for (j = 0; j < nb; j++) {
+            p = out[i + j];
+            if (proj->flags & PROJ_FLIP_HORIZONTAL) p[0] = -p[0];
+            if (proj->flags & PROJ_FLIP_VERTICAL)   p[1] = -p[1];
+            if (!(flags & (PROJ_TO_NDC_SPACE | PROJ_TO_WINDOW_SPACE)))
+                continue;
+            assert(!(proj->flags & PROJ_NO_CLIP));
+            visible = (p[0] >= -p[3] && p[0] < +p[3] &&
+                       p[1] >= -p[3] && p[1] < +p[3] &&
+                       p[2] >= -p[3] && p[2] < +p[3]);
+            if (p[3])
+                vec3_mul(1.0 / p[3], p, p);
+            p[3] = visible ? 1.0 : 0.0;
+            if (flags & PROJ_TO_WINDOW_SPACE) {
+                p[0] = (+p[0] + 1) / 2 * proj->window_size[0];
+                p[1] = (-p[1] + 1) / 2 * proj->window_size[1];
+                p[2] = -z[j];
+            }
+            ret += visible ? 1 : 0;
+        }
+    }
+    if (!(flags & (PROJ_TO_NDC_SPACE | PROJ_TO_WINDOW_SPACE))) return n;
+    return ret;
+}
+
+/******** TESTS ***********************************************************/
+
+#if COMPILE_TESTS
+
+// Check that project_many gives the same result as project on each point.
+static void test_project_many(void)
+{
+    const int types[] = {PROJ_PERSPECTIVE, PROJ_STEREOGRAPHIC};
+    const int flags_list[] = {0, PROJ_TO_NDC_SPACE, PROJ_TO_WINDOW_SPACE,
+                              PROJ_ALREADY_NORMALIZED | PROJ_TO_WINDOW_SPACE};
+    const int proj_flags[] = {0, PROJ_FLIP_HORIZONTAL | PROJ_FLIP_VERTICAL};
+    enum { N = 200 };
+    projection_t proj;
+    double v[N][4], out[N][4], inplace[N][4], ref[4];
+    int t, f, pf, i, j, flags, nb_visible;
+
+    for (t = 0; t < ARRAY_SIZE(types); t++)
+    for (f = 0; f < ARRAY_SIZE(flags_list); f++)
+    for (pf = 0; pf < ARRAY_SIZE(proj_flags); pf++) {
+        projection_init(&proj, types[t], 90 * DD2R, 800, 600);
+        proj.flags = proj_flags[pf];
+        flags = flags_list[f];
+        for (i = 0; i < N; i++) {
+            v[i][0] = sin(i * 1.3);
+            v[i][1] = cos(i * 0.7);
+            v[i][2] = sin(i * 2.1 + 0.5);
+            v[i][3] = 1.0;
+            if (i == 0) vec3_set(v[i], 0, 0, 1); // Discontinuity point.
+            if (i == 1) vec3_set(v[i], 0, 0, -1); // Center of the view.
+            if (flags & PROJ_ALREADY_NORMALIZED) vec3_normalize(v[i], v[i]);
+        }
+        memcpy(inplace, v, sizeof(v));
+        nb_visible = 0;
+        assert(project_many(&proj, flags, N, v, out) ==
+               project_many(&proj, flags, N, inplace, inplace));
+        for (i = 0; i < N; i++) {
+            if (project(&proj, flags, v[i], ref)) nb_visible++;
+            for (j = 0; j < 4; j++) {
+                assert(fabs(out[i][j] - ref[j]) <= 1e-9 * (1 + fabs(ref[j])));
+                assert(inplace[i][j] == out[i][j]);
+            }
+        }
+        if (flags & (PROJ_TO_NDC_SPACE | PROJ_TO_WINDOW_SPACE)) {
+            assert(nb_visible > 0 && nb_visible < N);
+            assert(project_many(&proj, flags, N, v, out) == nb_visible);
+        }
+    }
+}
+
+TEST_REGISTER(NULL, test_project_many, TEST_AUTO);
+
+#endif
@@ -85,6 +85,9 @@ struct projection
                     const double v[S 4], double out[S 4]);
     bool (*backward)(const projection_t *proj, int flags,
                      const double v[S 2], double out[4]);
+    // Optional version of project for a list of points.
+    void (*project_many)(const projection_t *proj, int flags, int n,
+                         const double (*v)[4], double (*out)[4]);
 };
 
 /*
@@ -136,6 +139,28 @@ void projection_init(projection_t *proj, int type, double fovx,
 bool project(const projection_t *proj, int flags,
              const double v[S 4], double out[S 4]);
 
+/* Function: project_many
+ * Apply a forward projection to a list of coordinates
+ *
+ * Same as calling <project> on each point, but the projection function is
+ * only dispatched once for the whole list.  The PROJ_BACKWARD flag is not
+ * supported.
+ *
+ * Parameters:
+ *  proj    - A projection.
+ *  flags   - Union of <PROJ_FLAGS> values.
+ *  n       - Number of points.
+ *  v       - Input coordinates as homogenous coordinates.
+ *  out     - Output coordinates.  Can be the same as the input.  If we
+ *            project to NDC or window space, the w component is set to 1
+ *            for the visible points and 0 for the others.
+ *
+ * Return:
+ *  The number of visible points.
+ */
+int project_many(const projection_t *proj, int flags, int n,
+                 const double (*v)[4], double (*out)[4]);
+
 #undef S
 
 #endif // PROJECTION_H
@@ -20,6 +20,22 @@ static void proj_perspective_project(
     mat4_mul_vec4((void*)proj->mat, v4, out);
 }
 
+static void proj_perspective_project_many(
+        const projection_t *proj, int flags, int n,
+        const double (*v)[4], double (*out)[4])
+{
+    const double (*m)[4] = proj->mat;
+    double x, y, z;
+    int i, j;
+    for (i = 0; i < n; i++) {
+        x = v[i][0];
+        y = v[i][1];
+        z = v[i][2];
+        for (j = 0; j < 4; j++)
+            out[i][j] = m[0][j] * x + m[1][j] * y + m[2][j] * z + m[3][j];
+    }
+}
+
 static bool proj_perspective_backward(const projection_t *proj, int flags,
         const double v[2], double out[4])
 {
@@ -42,6 +58,7 @@ void proj_perspective_init(projection_t *p, double fov, double aspect)
     p->max_fov = 120. * DD2R;
     p->project = proj_perspective_project;
     p->backward = proj_perspective_backward;
+    p->project_many = proj_perspective_project_many;
     p->scaling[0] = tan(fov / 2);
     p->scaling[1] = p->scaling[0] / aspect;
 }
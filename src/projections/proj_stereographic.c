@@ -56,6 +56,45 @@ static void proj_stereographic_project(
     out[3] = 1.0; // w value.
 }
 
+/*
+ * Same as proj_stereographic_project for a list of points.  The flags test
+ * and the scaling are hoisted out of the loops, and the discontinuity case
+ * is handled without branching, so that the compiler can vectorize the
+ * loops.
+ */
+static void proj_stereographic_project_many(
+        const projection_t *proj, int flags, int n,
+        const double (*v)[4], double (*out)[4])
+{
+    const double sx = proj->scaling[0], sy = proj->scaling[1];
+    double x, y, z, l, h, k;
+    int i;
+
+    if (!(flags & PROJ_ALREADY_NORMALIZED)) {
+        for (i = 0; i < n; i++) {
+            x = v[i][0];
+            y = v[i][1];
+            z = v[i][2];
+            l = 1.0 / sqrt(x * x + y * y + z * z);
+            out[i][0] = x * l;
+            out[i][1] = y * l;
+            out[i][2] = z * l;
+        }
+        v = (const double (*)[4])out;
+    }
+    for (i = 0; i < n; i++) {
+        x = v[i][0];
+        y = v[i][1];
+        h = 0.5 * (1.0 - v[i][2]);
+        // h is zero for the discontinuity point (0, 0, 1).
+        k = h ? 1.0 / h : 0.0;
+        out[i][0] = x * (k / sx);
+        out[i][1] = y * (k / sy);
+        out[i][2] = 0.0;
+        out[i][3] = h ? 1.0 : 0.0;
+    }
+}
+
 static bool proj_stereographic_backward(const projection_t *proj, int flags,
                                         const double v[2], double out[4])
 {
@@ -90,6 +129,7 @@ void proj_stereographic_init(projection_t *p, double fovx, double aspect)
     p->max_fov       = 185. * DD2R;
     p->project       = proj_stereographic_project;
     p->backward      = proj_stereographic_backward;
+    p->project_many  = proj_stereographic_project_many;
     p->scaling[0]    = 2 * tan(fovx / 4);
     p->scaling[1]    = p->scaling[0] / aspect;
 }
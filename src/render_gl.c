@@ -24,6 +24,12 @@
 #include <float.h>
 
 #define GRID_CACHE_SIZE (2 * (1 << 20))
+// Max size of the meshes kept in GPU buffers (bytes).
+#define MESHES_CACHE_SIZE (16 * (1 << 20))
+// Initial size of the streaming vertex and index buffers (bytes).
+#define STREAM_BUF_SIZE (1 << 20)
+// Size of the text atlas textures (pixels).
+#define TEXT_ATLAS_SIZE 1024
 
 // Fix GL_PROGRAM_POINT_SIZE support on Mac.
 #ifdef __APPLE__
@@ -61,20 +67,53 @@ static const char *ATTR_NAMES[] = {
     NULL,
 };
 
-// We keep all the text textures in a cache so that we don't have to recreate
-// them each time.
-typedef struct tex_cache tex_cache_t;
-struct tex_cache {
-    tex_cache_t *next, *prev;
-    double      size;
-    char        *text;
-    int         effects;
-    bool        in_use;
-    int         xoff;
-    int         yoff;
+/*
+ * Text atlas.
+ *
+ * The strings rendered by the system text callback are packed into a few
+ * shared textures (pages), so that we only rasterize them once, and all the
+ * labels using the same page can be rendered in a single draw call.
+ *
+ * The strings are packed by rows, and only the last page accepts new
+ * strings.  After each frame, the other pages that are mostly unused get
+ * deleted, their strings will be added back into the last page if needed.
+ */
+typedef struct text_page text_page_t;
+struct text_page {
+    text_page_t *next, *prev;
     texture_t   *tex;
+    int         row_x, row_y, row_h;    // Current packing row.
+    int         used_area;              // Area used by the last frame.
+};
+
+typedef struct text_entry text_entry_t;
+struct text_entry {
+    UT_hash_handle  hh;
+    char            *key;       // Size, scale, effects and text.
+    text_page_t     *page;
+    int             x, y, w, h; // Position in the page texture.
+    int             xoff, yoff;
+    int             last_used;  // Frame of the last use.
 };
 
+/*
+ * Type: gpu_mesh_t
+ * A mesh uploaded once into GL buffers, with the vertices in their original
+ * frame, so that they can be reused as long as the mesh doesn't change.
+ * Stored in the renderer meshes cache.
+ */
+typedef struct gpu_mesh {
+    GLuint  vertices;
+    GLuint  indices;
+    int     indices_count;
+} gpu_mesh_t;
+
+// Key of the gpu meshes in the cache.
+typedef struct gpu_mesh_key {
+    uint32_t    id;     // Mesh unique id.
+    int         mode;   // MODE_TRIANGLES, MODE_LINES or MODE_POINTS.
+} gpu_mesh_key_t;
+
 enum {
     ITEM_LINES = 1,
     ITEM_MESH,
@@ -161,7 +200,19 @@ struct item
             // Projection setttings.  Should be set globally probably.
             int proj;
             float proj_scaling[2];
+            float proj_mat[16];
+            float proj_flip[2];
+            float rot[9];       // Rotation applied in the shader.
             bool use_stencil;
+            // Only for the meshes retained in GL buffers.
+            const gpu_mesh_t *gpu;
+            gpu_mesh_key_t gpu_key;
+            // Set if the previous item is a retained mesh with the same
+            // color, mode and stencil state, so that we keep its stencil.
+            bool batched;
+            bool refraction;    // Set if rot goes to the observed frame.
+            float ro2v[9];
+            float refraction_coef;
         } mesh;
 
         struct {
@@ -217,6 +268,15 @@ static const gl_buf_info_t POINTS_BUF = {
     },
 };
 
+static const gl_buf_info_t TEXT_BUF = {
+    .size = 20,
+    .attrs = {
+        [ATTR_POS]      = {GL_FLOAT, 2, false, 0},
+        [ATTR_TEX_POS]  = {GL_FLOAT, 2, false, 8},
+        [ATTR_COLOR]    = {GL_UNSIGNED_BYTE, 4, true, 16},
+    },
+};
+
 static const gl_buf_info_t TEXTURE_BUF = {
     .size = 24,
     .attrs = {
@@ -254,6 +314,21 @@ static const gl_buf_info_t FOG_BUF = {
     },
 };
 
+/*
+ * Type: stream_buf_t
+ * A GL buffer we upload the items data into, one after the other.
+ *
+ * When the buffer is full we orphan it with glBufferData and restart from
+ * the beginning, so that the driver can give us new memory without waiting
+ * for the draw calls that still use the old data.
+ */
+typedef struct stream_buf {
+    GLuint  id;
+    GLenum  target;
+    int     size;   // Allocated size (bytes).
+    int     ofs;    // Current write offset (bytes).
+} stream_buf_t;
+
 typedef struct renderer_gl {
     renderer_t  rend;
 
@@ -263,7 +338,9 @@ typedef struct renderer_gl {
     double  depth_range[2];
 
     texture_t   *white_tex;
-    tex_cache_t *tex_cache;
+    text_entry_t *text_entries;
+    text_page_t  *text_pages;
+    int          frame;         // Frame counter.
     NVGcontext *vg;
 
     // Nanovg fonts references for regular and bold.
@@ -274,7 +351,12 @@ typedef struct renderer_gl {
     } fonts[2];
 
     item_t  *items;
+    item_t  *free_items; // Items of the previous frames we can reuse.
     cache_t *grid_cache;
+    cache_t *meshes_cache;
+
+    stream_buf_t vertices;
+    stream_buf_t indices;
 
 } renderer_gl_t;
 
@@ -311,19 +393,56 @@ static void window_to_ndc(renderer_gl_t *rend,
     ndc[1] = 1 - (win[1] * rend->scale / rend->fb_size[1]) * 2;
 }
 
+// Delete the text atlas pages that were mostly unused in the last frame.
+static void text_atlas_cleanup(renderer_gl_t *rend)
+{
+    text_entry_t *entry, *tmp;
+    text_page_t *page, *ptmp, *last;
+
+    DL_FOREACH(rend->text_pages, page)
+        page->used_area = 0;
+    HASH_ITER(hh, rend->text_entries, entry, tmp) {
+        if (entry->page && entry->last_used == rend->frame)
+            entry->page->used_area += entry->w * entry->h;
+        // Entries without page (empty texts) are deleted as soon as they
+        // are not used anymore.
+        if (!entry->page && entry->last_used != rend->frame) {
+            HASH_DEL(rend->text_entries, entry);
+            free(entry->key);
+            free(entry);
+        }
+    }
+
+    if (!rend->text_pages) return;
+    last = rend->text_pages->prev;
+
+    DL_FOREACH_SAFE(rend->text_pages, page, ptmp) {
+        if (page == last) continue;
+        if (page->used_area >= page->tex->w * page->tex->h / 4) continue;
+        HASH_ITER(hh, rend->text_entries, entry, tmp) {
+            if (entry->page != page) continue;
+            HASH_DEL(rend->text_entries, entry);
+            free(entry->key);
+            free(entry);
+        }
+        DL_DELETE(rend->text_pages, page);
+        texture_release(page->tex);
+        free(page);
+    }
+}
+
 static void prepare(renderer_t *rend_, double win_w, double win_h,
                     double scale, bool cull_flipped)
 {
     renderer_gl_t *rend = (void*)rend_;
-    tex_cache_t *ctex;
 
     rend->fb_size[0] = win_w * scale;
     rend->fb_size[1] = win_h * scale;
     rend->scale = scale;
     rend->cull_flipped = cull_flipped;
 
-    DL_FOREACH(rend->tex_cache, ctex)
-        ctex->in_use = false;
+    text_atlas_cleanup(rend);
+    rend->frame++;
 }
 
 /*
@@ -351,6 +470,94 @@ static item_t *get_item(renderer_gl_t *rend, int type,
     return NULL;
 }
 
+/*
+ * Function: item_new
+ * Return a new cleared render item.
+ *
+ * The items, and the memory of their buffers, are recycled from the
+ * previous frames, so that in steady state we don't need to allocate
+ * anything.
+ */
+static item_t *item_new(renderer_gl_t *rend, int type)
+{
+    item_t *item = rend->free_items;
+    gl_buf_t buf = {}, indices = {};
+
+    if (item) {
+        rend->free_items = item->next;
+        buf = item->buf;
+        indices = item->indices;
+    } else {
+        item = malloc(sizeof(*item));
+    }
+    memset(item, 0, sizeof(*item));
+    item->type = type;
+    item->buf.data = buf.data;
+    item->buf.data_size = buf.data_size;
+    item->indices.data = indices.data;
+    item->indices.data_size = indices.data_size;
+    return item;
+}
+
+// Same as gl_buf_alloc, but reuse the buffer memory if it's large enough.
+static void item_buf_alloc(gl_buf_t *buf, const gl_buf_info_t *info,
+                           int capacity)
+{
+    if (buf->data_size < capacity * info->size) {
+        free(buf->data);
+        buf->data_size = capacity * info->size;
+        buf->data = malloc(buf->data_size);
+    }
+    buf->info = info;
+    buf->capacity = capacity;
+    buf->nb = 0;
+}
+
+// Put back an item in the free list once it has been rendered.
+static void item_delete(renderer_gl_t *rend, item_t *item)
+{
+    texture_release(item->tex);
+    if (item->type == ITEM_PLANET)
+        texture_release(item->planet.normalmap);
+    if (item->type == ITEM_GLTF)
+        json_builder_free(item->gltf.args);
+    if (item->type == ITEM_MESH && item->mesh.gpu) {
+        cache_unpin(rend->meshes_cache, &item->mesh.gpu_key,
+                    sizeof(item->mesh.gpu_key));
+    }
+    item->next = rend->free_items;
+    rend->free_items = item;
+}
+
+/*
+ * Function: stream_buf_upload
+ * Copy some data into a streaming buffer, and leave it bound.
+ *
+ * Return:
+ *   The offset of the data in the buffer (bytes).
+ */
+static int stream_buf_upload(stream_buf_t *buf, const void *data, int size)
+{
+    int ofs;
+
+    if (!buf->id) {
+        GL(glGenBuffers(1, &buf->id));
+        buf->size = STREAM_BUF_SIZE;
+        buf->ofs = buf->size; // Force the allocation.
+    }
+    GL(glBindBuffer(buf->target, buf->id));
+    if (buf->ofs + size > buf->size) {
+        while (buf->size < size) buf->size *= 2;
+        GL(glBufferData(buf->target, buf->size, NULL, GL_STREAM_DRAW));
+        buf->ofs = 0;
+    }
+    GL(glBufferSubData(buf->target, buf->ofs, size, data));
+    ofs = buf->ofs;
+    // Keep the offsets aligned for the vertex attributes.
+    buf->ofs += (size + 15) & ~15;
+    return ofs;
+}
+
 static void points_2d(renderer_t *rend_,
                       const painter_t *painter,
                       int n,
@@ -371,9 +578,8 @@ static void points_2d(renderer_t *rend_,
     if (item && item->points.halo != painter->points_halo)
         item = NULL;
     if (!item) {
-        item = calloc(1, sizeof(*item));
-        item->type = ITEM_POINTS;
-        gl_buf_alloc(&item->buf, &POINTS_BUF, MAX_POINTS);
+        item = item_new(rend, ITEM_POINTS);
+        item_buf_alloc(&item->buf, &POINTS_BUF, MAX_POINTS);
         vec4_to_float(painter->color, item->color);
         item->points.halo = painter->points_halo;
         DL_APPEND(rend->items, item);
@@ -390,10 +596,14 @@ static void points_2d(renderer_t *rend_,
 
         // Add the point int the global list of rendered points.
         // XXX: could be done in the painter.
-        if (p.obj) {
+        if (p.obj || p.get_obj) {
             p.pos[0] = (+p.pos[0] + 1) / 2 * core->win_size[0];
             p.pos[1] = (-p.pos[1] + 1) / 2 * core->win_size[1];
-            areas_add_circle(core->areas, p.pos, p.size, p.obj);
+            if (p.obj)
+                areas_add_circle(core->areas, p.pos, p.size, p.obj);
+            else
+                areas_add_circle_lazy(core->areas, p.pos, p.size, p.get_obj,
+                                      p.get_obj_user, p.get_obj_id);
         }
     }
 }
@@ -476,10 +686,9 @@ static void quad_planet(
                                 {1, 1}, {1, 0}, {0, 1} };
     n = grid_size + 1;
 
-    item = calloc(1, sizeof(*item));
-    item->type = ITEM_PLANET;
-    gl_buf_alloc(&item->buf, &PLANET_BUF, n * n * 4);
-    gl_buf_alloc(&item->indices, &INDICES_BUF, n * n * 6);
+    item = item_new(rend, ITEM_PLANET);
+    item_buf_alloc(&item->buf, &PLANET_BUF, n * n * 4);
+    item_buf_alloc(&item->indices, &INDICES_BUF, n * n * 6);
     vec4_to_float(painter->color, item->color);
     item->flags = painter->flags;
     item->planet.shadow_color_tex = painter->planet.shadow_color_tex;
@@ -602,26 +811,23 @@ static void quad(renderer_t          *rend_,
                 memcmp(item->atm.sun, painter->atm.sun, sizeof(item->atm.sun))))
             item = NULL;
         if (!item) {
-            item = calloc(1, sizeof(*item));
-            item->type = ITEM_ATMOSPHERE;
-            gl_buf_alloc(&item->buf, &ATMOSPHERE_BUF, 256);
-            gl_buf_alloc(&item->indices, &INDICES_BUF, 256 * 6);
+            item = item_new(rend, ITEM_ATMOSPHERE);
+            item_buf_alloc(&item->buf, &ATMOSPHERE_BUF, 256);
+            item_buf_alloc(&item->indices, &INDICES_BUF, 256 * 6);
             memcpy(item->atm.p, painter->atm.p, sizeof(item->atm.p));
             memcpy(item->atm.sun, painter->atm.sun, sizeof(item->atm.sun));
         }
     } else if (painter->flags & PAINTER_FOG_SHADER) {
         item = get_item(rend, ITEM_FOG, n * n, grid_size * grid_size * 6, tex);
         if (!item) {
-            item = calloc(1, sizeof(*item));
-            item->type = ITEM_FOG;
-            gl_buf_alloc(&item->buf, &FOG_BUF, 256);
-            gl_buf_alloc(&item->indices, &INDICES_BUF, 256 * 6);
+            item = item_new(rend, ITEM_FOG);
+            item_buf_alloc(&item->buf, &FOG_BUF, 256);
+            item_buf_alloc(&item->indices, &INDICES_BUF, 256 * 6);
         }
     } else {
-        item = calloc(1, sizeof(*item));
-        item->type = ITEM_TEXTURE;
-        gl_buf_alloc(&item->buf, &TEXTURE_BUF, n * n);
-        gl_buf_alloc(&item->indices, &INDICES_BUF, n * n * 6);
+        item = item_new(rend, ITEM_TEXTURE);
+        item_buf_alloc(&item->buf, &TEXTURE_BUF, n * n);
+        item_buf_alloc(&item->indices, &INDICES_BUF, n * n * 6);
     }
 
     ofs = item->buf.nb;
@@ -684,10 +890,9 @@ static void quad_wireframe(renderer_t          *rend_,
     const double (*grid)[4] = NULL;
     bool should_delete_grid;
 
-    item = calloc(1, sizeof(*item));
-    item->type = ITEM_QUAD_WIREFRAME;
-    gl_buf_alloc(&item->buf, &TEXTURE_BUF, n * n);
-    gl_buf_alloc(&item->indices, &INDICES_BUF, grid_size * n * 4);
+    item = item_new(rend, ITEM_QUAD_WIREFRAME);
+    item_buf_alloc(&item->buf, &TEXTURE_BUF, n * n);
+    item_buf_alloc(&item->indices, &INDICES_BUF, grid_size * n * 4);
     vec4_to_float(VEC(1, 0, 0, 0.25), item->color);
 
     // Generate grid position.
@@ -735,11 +940,10 @@ static void texture2(renderer_gl_t *rend, texture_t *tex,
     if (item && memcmp(item->color, color, sizeof(color))) item = NULL;
 
     if (!item) {
-        item = calloc(1, sizeof(*item));
-        item->type = ITEM_TEXTURE;
+        item = item_new(rend, ITEM_TEXTURE);
         item->flags = flags;
-        gl_buf_alloc(&item->buf, &TEXTURE_BUF, 64 * 4);
-        gl_buf_alloc(&item->indices, &INDICES_BUF, 64 * 6);
+        item_buf_alloc(&item->buf, &TEXTURE_BUF, 64 * 4);
+        item_buf_alloc(&item->indices, &INDICES_BUF, 64 * 6);
         item->tex = tex;
         item->tex->ref++;
         memcpy(item->color, color, sizeof(color));
@@ -786,6 +990,147 @@ static void texture(renderer_t *rend_,
     texture2(rend, tex, uv, verts, color, 0, false);
 }
 
+static text_page_t *text_page_create(renderer_gl_t *rend, int size)
+{
+    text_page_t *page;
+    uint8_t *data;
+
+    page = calloc(1, sizeof(*page));
+    data = calloc(size, size);
+    page->tex = texture_from_data(data, size, size, 1, 0, 0, size, size, 0);
+    free(data);
+    DL_APPEND(rend->text_pages, page);
+    return page;
+}
+
+// Find a free space in a text page, by filling rows from top to bottom.
+static bool text_page_alloc(text_page_t *page, int w, int h, int *x, int *y)
+{
+    if (w > page->tex->w) return false;
+    if (page->row_x + w > page->tex->w) {
+        page->row_x = 0;
+        page->row_y += page->row_h;
+        page->row_h = 0;
+    }
+    if (page->row_y + h > page->tex->h) return false;
+    *x = page->row_x;
+    *y = page->row_y;
+    // One pixel of margin to avoid bleeding with linear filtering.
+    page->row_x += w + 1;
+    page->row_h = max(page->row_h, h + 1);
+    return true;
+}
+
+// Get a string from the text atlas, rendering it first if needed.
+static text_entry_t *text_atlas_get(renderer_gl_t *rend, const char *text,
+                                    double size, int effects)
+{
+    text_entry_t *entry;
+    text_page_t *page;
+    uint8_t *img;
+    char buf[256], *key = buf;
+    int page_size, len;
+
+    // Only allocate the key for very long texts.
+    len = snprintf(buf, sizeof(buf), "%g %g %d %s",
+                   size, rend->scale, effects, text);
+    if (len >= sizeof(buf))
+        asprintf(&key, "%g %g %d %s", size, rend->scale, effects, text);
+    HASH_FIND(hh, rend->text_entries, key, len, entry);
+    if (entry) {
+        if (key != buf) free(key);
+        entry->last_used = rend->frame;
+        return entry;
+    }
+
+    entry = calloc(1, sizeof(*entry));
+    entry->key = (key != buf) ? key : strdup(buf);
+    entry->last_used = rend->frame;
+    img = (void*)sys_render_text(text, size * rend->scale, effects,
+                                 &entry->w, &entry->h,
+                                 &entry->xoff, &entry->yoff);
+    if (img && entry->w && entry->h) {
+        page = rend->text_pages ? rend->text_pages->prev : NULL;
+        if (!page || !text_page_alloc(page, entry->w, entry->h,
+                                      &entry->x, &entry->y)) {
+            page_size = TEXT_ATLAS_SIZE;
+            while (page_size < entry->w || page_size < entry->h)
+                page_size *= 2;
+            page = text_page_create(rend, page_size);
+            text_page_alloc(page, entry->w, entry->h, &entry->x, &entry->y);
+        }
+        entry->page = page;
+        GL(glActiveTexture(GL_TEXTURE0));
+        GL(glBindTexture(GL_TEXTURE_2D, page->tex->id));
+        GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        GL(glTexSubImage2D(GL_TEXTURE_2D, 0, entry->x, entry->y,
+                           entry->w, entry->h, GL_LUMINANCE,
+                           GL_UNSIGNED_BYTE, img));
+        GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    }
+    free(img);
+    HASH_ADD_KEYPTR(hh, rend->text_entries, entry->key, strlen(entry->key),
+                    entry);
+    return entry;
+}
+
+/*
+ * Add the quad of a string of the text atlas.
+ *
+ * All the consecutive quads using the same page are batched together, with
+ * the color set per vertex.  Only for the additive blending we need the
+ * color to be set globally.
+ */
+static void text_quad(renderer_gl_t *rend, const text_entry_t *entry,
+                      double uv[4][2], double pos[4][2],
+                      const double color_[4], int flags, bool swap_indices)
+{
+    int i, ofs;
+    item_t *item;
+    const int16_t INDICES[6] = {0, 1, 2, 3, 2, 1 };
+    float color[4];
+    uint8_t vcolor[4] = {255, 255, 255, 255};
+
+    for (i = 0; i < 4; i++) {
+        color[i] = color_[i];
+        if (!(flags & PAINTER_ADD)) {
+            vcolor[i] = round(clamp(color[i], 0.0, 1.0) * 255);
+            color[i] = 1.0;
+        }
+    }
+
+    item = get_item(rend, ITEM_TEXTURE, 4, 6, entry->page->tex);
+    if (item && item->buf.info != &TEXT_BUF) item = NULL;
+    if (item && item->flags != flags) item = NULL;
+    if (item && memcmp(item->color, color, sizeof(color))) item = NULL;
+
+    if (!item) {
+        item = item_new(rend, ITEM_TEXTURE);
+        item->flags = flags;
+        item_buf_alloc(&item->buf, &TEXT_BUF, 256 * 4);
+        item_buf_alloc(&item->indices, &INDICES_BUF, 256 * 6);
+        item->tex = entry->page->tex;
+        item->tex->ref++;
+        memcpy(item->color, color, sizeof(color));
+        DL_APPEND(rend->items, item);
+    }
+
+    ofs = item->buf.nb;
+    for (i = 0; i < 4; i++) {
+        gl_buf_2f(&item->buf, -1, ATTR_POS, pos[i][0], pos[i][1]);
+        gl_buf_2f(&item->buf, -1, ATTR_TEX_POS, uv[i][0], uv[i][1]);
+        gl_buf_4i(&item->buf, -1, ATTR_COLOR, VEC4_SPLIT(vcolor));
+        gl_buf_next(&item->buf);
+    }
+    for (i = 0; i < 6; i++) {
+        if (swap_indices)
+            gl_buf_1i(&item->indices, -1, 0, ofs + INDICES[5 - i]);
+        else
+            gl_buf_1i(&item->indices, -1, 0, ofs + INDICES[i]);
+        gl_buf_next(&item->indices);
+    }
+}
+
 // Render text using a system bakend generated texture.
 static void text_using_texture(renderer_gl_t *rend,
                                const char *text, const double pos[2],
@@ -796,41 +1141,21 @@ static void text_using_texture(renderer_gl_t *rend,
     double uv[4][2], verts[4][2];
     double s[2], ofs[2] = {0, 0}, bounds[4];
     const double scale = rend->scale;
-    uint8_t *img;
-    int i, w, h, xoff, yoff;
-    tex_cache_t *ctex;
-    texture_t *tex;
-
-    DL_FOREACH(rend->tex_cache, ctex) {
-        if (ctex->size == size && ctex->effects == effects &&
-                strcmp(ctex->text, text) == 0) break;
-    }
-
-    if (!ctex) {
-        img = (void*)sys_render_text(text, size * scale, effects, &w, &h,
-                                     &xoff, &yoff);
-        ctex = calloc(1, sizeof(*ctex));
-        ctex->size = size;
-        ctex->effects = effects;
-        ctex->xoff = xoff;
-        ctex->yoff = yoff;
-        ctex->text = strdup(text);
-        ctex->tex = texture_from_data(img, w, h, 1, 0, 0, w, h, 0);
-        free(img);
-        DL_APPEND(rend->tex_cache, ctex);
-    }
+    int i;
+    const text_entry_t *entry;
+    const texture_t *tex;
 
-    ctex->in_use = true;
+    entry = text_atlas_get(rend, text, size, effects);
 
     // Compute bounds taking alignment into account.
-    s[0] = ctex->tex->w / scale;
-    s[1] = ctex->tex->h / scale;
+    s[0] = entry->w / scale;
+    s[1] = entry->h / scale;
     if (align & ALIGN_LEFT)     ofs[0] = +s[0] / 2;
     if (align & ALIGN_RIGHT)    ofs[0] = -s[0] / 2;
     if (align & ALIGN_TOP)      ofs[1] = +s[1] / 2;
     if (align & ALIGN_BOTTOM)   ofs[1] = -s[1] / 2;
-    bounds[0] = pos[0] - s[0] / 2 + ofs[0] + ctex->xoff / scale;
-    bounds[1] = pos[1] - s[1] / 2 + ofs[1] + ctex->yoff / scale;
+    bounds[0] = pos[0] - s[0] / 2 + ofs[0] + entry->xoff / scale;
+    bounds[1] = pos[1] - s[1] / 2 + ofs[1] + entry->yoff / scale;
 
     // Round the position to the nearest pixel.  We add a small delta to
     // fix a bug when we are exactly in between two pixels, which can happen
@@ -845,17 +1170,18 @@ static void text_using_texture(renderer_gl_t *rend,
         memcpy(out_bounds, bounds, sizeof(bounds));
         return;
     }
-    tex = ctex->tex;
+    if (!entry->page) return;
+    tex = entry->page->tex;
 
     /*
      * Render the texture, being careful to do the rotation centered on
      * the anchor point.
      */
     for (i = 0; i < 4; i++) {
-        uv[i][0] = ((i % 2) * tex->w) / (double)tex->tex_w;
-        uv[i][1] = ((i / 2) * tex->h) / (double)tex->tex_h;
-        verts[i][0] = (i % 2 - 0.5) * tex->w / scale;
-        verts[i][1] = (0.5 - i / 2) * tex->h / scale;
+        uv[i][0] = (entry->x + (i % 2) * entry->w) / (double)tex->tex_w;
+        uv[i][1] = (entry->y + (i / 2) * entry->h) / (double)tex->tex_h;
+        verts[i][0] = (i % 2 - 0.5) * entry->w / scale;
+        verts[i][1] = (0.5 - i / 2) * entry->h / scale;
         verts[i][0] += ofs[0];
         verts[i][1] += ofs[1];
         vec2_rotate(angle, verts[i], verts[i]);
@@ -866,9 +1192,9 @@ static void text_using_texture(renderer_gl_t *rend,
         window_to_ndc(rend, verts[i], verts[i]);
     }
 
-    texture2(rend, tex, uv, verts, color,
-             (effects & TEXT_BLEND_ADD) ? PAINTER_ADD : 0,
-             rend->cull_flipped);
+    text_quad(rend, entry, uv, verts, color,
+              (effects & TEXT_BLEND_ADD) ? PAINTER_ADD : 0,
+              rend->cull_flipped);
 }
 
 // Render text using nanovg.
@@ -887,8 +1213,7 @@ static void text_using_nanovg(renderer_gl_t *rend, const char *text,
     }
 
     if (!bounds) {
-        item = calloc(1, sizeof(*item));
-        item->type = ITEM_TEXT;
+        item = item_new(rend, ITEM_TEXT);
         vec4_to_float(color, item->color);
         item->color[0] = clamp(item->color[0], 0.0, 1.0);
         item->color[1] = clamp(item->color[1], 0.0, 1.0);
@@ -953,7 +1278,7 @@ static void text(renderer_t *rend_, const char *text, const double pos[2],
 static void item_points_render(renderer_gl_t *rend, const item_t *item)
 {
     gl_shader_t *shader;
-    GLuint  array_buffer;
+    int ofs;
     double core_size;
 
     if (item->buf.nb <= 0) {
@@ -968,45 +1293,37 @@ static void item_points_render(renderer_gl_t *rend, const item_t *item)
     GL(glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE, GL_ZERO, GL_ONE));
     GL(glDisable(GL_DEPTH_TEST));
 
-    GL(glGenBuffers(1, &array_buffer));
-    GL(glBindBuffer(GL_ARRAY_BUFFER, array_buffer));
-    GL(glBufferData(GL_ARRAY_BUFFER, item->buf.nb * item->buf.info->size,
-                    item->buf.data, GL_DYNAMIC_DRAW));
+    ofs = stream_buf_upload(&rend->vertices, item->buf.data,
+                            item->buf.nb * item->buf.info->size);
 
     gl_update_uniform(shader, "u_color", item->color);
     core_size = 1.0 / item->points.halo;
     gl_update_uniform(shader, "u_core_size", core_size);
 
-    gl_buf_enable(&item->buf);
+    gl_buf_enable(&item->buf, ofs);
     GL(glDrawArrays(GL_POINTS, 0, item->buf.nb));
     gl_buf_disable(&item->buf);
 
-    GL(glDeleteBuffers(1, &array_buffer));
+    GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
 }
 
-static void draw_buffer(const gl_buf_t *buf, const gl_buf_t *indices,
-                        GLuint gl_mode)
+static void draw_buffer(renderer_gl_t *rend, const gl_buf_t *buf,
+                        const gl_buf_t *indices, GLuint gl_mode)
 {
-    GLuint  array_buffer;
-    GLuint  index_buffer;
+    int array_ofs, index_ofs;
 
-    GL(glGenBuffers(1, &index_buffer));
-    GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer));
-    GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                    indices->nb * indices->info->size,
-                    indices->data, GL_DYNAMIC_DRAW));
+    index_ofs = stream_buf_upload(&rend->indices, indices->data,
+                                  indices->nb * indices->info->size);
+    array_ofs = stream_buf_upload(&rend->vertices, buf->data,
+                                  buf->nb * buf->info->size);
 
-    GL(glGenBuffers(1, &array_buffer));
-    GL(glBindBuffer(GL_ARRAY_BUFFER, array_buffer));
-    GL(glBufferData(GL_ARRAY_BUFFER, buf->nb * buf->info->size,
-                    buf->data, GL_DYNAMIC_DRAW));
-
-    gl_buf_enable(buf);
-    GL(glDrawElements(gl_mode, indices->nb, GL_UNSIGNED_SHORT, 0));
+    gl_buf_enable(buf, array_ofs);
+    GL(glDrawElements(gl_mode, indices->nb, GL_UNSIGNED_SHORT,
+                      (void*)(uintptr_t)index_ofs));
     gl_buf_disable(buf);
 
-    GL(glDeleteBuffers(1, &array_buffer));
-    GL(glDeleteBuffers(1, &index_buffer));
+    GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
 }
 
 static void item_lines_render(renderer_gl_t *rend, const item_t *item)
@@ -1025,7 +1342,7 @@ static void item_lines_render(renderer_gl_t *rend, const item_t *item)
                            GL_ZERO, GL_ONE));
     GL(glDisable(GL_DEPTH_TEST));
 
-    draw_buffer(&item->buf, &item->indices, GL_LINES);
+    draw_buffer(rend, &item->buf, &item->indices, GL_LINES);
 }
 
 static void item_mesh_render(renderer_gl_t *rend, const item_t *item)
@@ -1041,7 +1358,13 @@ static void item_mesh_render(renderer_gl_t *rend, const item_t *item)
               item->mesh.mode == 2 ? GL_POINTS : 0;
 
     shader_define_t defines[] = {
+        {"PROJ", item->mesh.proj != 0},
+        {"PROJ_PERSPECTIVE", item->mesh.proj == PROJ_PERSPECTIVE},
+        {"PROJ_STEREOGRAPHIC", item->mesh.proj == PROJ_STEREOGRAPHIC},
+        {"PROJ_MERCATOR", item->mesh.proj == PROJ_MERCATOR},
+        {"PROJ_HAMMER", item->mesh.proj == PROJ_HAMMER},
         {"PROJ_MOLLWEIDE", item->mesh.proj == PROJ_MOLLWEIDE},
+        {"REFRACTION", item->mesh.refraction},
         {}
     };
     shader = shader_get("mesh", defines, ATTR_NAMES, init_shader);
@@ -1063,9 +1386,11 @@ static void item_mesh_render(renderer_gl_t *rend, const item_t *item)
                                GL_ZERO, GL_ONE));
     }
 
-    // Stencil hack to remove projection deformations artifacts.
+    // Stencil hack to remove projection deformations artifacts.  The
+    // stencil is only cleared once per batch of retained meshes, so that
+    // overlapping meshes of the same color get blended as a single shape.
     if (item->mesh.use_stencil) {
-        GL(glClear(GL_STENCIL_BUFFER_BIT));
+        if (!item->mesh.batched) GL(glClear(GL_STENCIL_BUFFER_BIT));
         GL(glEnable(GL_STENCIL_TEST));
         GL(glStencilFunc(GL_NOTEQUAL, 1, 0xFF));
         GL(glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE));
@@ -1074,8 +1399,25 @@ static void item_mesh_render(renderer_gl_t *rend, const item_t *item)
     gl_update_uniform(shader, "u_color", item->color);
     gl_update_uniform(shader, "u_fbo_size", fbo_size);
     gl_update_uniform(shader, "u_proj_scaling", item->mesh.proj_scaling);
-
-    draw_buffer(&item->buf, &item->indices, gl_mode);
+    gl_update_uniform(shader, "u_proj_mat", item->mesh.proj_mat);
+    gl_update_uniform(shader, "u_proj_flip", item->mesh.proj_flip);
+    gl_update_uniform(shader, "u_rot", item->mesh.rot);
+    gl_update_uniform(shader, "u_ro2v", item->mesh.ro2v);
+    gl_update_uniform(shader, "u_refraction", item->mesh.refraction_coef);
+
+    if (item->mesh.gpu) {
+        GL(glBindBuffer(GL_ARRAY_BUFFER, item->mesh.gpu->vertices));
+        GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, item->mesh.gpu->indices));
+        GL(glEnableVertexAttribArray(ATTR_POS));
+        GL(glVertexAttribPointer(ATTR_POS, 3, GL_FLOAT, false, 0, 0));
+        GL(glDrawElements(gl_mode, item->mesh.gpu->indices_count,
+                          GL_UNSIGNED_SHORT, 0));
+        GL(glDisableVertexAttribArray(ATTR_POS));
+        GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+        GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    } else {
+        draw_buffer(rend, &item->buf, &item->indices, gl_mode);
+    }
 
     if (item->mesh.use_stencil) {
         GL(glDisable(GL_STENCIL_TEST));
@@ -1121,7 +1463,7 @@ static void item_lines_glow_render(renderer_gl_t *rend, const item_t *item)
         gl_update_uniform(shader, "u_fade_dist_max", item->lines.fade_dist_max);
     }
 
-    draw_buffer(&item->buf, &item->indices, GL_TRIANGLES);
+    draw_buffer(rend, &item->buf, &item->indices, GL_TRIANGLES);
     GL(glDisable(GL_DEPTH_TEST));
 }
 
@@ -1223,7 +1565,7 @@ static void item_fog_render(renderer_gl_t *rend, const item_t *item)
     GL(glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
                            GL_ZERO, GL_ONE));
     GL(glDisable(GL_DEPTH_TEST));
-    draw_buffer(&item->buf, &item->indices, GL_TRIANGLES);
+    draw_buffer(rend, &item->buf, &item->indices, GL_TRIANGLES);
     GL(glCullFace(GL_BACK));
 }
 
@@ -1259,7 +1601,7 @@ static void item_atmosphere_render(renderer_gl_t *rend, const item_t *item)
     tm[1] = core->tonemapper.lwmax;
     tm[2] = core->tonemapper.exposure;
     gl_update_uniform(shader, "u_tm", tm);
-    draw_buffer(&item->buf, &item->indices, GL_TRIANGLES);
+    draw_buffer(rend, &item->buf, &item->indices, GL_TRIANGLES);
     GL(glCullFace(GL_BACK));
 }
 
@@ -1270,6 +1612,7 @@ static void item_texture_render(renderer_gl_t *rend, const item_t *item)
     shader_define_t defines[] = {
         {"TEXTURE_LUMINANCE", item->tex->format == GL_LUMINANCE &&
                               !(item->flags & PAINTER_ADD)},
+        {"VERTEX_COLOR", item->buf.info == &TEXT_BUF},
         {}
     };
     shader = shader_get("blit", defines, ATTR_NAMES, init_shader);
@@ -1304,7 +1647,7 @@ static void item_texture_render(renderer_gl_t *rend, const item_t *item)
     }
 
     gl_update_uniform(shader, "u_color", item->color);
-    draw_buffer(&item->buf, &item->indices, GL_TRIANGLES);
+    draw_buffer(rend, &item->buf, &item->indices, GL_TRIANGLES);
     GL(glCullFace(GL_BACK));
 }
 
@@ -1323,7 +1666,7 @@ static void item_quad_wireframe_render(renderer_gl_t *rend, const item_t *item)
     GL(glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
                            GL_ZERO, GL_ONE));
 
-    draw_buffer(&item->buf, &item->indices, GL_LINES);
+    draw_buffer(rend, &item->buf, &item->indices, GL_LINES);
 }
 
 static void item_planet_render(renderer_gl_t *rend, const item_t *item)
@@ -1394,7 +1737,7 @@ static void item_planet_render(renderer_gl_t *rend, const item_t *item)
                       item->planet.normal_tex_transf);
     gl_update_uniform(shader, "u_depth_range", depth_range);
 
-    draw_buffer(&item->buf, &item->indices, GL_TRIANGLES);
+    draw_buffer(rend, &item->buf, &item->indices, GL_TRIANGLES);
     GL(glCullFace(GL_BACK));
     GL(glDepthMask(GL_FALSE));
     GL(glDisable(GL_DEPTH_TEST));
@@ -1495,14 +1838,7 @@ static void rend_flush(renderer_gl_t *rend)
         }
 
         DL_DELETE(rend->items, item);
-        texture_release(item->tex);
-        if (item->type == ITEM_PLANET)
-            texture_release(item->planet.normalmap);
-        if (item->type == ITEM_GLTF)
-            json_builder_free(item->gltf.args);
-        gl_buf_release(&item->buf);
-        gl_buf_release(&item->indices);
-        free(item);
+        item_delete(rend, item);
     }
     // Reset to default OpenGL settings.
     GL(glDepthMask(GL_TRUE));
@@ -1544,10 +1880,9 @@ static void line_glow(renderer_t           *rend_,
 
 
     if (!item) {
-        item = calloc(1, sizeof(*item));
-        item->type = ITEM_LINES_GLOW;
-        gl_buf_alloc(&item->buf, &LINES_GLOW_BUF, 1024);
-        gl_buf_alloc(&item->indices, &INDICES_BUF, 1024);
+        item = item_new(rend, ITEM_LINES_GLOW);
+        item_buf_alloc(&item->buf, &LINES_GLOW_BUF, 1024);
+        item_buf_alloc(&item->indices, &INDICES_BUF, 1024);
         item->lines.width = painter->lines.width;
         item->lines.glow = painter->lines.glow;
         item->lines.dash_length = painter->lines.dash_length;
@@ -1598,10 +1933,9 @@ static void line(renderer_t           *rend_,
     if (item && item->lines.width != painter->lines.width) item = NULL;
 
     if (!item) {
-        item = calloc(1, sizeof(*item));
-        item->type = ITEM_LINES;
-        gl_buf_alloc(&item->buf, &LINES_BUF, 1024);
-        gl_buf_alloc(&item->indices, &INDICES_BUF, 1024);
+        item = item_new(rend, ITEM_LINES);
+        item_buf_alloc(&item->buf, &LINES_BUF, 1024);
+        item_buf_alloc(&item->indices, &INDICES_BUF, 1024);
         item->lines.width = painter->lines.width;
         memcpy(item->color, color, sizeof(color));
         DL_APPEND(rend->items, item);
@@ -1624,6 +1958,17 @@ static void line(renderer_t           *rend_,
     }
 }
 
+// Set the projection attributes of a mesh item.
+static void mesh_item_set_proj(item_t *item, const projection_t *proj)
+{
+    item->mesh.proj = proj->type == PROJ_MOLLWEIDE_ADAPTIVE ?
+                      PROJ_MOLLWEIDE : proj->type;
+    vec2_to_float(proj->scaling, item->mesh.proj_scaling);
+    mat4_to_float(proj->mat, item->mesh.proj_mat);
+    item->mesh.proj_flip[0] = (proj->flags & PROJ_FLIP_HORIZONTAL) ? -1 : 1;
+    item->mesh.proj_flip[1] = (proj->flags & PROJ_FLIP_VERTICAL) ? -1 : 1;
+}
+
 static void mesh(renderer_t          *rend_,
                  const painter_t     *painter,
                  int                 frame,
@@ -1636,7 +1981,7 @@ static void mesh(renderer_t          *rend_,
 {
     int i, ofs;
     double pos[4] = {};
-    double rot[3][3];
+    double rot[3][3], identity[3][3] = MAT3_IDENTITY;
     float color[4];
     item_t *item;
     renderer_gl_t *rend = (void*)rend_;
@@ -1650,14 +1995,13 @@ static void mesh(renderer_t          *rend_,
     if (item && memcmp(item->color, color, sizeof(color))) item = NULL;
 
     if (!item) {
-        item = calloc(1, sizeof(*item));
-        item->type = ITEM_MESH;
+        item = item_new(rend, ITEM_MESH);
         memcpy(item->color, color, sizeof(color));
         item->mesh.mode = mode;
         item->mesh.stroke_width = painter->lines.width;
         item->mesh.use_stencil = use_stencil;
-        gl_buf_alloc(&item->buf, &MESH_BUF, max(verts_count, 1024));
-        gl_buf_alloc(&item->indices, &INDICES_BUF, max(indices_count, 1024));
+        item_buf_alloc(&item->buf, &MESH_BUF, max(verts_count, 1024));
+        item_buf_alloc(&item->indices, &INDICES_BUF, max(indices_count, 1024));
         DL_APPEND(rend->items, item);
     }
 
@@ -1669,8 +2013,8 @@ static void mesh(renderer_t          *rend_,
     if ((painter->proj->type == PROJ_MOLLWEIDE ||
          painter->proj->type == PROJ_MOLLWEIDE_ADAPTIVE) &&
             frame_get_rotation(painter->obs, frame, FRAME_VIEW, rot)) {
-        item->mesh.proj = PROJ_MOLLWEIDE;
-        vec2_to_float(painter->proj->scaling, item->mesh.proj_scaling);
+        mesh_item_set_proj(item, painter->proj);
+        mat3_to_float(identity, item->mesh.rot);
         for (i = 0; i < verts_count; i++) {
             mat3_mul_vec3(rot, verts[i], pos);
             gl_buf_4f(&item->buf, -1, ATTR_POS, VEC4_SPLIT(pos));
@@ -1696,14 +2040,143 @@ static void mesh(renderer_t          *rend_,
     }
 }
 
+static int gpu_mesh_delete(void *data)
+{
+    gpu_mesh_t *gmesh = data;
+    GL(glDeleteBuffers(1, &gmesh->vertices));
+    GL(glDeleteBuffers(1, &gmesh->indices));
+    free(gmesh);
+    return 0;
+}
+
+/*
+ * Function: gpu_mesh_get
+ * Get the GL buffers of a mesh, uploading them if they are not in the cache.
+ *
+ * The vertices are kept in the mesh frame, so that the buffers stay valid
+ * until the mesh gets modified.
+ */
+static void gpu_mesh_get(renderer_gl_t *rend, const mesh_t *mesh,
+                         const gpu_mesh_key_t *key)
+{
+    gpu_mesh_t *gmesh;
+    float (*verts)[3];
+    const uint16_t *indices;
+    double v[3];
+    int i, size;
+
+    if (!rend->meshes_cache)
+        rend->meshes_cache = cache_create(MESHES_CACHE_SIZE);
+    if (cache_get(rend->meshes_cache, key, sizeof(*key))) return;
+
+    gmesh = calloc(1, sizeof(*gmesh));
+    switch (key->mode) {
+    case MODE_TRIANGLES:
+        indices = mesh->triangles;
+        gmesh->indices_count = mesh->triangles_count;
+        break;
+    case MODE_LINES:
+        indices = mesh->lines;
+        gmesh->indices_count = mesh->lines_count;
+        break;
+    default:
+        indices = mesh->points;
+        gmesh->indices_count = mesh->points_count;
+        break;
+    }
+
+    verts = malloc(mesh->vertices_count * sizeof(*verts));
+    for (i = 0; i < mesh->vertices_count; i++) {
+        vec3_normalize(mesh->vertices[i], v);
+        vec3_to_float(v, verts[i]);
+    }
+    GL(glGenBuffers(1, &gmesh->vertices));
+    GL(glBindBuffer(GL_ARRAY_BUFFER, gmesh->vertices));
+    GL(glBufferData(GL_ARRAY_BUFFER, mesh->vertices_count * sizeof(*verts),
+                    verts, GL_STATIC_DRAW));
+    GL(glGenBuffers(1, &gmesh->indices));
+    GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gmesh->indices));
+    GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                    gmesh->indices_count * sizeof(*indices),
+                    indices, GL_STATIC_DRAW));
+    GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    free(verts);
+
+    size = mesh->vertices_count * sizeof(*verts) +
+           gmesh->indices_count * sizeof(*indices);
+    cache_add(rend->meshes_cache, key, sizeof(*key), gmesh, size,
+              gpu_mesh_delete);
+}
+
+/*
+ * Compute the rotation to apply to the vertices of a mesh in the shader.
+ *
+ * With refraction the conversion to the view frame is not a rotation, so
+ * we return the rotation to the observed frame instead, and the shader
+ * applies the refraction and the rotation from observed to view.
+ */
+static bool mesh_get_rotation(const observer_t *obs, int frame,
+                              double rot[3][3], bool *refraction)
+{
+    *refraction = false;
+    if (frame_get_rotation(obs, frame, FRAME_VIEW, rot)) return true;
+    if (frame != FRAME_ICRF) return false;
+    mat3_mul(obs->rv2o, obs->rc2v, rot);
+    *refraction = true;
+    return true;
+}
+
+static bool mesh_retained(renderer_t         *rend_,
+                          const painter_t    *painter,
+                          int                frame,
+                          int                mode,
+                          const mesh_t       *mesh,
+                          bool               use_stencil)
+{
+    renderer_gl_t *rend = (void*)rend_;
+    const observer_t *obs = painter->obs;
+    gpu_mesh_key_t key = {.id = mesh->id, .mode = mode};
+    double rot[3][3];
+    bool refraction;
+    item_t *item, *prev;
+
+    if (!mesh_get_rotation(obs, frame, rot, &refraction)) return false;
+
+    gpu_mesh_get(rend, mesh, &key);
+    prev = rend->items ? rend->items->prev : NULL;
+    item = item_new(rend, ITEM_MESH);
+    // Pinned until the item is rendered.
+    item->mesh.gpu = cache_pin(rend->meshes_cache, &key, sizeof(key));
+    item->mesh.gpu_key = key;
+    vec4_to_float(painter->color, item->color);
+    item->mesh.mode = mode;
+    item->mesh.stroke_width = painter->lines.width;
+    item->mesh.use_stencil = use_stencil;
+    mesh_item_set_proj(item, painter->proj);
+    mat3_to_float(rot, item->mesh.rot);
+    if (refraction) {
+        item->mesh.refraction = true;
+        mat3_to_float(obs->ro2v, item->mesh.ro2v);
+        // Same constant as in the refraction function.
+        item->mesh.refraction_coef = 1.02 * obs->refa / 1010. * 283. /
+                                     (273. + obs->refb) / 60.;
+    }
+    item->mesh.batched = prev && prev->type == ITEM_MESH &&
+        prev->mesh.gpu && prev->mesh.mode == mode &&
+        prev->mesh.use_stencil == use_stencil &&
+        memcmp(prev->color, item->color, sizeof(item->color)) == 0;
+    DL_APPEND(rend->items, item);
+    return true;
+}
+
 static void ellipse_2d(renderer_t *rend_, const painter_t *painter,
                        const double pos[2], const double size[2],
                        double angle, double dashes)
 {
     renderer_gl_t *rend = (void*)rend_;
     item_t *item;
-    item = calloc(1, sizeof(*item));
-    item->type = ITEM_VG_ELLIPSE;
+    item = item_new(rend, ITEM_VG_ELLIPSE);
     vec2_to_float(pos, item->vg.pos);
     vec2_to_float(size, item->vg.size);
     vec4_to_float(painter->color, item->color);
@@ -1718,8 +2191,7 @@ static void rect_2d(renderer_t *rend_, const painter_t *painter,
 {
     renderer_gl_t *rend = (void*)rend_;
     item_t *item;
-    item = calloc(1, sizeof(*item));
-    item->type = ITEM_VG_RECT;
+    item = item_new(rend, ITEM_VG_RECT);
     vec2_to_float(pos, item->vg.pos);
     vec2_to_float(size, item->vg.size);
     vec4_to_float(painter->color, item->color);
@@ -1733,8 +2205,7 @@ static void line_2d(renderer_t *rend_, const painter_t *painter,
 {
     renderer_gl_t *rend = (void*)rend_;
     item_t *item;
-    item = calloc(1, sizeof(*item));
-    item->type = ITEM_VG_LINE;
+    item = item_new(rend, ITEM_VG_LINE);
     vec2_to_float(p1, item->vg.pos);
     vec2_to_float(p2, item->vg.pos2);
     vec4_to_float(painter->color, item->color);
@@ -1752,8 +2223,7 @@ static void model_3d(renderer_t *rend_, const painter_t *painter,
 {
     renderer_gl_t *rend = (void*)rend_;
     item_t *item;
-    item = calloc(1, sizeof(*item));
-    item->type = ITEM_GLTF;
+    item = item_new(rend, ITEM_GLTF);
     item->gltf.model = model;
     mat4_copy(model_mat, item->gltf.model_mat);
     mat4_copy(view_mat, item->gltf.view_mat);
@@ -1830,6 +2300,8 @@ renderer_t* render_gl_create(void)
 #endif
 
     rend = calloc(1, sizeof(*rend));
+    rend->vertices.target = GL_ARRAY_BUFFER;
+    rend->indices.target = GL_ELEMENT_ARRAY_BUFFER;
     rend->white_tex = create_white_texture(16, 16);
 #ifdef GLES2
     rend->vg = nvgCreateGLES2(NVG_ANTIALIAS);
@@ -1854,6 +2326,7 @@ renderer_t* render_gl_create(void)
     rend->rend.text = text;
     rend->rend.line = line;
     rend->rend.mesh = mesh;
+    rend->rend.mesh_retained = mesh_retained;
     rend->rend.ellipse_2d = ellipse_2d;
     rend->rend.rect_2d = rect_2d;
     rend->rend.line_2d = line_2d;
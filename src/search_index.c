@@ -0,0 +1,356 @@
+/* Stellarium Web Engine - Copyright (c) 2018 - Noctua Software Ltd
+ *
+ * This program is licensed under the terms of the GNU AGPL v3, or
+ * alternatively under a commercial licence.
+ *
+ * The terms of the AGPL v3 license can be found in the main directory of this
+ * repository.
+ */
+
+#include "swe.h"
+
+#include <ctype.h>
+
+typedef struct entry entry_t;
+typedef struct node node_t;
+
+/*
+ * All the objects with a given designation.
+ *
+ * The entries are never deleted, since the tree nodes point to their keys.
+ */
+struct entry
+{
+    UT_hash_handle  hh;
+    char            *key;   // Normalized designation.
+    char            *dsgn;  // Designation as it was first added.
+    obj_t           **objs;
+    int             nb;
+    int             allocated;
+};
+
+/*
+ * Node of the radix tree used for the prefix lookups.
+ *
+ * Each node has an edge from its parent labeled with a part of a key.
+ * The children are sorted by their first char.
+ */
+struct node
+{
+    const char      *str; // Edge label (points into an entry key).
+    int             len;
+    node_t          *children;
+    node_t          *next;
+    entry_t         *entry; // Set if a key ends at this node.
+};
+
+typedef struct source {
+    void *user;
+    void (*search)(void *user, const char *key, bool prefix, void *f_user,
+                   int (*f)(void *f_user, const char *dsgn, obj_t *obj));
+} source_t;
+
+static struct {
+    entry_t     *entries;
+    node_t      root;
+    source_t    *sources;
+    int         nb_sources;
+} g_index = {};
+
+// Return a lower case copy of a designation.  Need to be freed.
+static char *normalize(const char *dsgn)
+{
+    char *ret = strdup(dsgn), *c;
+    for (c = ret; *c; c++) *c = tolower((unsigned char)*c);
+    return ret;
+}
+
+static void tree_add(node_t *node, const char *key, entry_t *entry)
+{
+    node_t *child, **it, *split;
+    int n;
+
+    while (*key) {
+        for (it = &node->children; *it; it = &(*it)->next) {
+            if ((*it)->str[0] >= key[0]) break;
+        }
+        child = *it;
+        if (!child || child->str[0] != key[0]) {
+            child = calloc(1, sizeof(*child));
+            child->str = key;
+            child->len = strlen(key);
+            child->entry = entry;
+            child->next = *it;
+            *it = child;
+            return;
+        }
+        for (n = 0; n < child->len && key[n] == child->str[n]; n++) {}
+        if (n < child->len) {
+            // Split the edge in two.
+            split = calloc(1, sizeof(*split));
+            split->str = child->str + n;
+            split->len = child->len - n;
+            split->children = child->children;
+            split->entry = child->entry;
+            child->children = split;
+            child->entry = NULL;
+            child->len = n;
+        }
+        key += n;
+        node = child;
+    }
+    node->entry = entry;
+}
+
+void search_index_add(const char *dsgn, obj_t *obj)
+{
+    entry_t *entry;
+    char *key;
+    int i;
+
+    key = normalize(dsgn);
+    HASH_FIND_STR(g_index.entries, key, entry);
+    if (!entry) {
+        entry = calloc(1, sizeof(*entry));
+        entry->key = key;
+        entry->dsgn = strdup(dsgn);
+        HASH_ADD_KEYPTR(hh, g_index.entries, entry->key, strlen(entry->key),
+                        entry);
+        tree_add(&g_index.root, entry->key, entry);
+    } else {
+        free(key);
+    }
+
+    for (i = 0; i < entry->nb; i++) {
+        if (entry->objs[i] == obj) return;
+    }
+    if (entry->nb >= entry->allocated) {
+        entry->allocated = max(1, entry->allocated * 2);
+        entry->objs = realloc(entry->objs,
+                              entry->allocated * sizeof(*entry->objs));
+    }
+    entry->objs[entry->nb++] = obj_retain(obj);
+}
+
+static void on_add_designation(const obj_t *obj, void *user, const char *dsgn)
+{
+    search_index_add(dsgn, (obj_t*)obj);
+}
+
+void search_index_add_obj(obj_t *obj)
+{
+    obj_get_designations(obj, NULL, on_add_designation);
+}
+
+static void on_remove_designation(const obj_t *obj, void *user,
+                                  const char *dsgn)
+{
+    entry_t *entry;
+    char *key;
+    int i;
+
+    key = normalize(dsgn);
+    HASH_FIND_STR(g_index.entries, key, entry);
+    free(key);
+    if (!entry) return;
+    for (i = 0; i < entry->nb; i++) {
+        if (entry->objs[i] != obj) continue;
+        entry->nb--;
+        memmove(&entry->objs[i], &entry->objs[i + 1],
+                (entry->nb - i) * sizeof(*entry->objs));
+        obj_release((obj_t*)obj);
+        return;
+    }
+}
+
+void search_index_remove_obj(obj_t *obj)
+{
+    obj_get_designations(obj, NULL, on_remove_designation);
+}
+
+void search_index_add_source(
+        void *user,
+        void (*search)(void *user, const char *key, bool prefix,
+                       void *f_user,
+                       int (*f)(void *f_user, const char *dsgn, obj_t *obj)))
+{
+    g_index.sources = realloc(g_index.sources,
+            (g_index.nb_sources + 1) * sizeof(*g_index.sources));
+    g_index.sources[g_index.nb_sources++] = (source_t) {user, search};
+}
+
+void search_index_remove_source(
+        void *user,
+        void (*search)(void *user, const char *key, bool prefix,
+                       void *f_user,
+                       int (*f)(void *f_user, const char *dsgn, obj_t *obj)))
+{
+    int i;
+    for (i = 0; i < g_index.nb_sources; i++) {
+        if (g_index.sources[i].user != user) continue;
+        if (g_index.sources[i].search != search) continue;
+        g_index.nb_sources--;
+        memmove(&g_index.sources[i], &g_index.sources[i + 1],
+                (g_index.nb_sources - i) * sizeof(*g_index.sources));
+        return;
+    }
+}
+
+static int on_source_find(void *user, const char *dsgn, obj_t *obj)
+{
+    obj_t **ret = user;
+    *ret = obj_retain(obj);
+    return 1;
+}
+
+EMSCRIPTEN_KEEPALIVE
+obj_t *search_index_find(const char *dsgn)
+{
+    entry_t *entry;
+    obj_t *ret = NULL;
+    char *key;
+    int i;
+
+    key = normalize(dsgn);
+    HASH_FIND_STR(g_index.entries, key, entry);
+    if (entry && entry->nb) {
+        ret = obj_retain(entry->objs[0]);
+        goto end;
+    }
+    for (i = 0; i < g_index.nb_sources && !ret; i++) {
+        g_index.sources[i].search(g_index.sources[i].user, key, false,
+                                  &ret, on_source_find);
+    }
+end:
+    free(key);
+    return ret;
+}
+
+// Depth first iteration of all the entries of a node.
+// Return false if we have to stop the iteration.
+static bool tree_iter(const node_t *node, int max_nb, int *nb, void *user,
+                      int (*f)(void *user, const char *dsgn, obj_t *obj))
+{
+    const node_t *child;
+    int i;
+
+    if (node->entry) {
+        for (i = 0; i < node->entry->nb; i++) {
+            if (max_nb && *nb >= max_nb) return false;
+            (*nb)++;
+            if (f(user, node->entry->dsgn, node->entry->objs[i]))
+                return false;
+        }
+    }
+    for (child = node->children; child; child = child->next) {
+        if (!tree_iter(child, max_nb, nb, user, f)) return false;
+    }
+    return true;
+}
+
+static int on_source_prefix(void *user, const char *dsgn, obj_t *obj)
+{
+    const int *max_nb = USER_GET(user, 0);
+    int *nb = USER_GET(user, 1);
+    bool *stopped = USER_GET(user, 2);
+    int (*f)(void *user, const char *dsgn, obj_t *obj) = USER_GET(user, 4);
+
+    if (*max_nb && *nb >= *max_nb) {
+        *stopped = true;
+        return 1;
+    }
+    (*nb)++;
+    *stopped = f(USER_GET(user, 3), dsgn, obj);
+    return *stopped;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int search_index_find_prefix(const char *prefix, int max_nb, void *user,
+                             int (*f)(void *user, const char *dsgn,
+                                      obj_t *obj))
+{
+    const node_t *node = &g_index.root;
+    const node_t *child;
+    char *key;
+    const char *p;
+    int i, n, nb = 0;
+    bool stopped = false;
+
+    key = normalize(prefix);
+    p = key;
+    while (*p) {
+        for (child = node->children; child; child = child->next) {
+            if (child->str[0] == *p) break;
+        }
+        if (!child) goto sources;
+        for (n = 0; n < child->len && p[n] && p[n] == child->str[n]; n++) {}
+        if (p[n] && n < child->len) goto sources; // Mismatch inside the edge.
+        p += n;
+        node = child;
+    }
+    stopped = !tree_iter(node, max_nb, &nb, user, f);
+sources:
+    for (i = 0; i < g_index.nb_sources && !stopped; i++) {
+        g_index.sources[i].search(
+                g_index.sources[i].user, key, true,
+                USER_PASS(&max_nb, &nb, &stopped, user, f), on_source_prefix);
+    }
+    free(key);
+    return nb;
+}
+
+/******** TESTS ***********************************************************/
+
+#if COMPILE_TESTS
+
+static int test_on_prefix(void *user, const char *dsgn, obj_t *obj)
+{
+    UT_string *s = user;
+    utstring_printf(s, "%s;", dsgn);
+    return 0;
+}
+
+static void test_search_index(void)
+{
+    obj_t objs[3] = {{.ref = 1}, {.ref = 1}, {.ref = 1}};
+    obj_t *obj;
+    UT_string s;
+    int nb;
+
+    search_index_add("NAME test_sun", &objs[0]);
+    search_index_add("NAME test_saturn", &objs[1]);
+    search_index_add("NAME test_sat", &objs[2]);
+    search_index_add("NAME test_sat", &objs[2]);
+    search_index_add("NAME test_s", &objs[0]);
+    assert(objs[2].ref == 2);
+
+    obj = search_index_find("name TEST_Sat");
+    assert(obj == &objs[2]);
+    obj_release(obj);
+    assert(!search_index_find("NAME test_sa"));
+
+    utstring_init(&s);
+    nb = search_index_find_prefix("NAME TEST_S", 0, &s, test_on_prefix);
+    assert(nb == 4);
+    assert(strcmp(utstring_body(&s), "NAME test_s;NAME test_sat;"
+                  "NAME test_saturn;NAME test_sun;") == 0);
+    utstring_clear(&s);
+    nb = search_index_find_prefix("NAME test_sat", 1, &s, test_on_prefix);
+    assert(nb == 1 && strcmp(utstring_body(&s), "NAME test_sat;") == 0);
+    utstring_clear(&s);
+    assert(search_index_find_prefix("NAME test_x", 0, &s, test_on_prefix)
+            == 0);
+    utstring_done(&s);
+
+    // Remove the objects (they have no designations, so do it manually).
+    on_remove_designation(&objs[0], NULL, "NAME test_sun");
+    on_remove_designation(&objs[0], NULL, "NAME test_s");
+    on_remove_designation(&objs[1], NULL, "NAME test_saturn");
+    on_remove_designation(&objs[2], NULL, "NAME test_sat");
+    assert(!search_index_find("NAME test_sat"));
+    assert(objs[0].ref == 1 && objs[1].ref == 1 && objs[2].ref == 1);
+}
+
+TEST_REGISTER(NULL, test_search_index, TEST_AUTO);
+
+#endif
@@ -0,0 +1,107 @@
+/* Stellarium Web Engine - Copyright (c) 2018 - Noctua Software Ltd
+ *
+ * This program is licensed under the terms of the GNU AGPL v3, or
+ * alternatively under a commercial licence.
+ *
+ * The terms of the AGPL v3 license can be found in the main directory of this
+ * repository.
+ */
+
+/*
+ * File: search_index.h
+ * Global index of objects designations.
+ *
+ * Modules with a large number of persistent children (satellites, comets,
+ * minor planets) put the designations of their objects in this index, and
+ * set the OBJ_INDEXED flag, so that <core_search> does not need to iterate
+ * all of them.
+ *
+ * The designations are compared case insensitively.  Exact lookups are done
+ * with a hash table, and prefix lookups (for auto completion) with a radix
+ * tree, both in O(length of the query).
+ *
+ * Modules that only create their objects on demand can instead register a
+ * source with <search_index_add_source>.  The sources are queried after the
+ * index itself.
+ */
+
+typedef struct obj obj_t;
+
+/*
+ * Function: search_index_add
+ * Add a designation of an object to the index.
+ *
+ * The index keeps a reference to the object until it is removed with
+ * <search_index_remove_obj>.
+ */
+void search_index_add(const char *dsgn, obj_t *obj);
+
+/*
+ * Function: search_index_add_obj
+ * Add all the designations of an object to the index.
+ */
+void search_index_add_obj(obj_t *obj);
+
+/*
+ * Function: search_index_remove_obj
+ * Remove all the designations of an object from the index.
+ */
+void search_index_remove_obj(obj_t *obj);
+
+/*
+ * Function: search_index_add_source
+ * Add an external source of designations.
+ *
+ * Parameters:
+ *   user   - Data passed to the search function.
+ *   search - Function that iterates the objects having a designation equal
+ *            to a lower case key, or starting with the key if prefix is set.
+ *            It should stop the iteration as soon as the callback returns
+ *            a non zero value.
+ */
+void search_index_add_source(
+        void *user,
+        void (*search)(void *user, const char *key, bool prefix,
+                       void *f_user,
+                       int (*f)(void *f_user, const char *dsgn, obj_t *obj)));
+
+/*
+ * Function: search_index_remove_source
+ * Remove a source added with <search_index_add_source>.
+ */
+void search_index_remove_source(
+        void *user,
+        void (*search)(void *user, const char *key, bool prefix,
+                       void *f_user,
+                       int (*f)(void *f_user, const char *dsgn, obj_t *obj)));
+
+/*
+ * Function: search_index_find
+ * Find an object by designation.
+ *
+ * Return:
+ *   The first added object with the given designation, or NULL.  The
+ *   returned object should be released with `obj_release`.
+ */
+obj_t *search_index_find(const char *dsgn);
+
+/*
+ * Function: search_index_find_prefix
+ * Iterate the objects having a designation starting with a given prefix.
+ *
+ * The designations of the index are iterated in alphabetical order,
+ * followed by the ones of the sources.
+ *
+ * Parameters:
+ *   prefix - The start of a designation.
+ *   max_nb - Maximum number of objects to iterate, or zero for no limit.
+ *   user   - Data passed to the callback.
+ *   f      - Callback called for each object and matching designation.
+ *            If it returns a non zero value the iteration stops.
+ *
+ * Return:
+ *   The number of times the callback has been called.
+ */
+int search_index_find_prefix(const char *prefix, int max_nb, void *user,
+                             int (*f)(void *user, const char *dsgn,
+                                      obj_t *obj));
@@ -57,12 +57,33 @@ int sgp4(sgp4_elsetrec_t *satrec, double utc_mjd, double r[3], double v[3])
 {
     double tsince;
     bool b; (void)b;
-    elsetrec *elrec = (elsetrec*)satrec;
-    tsince = utc_mjd - (elrec->jdsatepoch - 2400000.5 + elrec->jdsatepochF);
+    // Work on a copy of the elements, since SGP4Funcs::sgp4 modifies them,
+    // and they can be used at the same time by sgp4_propagate_many in a
+    // thread.
+    elsetrec elrec = *(elsetrec*)satrec;
+    tsince = utc_mjd - (elrec.jdsatepoch - 2400000.5 + elrec.jdsatepochF);
     tsince *= 24 * 60; // Put in min.
-    b = SGP4Funcs::sgp4(*((elsetrec*)satrec), tsince, r, v);
-    assert(!b == (bool)elrec->error);
-    return elrec->error;
+    b = SGP4Funcs::sgp4(elrec, tsince, r, v);
+    assert(!b == (bool)elrec.error);
+    return elrec.error;
+}
+
+int sgp4_propagate_many(const sgp4_elsetrec_t *const *satrecs, int n,
+                        double utc_mjd, double (*r)[3], double (*v)[3],
+                        int *errors)
+{
+    elsetrec rec;
+    double tsince;
+    int i, nb_errors = 0;
+
+    for (i = 0; i < n; i++) {
+        rec = *(const elsetrec*)satrecs[i];
+        tsince = utc_mjd - (rec.jdsatepoch - 2400000.5 + rec.jdsatepochF);
+        SGP4Funcs::sgp4(rec, tsince * 24 * 60, r[i], v[i]);
+        errors[i] = rec.error;
+        if (rec.error) nb_errors++;
+    }
+    return nb_errors;
 }
 
 /*
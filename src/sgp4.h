@@ -33,6 +33,28 @@ sgp4_elsetrec_t *sgp4_twoline2rv(
  */
 int sgp4(sgp4_elsetrec_t *satrec, double utc_mjd, double r[3], double v[3]);
 
+/*
+ * Function: sgp4_propagate_many
+ * Compute the positions of several satellites at a given time.
+ *
+ * The satellites elements are not modified, so this function can be called
+ * from a thread while the satellites are used elsewhere.
+ *
+ * Parameters:
+ *   satrecs - Array of n satellites elements.
+ *   n       - Number of satellites.
+ *   utc_mjd - Time of the propagation (UTC MJD).
+ *   r       - Output array of n positions (km, true equator frame).
+ *   v       - Output array of n velocities (km/s).
+ *   errors  - Output array of n error codes, as returned by <sgp4>.
+ *
+ * Return:
+ *   The number of satellites with an error.
+ */
+int sgp4_propagate_many(const sgp4_elsetrec_t *const *satrecs, int n,
+                        double utc_mjd, double (*r)[3], double (*v)[3],
+                        int *errors);
+
 /*
  * Function: sgp4_get_satepoch
  * Return the reference epoch of a sat (UTC MJD)
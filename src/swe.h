@@ -29,6 +29,7 @@
 #include "json.h"
 #include "json-builder.h"
 #include "eph-file.h"
+#include "ephcache.h"
 #include "erfa.h"
 #include "log.h"
 #include "profiler.h"
@@ -9,23 +9,28 @@
 
 #include "cache.h"
 #include "uthash.h"
+#include "utlist.h"
 #include <assert.h>
+#include <stdbool.h>
+#include "tests.h"
 
 typedef struct item item_t;
 struct item {
     UT_hash_handle  hh;
-    char            key[256];
+    item_t          *next, *prev; // LRU list.
     void            *data;
     int             cost;
-    uint64_t        last_used;
+    int             pin;
     int             (*delfunc)(void *data);
+    char            key[CACHE_KEY_MAX_SIZE];
 };
 
 struct cache {
     item_t *items;
-    uint64_t clock;
+    item_t *lru; // Unpinned items, least recently used first.
     int size;
     int max_size;
+    cache_stats_t stats;
 };
 
 cache_t *cache_create(int size)
@@ -37,15 +42,24 @@ cache_t *cache_create(int size)
 
 static void cleanup(cache_t *cache)
 {
-    item_t *item, *tmp;
-    HASH_ITER(hh, cache->items, item, tmp) {
-        if (item->delfunc && item->delfunc(item->data) == CACHE_KEEP)
+    item_t *item;
+    int n;
+
+    // Start from the oldest items.  If an item cannot be deleted yet we
+    // put it back at the end of the list so that we don't try it again
+    // for a while.
+    n = HASH_COUNT(cache->items) - cache->stats.nb_pinned;
+    for (; n > 0 && cache->size >= cache->max_size; n--) {
+        item = cache->lru;
+        DL_DELETE(cache->lru, item);
+        if (item->delfunc && item->delfunc(item->data) == CACHE_KEEP) {
+            DL_APPEND(cache->lru, item);
             continue;
+        }
         HASH_DEL(cache->items, item);
-        assert(item != cache->items);
         cache->size -= item->cost;
+        cache->stats.evictions++;
         free(item);
-        if (cache->size < cache->max_size) return;
     }
 }
 
@@ -53,30 +67,58 @@ void cache_add(cache_t *cache, const void *key, int len, void *data,
                int cost, int (*delfunc)(void *data))
 {
     item_t *item;
-    assert(len <= sizeof(item->key));
+    assert(len <= CACHE_KEY_MAX_SIZE);
     cache->size += cost;
     if (cache->size >= cache->max_size) cleanup(cache);
     item = calloc(1, sizeof(*item));
     memcpy(item->key, key, len);
     item->data = data;
     item->cost = cost;
-    item->last_used = cache->clock++;
     item->delfunc = delfunc;
     HASH_ADD(hh, cache->items, key, len, item);
+    DL_APPEND(cache->lru, item);
 }
 
 void *cache_get(cache_t *cache, const void *key, int keylen)
+{
+    item_t *item;
+    HASH_FIND(hh, cache->items, key, keylen, item);
+    if (!item) {
+        cache->stats.misses++;
+        return NULL;
+    }
+    cache->stats.hits++;
+    // Move the item to the end of the LRU list.
+    if (!item->pin) {
+        DL_DELETE(cache->lru, item);
+        DL_APPEND(cache->lru, item);
+    }
+    return item->data;
+}
+
+void *cache_pin(cache_t *cache, const void *key, int keylen)
 {
     item_t *item;
     HASH_FIND(hh, cache->items, key, keylen, item);
     if (!item) return NULL;
-    item->last_used = cache->clock++;
-    // Reinsert item on top of the hash list so that it stays sorted.
-    HASH_DEL(cache->items, item);
-    HASH_ADD(hh, cache->items, key, keylen, item);
+    if (item->pin++ == 0) {
+        DL_DELETE(cache->lru, item);
+        cache->stats.nb_pinned++;
+    }
     return item->data;
 }
 
+void cache_unpin(cache_t *cache, const void *key, int keylen)
+{
+    item_t *item;
+    HASH_FIND(hh, cache->items, key, keylen, item);
+    assert(item && item->pin > 0);
+    if (--item->pin == 0) {
+        DL_APPEND(cache->lru, item);
+        cache->stats.nb_pinned--;
+    }
+}
+
 void cache_set_cost(cache_t *cache, const void *key, int keylen, int cost)
 {
     item_t *item;
@@ -88,6 +130,13 @@ void cache_set_cost(cache_t *cache, const void *key, int keylen, int cost)
     if (cache->size >= cache->max_size) cleanup(cache);
 }
 
+void cache_get_stats(const cache_t *cache, cache_stats_t *stats)
+{
+    *stats = cache->stats;
+    stats->size = cache->size;
+    stats->nb = HASH_COUNT(cache->items);
+}
+
 /*
  * Function: cache_get_current_size
  * Return the total cost of all the currently cached items
@@ -96,3 +145,46 @@ int cache_get_current_size(const cache_t *cache)
 {
     return cache->size;
 }
+
+#if COMPILE_TESTS
+
+static int test_del_count = 0;
+static int test_del(void *data)
+{
+    test_del_count++;
+    return 0;
+}
+
+static void test_cache(void)
+{
+    cache_t *cache;
+    cache_stats_t stats;
+    int i;
+
+    cache = cache_create(4);
+    for (i = 0; i < 2; i++)
+        cache_add(cache, &i, sizeof(i), (void*)(intptr_t)(i + 1), 1,
+                  test_del);
+    // Pin item 0 and touch item 1: item 2 will be the least recently used
+    // item that can be deleted when we add item 3.
+    i = 0; assert(cache_pin(cache, &i, sizeof(i)));
+    i = 2; cache_add(cache, &i, sizeof(i), (void*)3, 1, test_del);
+    i = 1; assert(cache_get(cache, &i, sizeof(i)));
+    i = 3; cache_add(cache, &i, sizeof(i), (void*)4, 1, test_del);
+    i = 2; assert(!cache_get(cache, &i, sizeof(i)));
+    i = 0; assert(cache_get(cache, &i, sizeof(i)));
+    assert(test_del_count == 1);
+
+    cache_get_stats(cache, &stats);
+    assert(stats.hits == 2 && stats.misses == 1 && stats.evictions == 1);
+    assert(stats.nb == 3 && stats.nb_pinned == 1 && stats.size == 3);
+
+    // Once unpinned, item 0 can be deleted again.
+    i = 0; cache_unpin(cache, &i, sizeof(i));
+    cache_get_stats(cache, &stats);
+    assert(stats.nb_pinned == 0);
+}
+
+TEST_REGISTER(NULL, test_cache, TEST_AUTO);
+
+#endif
@@ -11,7 +11,20 @@
  * File: cache.h
  *
  * Utils to store values in cache.
+ *
+ * The items are kept in a least recently used list, so that adding or
+ * getting an item is O(1), and the cleanup only has to look at the oldest
+ * items.  Pinned items are removed from the list until they get unpinned,
+ * so they are never considered for deletion.
+ */
+
+#include <stdint.h>
+
+/*
+ * Define: CACHE_KEY_MAX_SIZE
+ * Max size in bytes of the keys used in a cache.
  */
+#define CACHE_KEY_MAX_SIZE 32
 
 /*
  * Enum: CACHE_KEEP
@@ -26,6 +39,27 @@
  */
 typedef struct cache cache_t;
 
+/*
+ * Type: cache_stats_t
+ * Statistics of a cache, as returned by <cache_get_stats>.
+ *
+ * Attributes:
+ *   hits       - Number of <cache_get> calls that found the item.
+ *   misses     - Number of <cache_get> calls that didn't find the item.
+ *   evictions  - Number of items deleted to reduce the cache size.
+ *   size       - Total cost of the cached items.
+ *   nb         - Number of items in the cache.
+ *   nb_pinned  - Number of pinned items.
+ */
+typedef struct cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    int size;
+    int nb;
+    int nb_pinned;
+} cache_stats_t;
+
 /*
  * Function: cache_create
  * Create a new cache with a given max size.
@@ -45,7 +79,7 @@ cache_t *cache_create(int size);
  *
  * Parameters:
  *  key     - Pointer to the unique key for the data.
- *  keylen  - Size of the key.
+ *  keylen  - Size of the key, up to CACHE_KEY_MAX_SIZE.
  *  data    - Pointer to the item data.  The cache takes ownership.
  *  cost    - Cost of the data used to compute the cache usage.
  *            It doesn't have to be the size.
@@ -73,6 +107,30 @@ void *cache_get(cache_t *cache, const void *key, int keylen);
  */
 void cache_set_cost(cache_t *cache, const void *key, int keylen, int cost);
 
+/*
+ * Function: cache_pin
+ * Prevent an item from being deleted from the cache.
+ *
+ * Items keep a pin count, and can only be deleted once <cache_unpin> has
+ * been called as many times as <cache_pin>.
+ *
+ * Return:
+ *   The data of the item, or NULL if no item with this key is in the cache.
+ */
+void *cache_pin(cache_t *cache, const void *key, int keylen);
+
+/*
+ * Function: cache_unpin
+ * Release a pin previously set with <cache_pin>.
+ */
+void cache_unpin(cache_t *cache, const void *key, int keylen);
+
+/*
+ * Function: cache_get_stats
+ * Get the current statistics of a cache.
+ */
+void cache_get_stats(const cache_t *cache, cache_stats_t *stats);
+
 /*
  * Function: cache_get_current_size
  * Return the total cost of all the currently cached items
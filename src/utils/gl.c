@@ -176,6 +176,7 @@ void gl_buf_alloc(gl_buf_t *buf, const gl_buf_info_t *info, int capacity)
     buf->info = info;
     buf->data = malloc(capacity * info->size);
     buf->capacity = capacity;
+    buf->data_size = capacity * info->size;
 }
 
 void gl_buf_release(gl_buf_t *buf)
@@ -262,7 +263,7 @@ void gl_buf_4i(gl_buf_t *buf, int i, int attr,
         assert(false);
 }
 
-void gl_buf_enable(const gl_buf_t *buf)
+void gl_buf_enable(const gl_buf_t *buf, int ofs)
 {
     int i, tot = 0;
     const gl_buf_info_t *info = buf->info;
@@ -272,7 +273,7 @@ void gl_buf_enable(const gl_buf_t *buf)
         if (!a->size) continue;
         GL(glEnableVertexAttribArray(i));
         GL(glVertexAttribPointer(i, a->size, a->type, a->normalized,
-                                 info->size, (void*)(uintptr_t)a->ofs));
+                                 info->size, (void*)(uintptr_t)(ofs + a->ofs)));
         tot += a->size * gl_size_for_type(a->type);
         if (tot == info->size) break;
     }
@@ -91,6 +91,7 @@ typedef struct gl_buf
     const gl_buf_info_t *info;
     int capacity;   // Number of items we can store.
     int nb;         // Current number of items.
+    int data_size;  // Allocated size of data (bytes).
 } gl_buf_t;
 
 /*
@@ -136,8 +137,13 @@ void gl_buf_next(gl_buf_t *buf);
 /*
  * Function: gl_buf_enable
  * Enable the buffer for an opengl draw call.
+ *
+ * Parameters:
+ *   buf    - The buffer.
+ *   ofs    - Offset of the buffer data in the currently bound array
+ *            buffer (bytes).
  */
-void gl_buf_enable(const gl_buf_t *buf);
+void gl_buf_enable(const gl_buf_t *buf, int ofs);
 
 /*
  * Function: gl_buf_disable
@@ -28,9 +28,18 @@ static double min(double x, double y)
     return x < y ? x : y;
 }
 
+// Give a new id to a mesh after it has been modified.
+static void mesh_update_id(mesh_t *mesh)
+{
+    static uint32_t last_id = 0;
+    mesh->id = ++last_id;
+}
+
 mesh_t *mesh_create(void)
 {
-    return calloc(1, sizeof(mesh_t));
+    mesh_t *mesh = calloc(1, sizeof(mesh_t));
+    mesh_update_id(mesh);
+    return mesh;
 }
 
 void mesh_delete(mesh_t *mesh)
@@ -57,6 +66,7 @@ mesh_t *mesh_copy(const mesh_t *mesh)
            ret->triangles_count * sizeof(*ret->triangles));
     ret->lines = malloc(ret->lines_count * sizeof(*ret->lines));
     memcpy(ret->lines, mesh->lines, ret->lines_count * sizeof(*ret->lines));
+    mesh_update_id(ret);
     return ret;
 }
 
@@ -95,6 +105,7 @@ static int mesh_add_vertices_lonlat(mesh_t *mesh, int count,
         assert(!isnan(mesh->vertices[mesh->vertices_count + i][0]));
     }
     mesh->vertices_count += count;
+    mesh_update_id(mesh);
     // XXX: shouldn't be done here!
     compute_bounding_cap(mesh->vertices_count, mesh->vertices,
                          mesh->bounding_cap);
@@ -110,6 +121,7 @@ int mesh_add_vertices(mesh_t *mesh, int count, double (*verts)[3])
     memcpy(mesh->vertices + mesh->vertices_count, verts,
            count * sizeof(*mesh->vertices));
     mesh->vertices_count += count;
+    mesh_update_id(mesh);
     // XXX: shouldn't be done here!
     compute_bounding_cap(mesh->vertices_count, mesh->vertices,
                          mesh->bounding_cap);
@@ -220,6 +232,7 @@ void mesh_add_poly_lonlat(mesh_t *mesh, int nbrings, const int *rings_size,
 
     // Not sure if we should instead assume the culling is always correct.
     mesh_fix_triangles_culling(mesh);
+    mesh_update_id(mesh);
 }
 
 
@@ -331,6 +344,7 @@ void mesh_cut_antimeridian(mesh_t *mesh)
     for (i = 0; i < count; i += 3) {
         mesh_cut_triangle_antimeridian(mesh, i);
     }
+    mesh_update_id(mesh);
 }
 
 static void mesh_subdivide_edge(mesh_t *mesh, int e1, int e2)
@@ -415,5 +429,6 @@ int mesh_subdivide(mesh_t *mesh, double max_length)
     for (i = 0; i < mesh->triangles_count; i += 3) {
         ret += mesh_subdivide_triangle(mesh, i, max_length);
     }
+    mesh_update_id(mesh);
     return ret;
 }
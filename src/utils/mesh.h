@@ -34,6 +34,10 @@ struct mesh {
     uint16_t    *points;
 
     bool        subdivided; // Set if the mesh was subdivided.
+
+    // Unique id, changed each time the mesh is modified, so that the
+    // renderers can keep a copy of the mesh data.
+    uint32_t    id;
 };
 
 mesh_t *mesh_create(void);
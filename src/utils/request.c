@@ -10,16 +10,21 @@
 #ifndef NO_LIBCURL
 
 #include "request.h"
+#include "utils.h"
+#include "uthash.h"
+#include "utlist.h"
 #include "utstring.h"
 
 #include <assert.h>
 #include <curl/curl.h>
+#include <dirent.h>
 #include <errno.h>
 #include <regex.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 #ifndef LOG_E
 #   define LOG_E
@@ -31,11 +36,36 @@
 
 #define MAX_NB  16
 
+// Max total size of the files saved in the cache directory.
+#define CACHE_MAX_SIZE (512 * 1024 * 1024)
+
+/*
+ * Type: cache_file_t
+ * Index entry of a file saved in the cache directory.
+ *
+ * The last use time is stored as the file modification time, so that we
+ * can keep the most recently used files across runs.
+ *
+ * The entries are also kept in a list sorted from the least recently used
+ * one, so that we don't have to sort the index to evict files.
+ */
+typedef struct cache_file cache_file_t;
+struct cache_file {
+    UT_hash_handle  hh;
+    char            *path;
+    int             size;
+    double          last_used;
+    cache_file_t    *prev, *next;
+};
+
 // static data.
 static struct {
     CURLM        *curlm;
     char         *cache_dir;
     int          nb; // Number of current running handles.
+    cache_file_t *cache_files; // Index of the files in cache_dir.
+    cache_file_t *cache_lru; // Same files, least recently used first.
+    int64_t      cache_size; // Total size of the files in cache_dir.
 } g = {};
 
 struct request
@@ -47,6 +77,7 @@ struct request
     long        status_code;    // HTTP status code
     void        *data;          // Actual data.
     int         size;
+    bool        mapped;         // Data mapped from local_path.
     bool        done;           // Request finished
     char        *local_path;    // Data saved to this file
 
@@ -57,28 +88,6 @@ struct request
 
 static const char *request_get_file(request_t *req, int *status_code);
 
-static void *read_file(const char *path, int *size)
-{
-    FILE *file;
-    char *ret;
-    int read_size __attribute__((unused));
-    int size_default;
-
-    size = size ?: &size_default; // Allow to pass NULL as size;
-    file = fopen(path, "rb");
-    if (!file) return NULL;
-    assert(file);
-    fseek(file, 0, SEEK_END);
-    *size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    ret = malloc(*size + 1);
-    read_size = fread(ret, *size, 1, file);
-    assert(read_size == 1 || *size == 0);
-    ret[*size] = '\0';
-    fclose(file);
-    return ret;
-}
-
 static double get_unix_time(void)
 {
     struct timeval tv;
@@ -113,6 +122,97 @@ static int ensure_dir(const char *path)
     return 0;
 }
 
+static void cache_index_add(const char *path, int size, double last_used)
+{
+    cache_file_t *file;
+    HASH_FIND_STR(g.cache_files, path, file);
+    if (!file) {
+        file = calloc(1, sizeof(*file));
+        file->path = strdup(path);
+        HASH_ADD_KEYPTR(hh, g.cache_files, file->path, strlen(file->path),
+                        file);
+    } else {
+        g.cache_size -= file->size;
+        DL_DELETE(g.cache_lru, file);
+    }
+    DL_APPEND(g.cache_lru, file);
+    file->size = size;
+    file->last_used = last_used;
+    g.cache_size += size;
+}
+
+static int cache_file_cmp(void *a, void *b)
+{
+    double ta = ((cache_file_t*)a)->last_used;
+    double tb = ((cache_file_t*)b)->last_used;
+    return ta < tb ? -1 : ta > tb ? 1 : 0;
+}
+
+/*
+ * Remove the least recently used files from the cache directory until
+ * the cache size fits into CACHE_MAX_SIZE.
+ */
+static void cache_cleanup(void)
+{
+    cache_file_t *file;
+    char *info_path;
+    int r;
+
+    while (g.cache_size > CACHE_MAX_SIZE && g.cache_lru) {
+        file = g.cache_lru;
+        r = asprintf(&info_path, "%s.info", file->path);
+        if (r == -1) LOG_E("Error");
+        unlink(file->path);
+        unlink(info_path);
+        free(info_path);
+        g.cache_size -= file->size;
+        HASH_DEL(g.cache_files, file);
+        DL_DELETE(g.cache_lru, file);
+        free(file->path);
+        free(file);
+    }
+}
+
+// Mark a cached file as recently used.
+static void cache_touch(const char *path)
+{
+    cache_file_t *file;
+    HASH_FIND_STR(g.cache_files, path, file);
+    if (file) {
+        file->last_used = get_unix_time();
+        DL_DELETE(g.cache_lru, file);
+        DL_APPEND(g.cache_lru, file);
+    }
+    utimes(path, NULL);
+}
+
+// Build the index of all the files already saved in the cache directory.
+static void cache_load_index(void)
+{
+    DIR *dir;
+    struct dirent *entry;
+    struct stat st;
+    char *path;
+    int r;
+
+    dir = opendir(g.cache_dir);
+    if (!dir) return;
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] == '.') continue;
+        if (str_endswith(entry->d_name, ".info")) continue;
+        r = asprintf(&path, "%s/%s", g.cache_dir, entry->d_name);
+        if (r == -1) LOG_E("Error");
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode))
+            cache_index_add(path, st.st_size, st.st_mtime);
+        free(path);
+    }
+    closedir(dir);
+    // The files modification times are not in order, so we sort the list
+    // once here.
+    DL_SORT(g.cache_lru, cache_file_cmp);
+    cache_cleanup();
+}
+
 static char *create_local_path(const char *url, const char *suffix)
 {
     char *ret;
@@ -133,6 +233,7 @@ void request_init(const char *cache_dir)
     if (!g.curlm) g.curlm = curl_multi_init();
     free(g.cache_dir);
     g.cache_dir = strdup(cache_dir);
+    if (!g.cache_files) cache_load_index();
 }
 
 request_t *request_create(const char *url)
@@ -160,6 +261,7 @@ request_t *request_create(const char *url)
 
         // If the cached version is not expired yet just use it.
         if (req->expiration && req->expiration > get_unix_time()) {
+            cache_touch(local_path);
             req->local_path = strdup(local_path);
             req->status_code = 200;
             req->done = true;
@@ -180,7 +282,8 @@ void request_delete(request_t *req)
 {
     if (!req) return;
     if (req->handle) LOG_E("Aborting request not implemented yet!");
-    if (req->data != utstring_body(&req->data_buf)) free(req->data);
+    if (req->mapped) unmap_file(req->data, req->size);
+    else if (req->data != utstring_body(&req->data_buf)) free(req->data);
     utstring_done(&req->data_buf);
     utstring_done(&req->header_buf);
     free(req->url);
@@ -240,6 +343,7 @@ static void on_done(request_t *req)
     if (req->status_code / 100 == 3) {
         req->local_path = create_local_path(req->url, NULL);
         assert(file_exists(req->local_path));
+        cache_touch(req->local_path);
     }
 
     if (req->status_code / 100 != 2) goto end;
@@ -364,6 +468,8 @@ static const char *request_get_file(request_t *req, int *status_code)
             assert(file);
             fwrite(utstring_body(&req->data_buf), 1, req->size, file);
             fclose(file);
+            cache_index_add(req->local_path, req->size, get_unix_time());
+            cache_cleanup();
         }
     }
     if (status_code) *status_code = req->status_code;
@@ -378,9 +484,11 @@ const void *request_get_data(request_t *req, int *size, int *status_code)
         if (size) *size = 0;
         return NULL;
     }
-    // Local file, copy it into the data buffer.
+    // Local file, map it or copy it into the data buffer.
     if (!req->data && req->local_path) {
-        req->data = read_file(req->local_path, &req->size);
+        req->data = map_file(req->local_path, &req->size);
+        req->mapped = req->data != NULL;
+        if (!req->mapped) req->data = read_file(req->local_path, &req->size);
     }
     if (size) *size = req->size;
     return req->data;
@@ -397,6 +505,7 @@ void request_make_fresh(request_t *req)
 #ifdef REQUEST_DUMMY
 
 #include "request.h"
+#include <stdbool.h>
 #include <stdlib.h>
 
 struct request
@@ -423,8 +532,8 @@ void request_delete(request_t *req)
 }
 const void *request_get_data(request_t *req, int *size, int *status_code)
 {
-    *size = 0;
-    *status_code = 598;
+    if (size) *size = 0;
+    if (status_code) *status_code = 598;
     return NULL;
 }
 
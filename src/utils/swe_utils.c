@@ -11,8 +11,12 @@
 #include "utstring.h"
 
 #include <assert.h>
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "webp/decode.h"
 #include <zlib.h>
@@ -63,6 +67,39 @@ void *read_file(const char *path, int *size)
     return ret;
 }
 
+void *map_file(const char *path, int *size)
+{
+#ifdef __EMSCRIPTEN__
+    return NULL;
+#else
+    int fd;
+    struct stat st;
+    void *ret;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) return NULL;
+    // We need at least one byte of padding after the data, which the
+    // system sets to zero for the rest of the last page.
+    if (fstat(fd, &st) != 0 || st.st_size == 0 ||
+            st.st_size % sysconf(_SC_PAGESIZE) == 0) {
+        close(fd);
+        return NULL;
+    }
+    ret = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ret == MAP_FAILED) return NULL;
+    if (size) *size = st.st_size;
+    return ret;
+#endif
+}
+
+void unmap_file(void *data, int size)
+{
+#ifndef __EMSCRIPTEN__
+    if (data) munmap(data, size);
+#endif
+}
+
 uint8_t *img_read(const char *path, int *w, int *h, int *bpp)
 {
     void *data;
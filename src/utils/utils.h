@@ -95,6 +95,26 @@ double unix_to_mjd(double t);
  */
 void *read_file(const char *path, int *size);
 
+/*
+ * Function: map_file
+ * Map a local file in memory (read only).
+ *
+ * Like <read_file>, the returned data is always followed by a zero byte, so
+ * that text files can be used directly as strings.  The memory should be
+ * released with <unmap_file>.
+ *
+ * Return:
+ *   The mapped data, or NULL if the file cannot be mapped.  In that case
+ *   we can still fall back to <read_file>.
+ */
+void *map_file(const char *path, int *size);
+
+/*
+ * Function: unmap_file
+ * Release the memory returned by <map_file>.
+ */
+void unmap_file(void *data, int size);
+
 /*
  * Function: img_read
  * Read a png/jpeg image from a file.
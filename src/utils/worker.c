@@ -10,14 +10,19 @@
 #include "worker.h"
 #include <string.h>
 
-#ifndef HAVE_PTHREAD
-
 void worker_init(worker_t *w, int (*fn)(worker_t *w))
 {
     memset(w, 0, sizeof(*w));
     w->fn = fn;
 }
 
+void worker_set_priority(worker_t *w, int priority)
+{
+    w->priority = priority;
+}
+
+#ifndef HAVE_PTHREAD
+
 int worker_iter(worker_t *w)
 {
     if (w->state) return 1;
@@ -31,4 +36,152 @@ bool worker_is_running(worker_t *w)
     return false;
 }
 
+bool worker_cancel(worker_t *w)
+{
+    return true;
+}
+
+#else
+
+#include <pthread.h>
+#include <unistd.h>
+
+// Max number of workers waiting for a thread.
+#define QUEUE_SIZE 64
+// Max number of threads in the pool.
+#define MAX_THREADS 8
+
+enum {
+    WORKER_IDLE = 0,
+    WORKER_QUEUED,
+    WORKER_RUNNING,
+    WORKER_DONE,
+};
+
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    worker_t        *queue; // Linked list sorted by decreasing priority.
+    int             queue_size;
+    int             nb_threads; // -1 if we failed to start any thread.
+} g_pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void *thread_func(void *arg)
+{
+    worker_t *w;
+    int ret;
+
+    pthread_mutex_lock(&g_pool.mutex);
+    while (true) {
+        while (!g_pool.queue)
+            pthread_cond_wait(&g_pool.cond, &g_pool.mutex);
+        w = g_pool.queue;
+        g_pool.queue = w->next;
+        g_pool.queue_size--;
+        w->next = NULL;
+        w->state = WORKER_RUNNING;
+        pthread_mutex_unlock(&g_pool.mutex);
+        ret = w->fn(w);
+        pthread_mutex_lock(&g_pool.mutex);
+        w->ret = ret;
+        w->state = WORKER_DONE;
+    }
+    return NULL;
+}
+
+// Start the threads.  Called with the mutex locked.
+static void pool_start(void)
+{
+    int i, nb;
+    pthread_t thread;
+
+    nb = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    nb = nb < 1 ? 1 : nb > MAX_THREADS ? MAX_THREADS : nb;
+    for (i = 0; i < nb; i++) {
+        if (pthread_create(&thread, NULL, thread_func, NULL) != 0) break;
+        pthread_detach(thread);
+    }
+    if (i == 0) LOG_W("Cannot start worker threads, use synchronous mode");
+    g_pool.nb_threads = i ?: -1;
+}
+
+static void queue_remove(worker_t *w)
+{
+    worker_t **it;
+    for (it = &g_pool.queue; *it; it = &(*it)->next) {
+        if (*it != w) continue;
+        *it = w->next;
+        w->next = NULL;
+        w->state = WORKER_IDLE;
+        g_pool.queue_size--;
+        return;
+    }
+}
+
+// Add a worker to the queue.  Return false if the queue is full.
+static bool queue_push(worker_t *w)
+{
+    worker_t **it, *last;
+
+    if (g_pool.queue_size >= QUEUE_SIZE) {
+        // Replace the last worker if it has a lower priority.
+        for (last = g_pool.queue; last->next; last = last->next) {}
+        if (last->priority >= w->priority) return false;
+        queue_remove(last);
+    }
+    for (it = &g_pool.queue; *it; it = &(*it)->next) {
+        if ((*it)->priority < w->priority) break;
+    }
+    w->next = *it;
+    *it = w;
+    w->state = WORKER_QUEUED;
+    g_pool.queue_size++;
+    pthread_cond_signal(&g_pool.cond);
+    return true;
+}
+
+int worker_iter(worker_t *w)
+{
+    int ret = 0;
+    bool sync = false;
+    pthread_mutex_lock(&g_pool.mutex);
+    if (!g_pool.nb_threads) pool_start();
+    if (w->state == WORKER_DONE) ret = 1;
+    if (w->state == WORKER_IDLE) {
+        if (g_pool.nb_threads > 0) queue_push(w);
+        else sync = true;
+    }
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    // No thread available at all: run the function synchronously.
+    if (sync) {
+        w->ret = w->fn(w);
+        w->state = WORKER_DONE;
+        ret = 1;
+    }
+    return ret;
+}
+
+bool worker_is_running(worker_t *w)
+{
+    bool ret;
+    pthread_mutex_lock(&g_pool.mutex);
+    ret = w->state == WORKER_QUEUED || w->state == WORKER_RUNNING;
+    pthread_mutex_unlock(&g_pool.mutex);
+    return ret;
+}
+
+bool worker_cancel(worker_t *w)
+{
+    bool ret;
+    pthread_mutex_lock(&g_pool.mutex);
+    if (w->state == WORKER_QUEUED) queue_remove(w);
+    ret = w->state != WORKER_RUNNING;
+    pthread_mutex_unlock(&g_pool.mutex);
+    return ret;
+}
+
 #endif
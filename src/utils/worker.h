@@ -14,6 +14,10 @@
  * A worker is simply a task that run in a thread pool.  We can create a worker
  * with <worker_init> and then run it by calling <worker_iter> as many times
  * as we want, until it returns a non zero value.
+ *
+ * When compiled with HAVE_PTHREAD, the workers are executed by a fixed
+ * number of threads, fed from a bounded queue sorted by priority.  Without
+ * it, the worker functions are run synchronously in <worker_iter>.
  */
 
 #include <stdbool.h>
@@ -26,6 +30,8 @@ struct worker
     void *user;
     int ret;
     int state;
+    int priority;   // Workers with higher priority are run first.
+    worker_t *next; // Used by the pool queue.
 };
 
 /*
@@ -34,6 +40,16 @@ struct worker
  */
 void worker_init(worker_t *w, int (*fn)(worker_t *w));
 
+/*
+ * Function: worker_set_priority
+ * Set the priority of a worker.
+ *
+ * Only affects workers that have not been queued yet.  If the queue is full,
+ * a worker with a higher priority replaces the lowest priority one, that
+ * will be queued again on its next call to <worker_iter>.
+ */
+void worker_set_priority(worker_t *w, int priority);
+
 /*
  * Function: worker_iter
  * Execute the worker function.
@@ -55,3 +71,15 @@ int worker_iter(worker_t *worker);
  * Return whether a worker is currently running.
  */
 bool worker_is_running(worker_t *worker);
+
+/*
+ * Function: worker_cancel
+ * Remove a worker from the pool queue if it didn't start yet.
+ *
+ * Return:
+ *   true if the worker is not running anymore, in which case the worker
+ *   function will not be called unless we call <worker_iter> again.
+ *   false if the function is currently running, and we have to wait for
+ *   it to finish before releasing the worker.
+ */
+bool worker_cancel(worker_t *worker);
@@ -0,0 +1,181 @@
+#!/usr/bin/python3
+# coding: utf-8
+
+# Stellarium Web Engine - Copyright (c) 2018 - Noctua Software Ltd
+#
+# This program is licensed under the terms of the GNU AGPL v3, or
+# alternatively under a commercial licence.
+#
+# The terms of the AGPL v3 license can be found in the main directory of this
+# repository.
+
+# Convert a MPC orbits file into a binary snapshot that the minor planets and
+# comets modules can use directly, without parsing.  See src/mpc.h for the
+# description of the format.
+#
+# Usage:
+#   ./tools/make-mpc-snapshot.py asteroids mpcorb_extended.dat.gz out.bin
+#   ./tools/make-mpc-snapshot.py comets CometEls.txt out.bin
+#
+# The fields are parsed the same way as in src/mpc.c, so that we get the
+# same objects as with the text files.
+
+import array
+import datetime
+import gzip
+import math
+import re
+import struct
+import sys
+
+MAGIC = b'MPCS'
+VERSION = 1
+TYPE_ASTEROIDS = 0
+TYPE_COMETS = 1
+
+MJD0 = datetime.date(1858, 11, 17).toordinal()
+
+# Same as in src/modules/minorplanets.c.
+ORBIT_TYPES = [b'MPl', b'Ati', b'Ate', b'Apo', b'Amo', b'MPl', b'Hun', b'Pho',
+               b'Hil', b'JTA', b'DOA']
+
+# Same as in src/modules/comets.c.
+COMET_TYPES = {b'P': b'PCo', b'C': b'CCo', b'X': b'XCo', b'D': b'DCo',
+               b'A': b'ACo', b'I': b'ISt'}
+
+FLOAT_RE = re.compile(rb' *-?[0-9]*\.[0-9]*(?=[ \n]|$)')
+
+
+def parse_float(line, pos):
+    m = FLOAT_RE.match(line, pos)
+    if not m: raise ValueError
+    return float(m.group())
+
+
+def unpack_char(c):
+    if 48 <= c <= 57: return c - 48
+    if 65 <= c <= 90: return 10 + c - 65
+    if 97 <= c <= 122: return 36 + c - 97
+    raise ValueError
+
+
+def mjd(year, month, day):
+    return datetime.date(year, month, day).toordinal() - MJD0
+
+
+def parse_asteroid(line):
+    if len(line) < 160: raise ValueError
+    number = 0
+    if line[5:6] == b' ':
+        for c in line[:5]: number = number * 10 + unpack_char(c)
+    h = parse_float(line, 8)
+    g = parse_float(line, 14)
+    e = line[20:25]
+    epoch = mjd((e[0] - ord('I') + 18) * 100 + int(e[1:3]),
+                unpack_char(e[3]), unpack_char(e[4]))
+    m, peri, node, i, ecc, n, a = [parse_float(line, x) for x in
+                                   (26, 37, 48, 59, 70, 80, 92)]
+    flags = int(line[161:165], 16)
+    name = desig = b''
+    if line[175] != ord(' ') and not (48 <= line[175] <= 57):
+        name = line[175:194].rstrip(b' ')
+    else:
+        desig = line[175:194].rstrip(b' ')
+    if not desig and len(line) >= 227:
+        desig = line[217:227].rstrip(b' ')
+    orbit_type = flags & 0x3f
+    otype = ORBIT_TYPES[orbit_type] if orbit_type < len(ORBIT_TYPES) \
+            else b'MPl'
+    # Designations, as returned by mplanet_get_designations.
+    dsgns = []
+    if name: dsgns.append(b'NAME ' + name)
+    if number:
+        dsgns.append(b'MPC (%d) %s' % (number, name) if name else
+                     b'MPC (%d)' % number)
+    if desig: dsgns.append(desig)
+    return dict(epoch=epoch, i=math.radians(i), node=math.radians(node),
+                peri=math.radians(peri), a=a, e=ecc, n=math.radians(n),
+                m=math.radians(m), h=h, g=g, number=number, name=name,
+                desig=desig, otype=otype, dsgns=dsgns)
+
+
+def parse_comet(line):
+    if len(line) < 160: raise ValueError
+    number = int(line[0:4]) if line[0:1] != b' ' else 0
+    dayf = parse_float(line, 22)
+    peri_time = mjd(int(line[14:18]), int(line[19:21]), int(dayf)) + \
+                math.fmod(dayf, 1.0)
+    q, ecc, peri, node, i = [parse_float(line, x) for x in
+                             (30, 41, 51, 61, 71)]
+    h = parse_float(line, 91)
+    g = parse_float(line, 96)
+    name = line[102:158].rstrip(b' ')
+    return dict(epoch=peri_time, i=math.radians(i), node=math.radians(node),
+                peri=math.radians(peri), a=q, e=ecc, n=0, m=0, h=h, g=g,
+                number=number, name=name, desig=b'',
+                otype=COMET_TYPES.get(line[4:5], b'Com'),
+                dsgns=[b'NAME ' + name])
+
+
+def pad8(data):
+    return data + b'\0' * (-len(data) % 8)
+
+
+def column(typecode, values):
+    arr = array.array(typecode, values)
+    if sys.byteorder != 'little': arr.byteswap()
+    return pad8(arr.tobytes())
+
+
+def run(type_, src, dst):
+    opener = gzip.open if src.endswith('.gz') else open
+    parse = parse_asteroid if type_ == TYPE_ASTEROIDS else parse_comet
+    bodies = []
+    nb_err = 0
+    with opener(src, 'rb') as f:
+        for line in f:
+            line = line.rstrip(b'\r\n')
+            if not line.strip(): continue
+            try:
+                bodies.append(parse(line))
+            except (ValueError, IndexError):
+                nb_err += 1
+
+    # String table, the empty string is at offset zero.
+    strings = bytearray(b'\0')
+    offsets = {b'': 0}
+    def add_str(s):
+        if s not in offsets:
+            offsets[s] = len(strings)
+            strings.extend(s + b'\0')
+        return offsets[s]
+
+    keys = [(d.lower(), idx, add_str(d))
+            for idx, b in enumerate(bodies) for d in b['dsgns']]
+    keys.sort()
+    names = [add_str(b['name']) for b in bodies]
+    desigs = [add_str(b['desig']) for b in bodies]
+
+    out = struct.pack('<4s5I8x', MAGIC, VERSION, type_, len(bodies),
+                      len(keys), len(strings))
+    out += column('d', [b['epoch'] for b in bodies])
+    for attr in ('i', 'node', 'peri', 'a', 'e', 'n', 'm', 'h', 'g'):
+        out += column('f', [b[attr] for b in bodies])
+    out += column('i', [b['number'] for b in bodies])
+    out += column('I', names)
+    out += column('I', desigs)
+    out += pad8(b''.join(b['otype'].ljust(4, b'\0') for b in bodies))
+    out += column('I', [k[2] for k in keys])
+    out += column('I', [k[1] for k in keys])
+    out += bytes(strings)
+    with open(dst, 'wb') as f:
+        f.write(out)
+    print('%d bodies, %d errors, %d bytes' % (len(bodies), nb_err, len(out)))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 4 or sys.argv[1] not in ('asteroids', 'comets'):
+        print('Usage: %s asteroids|comets <src> <dst>' % sys.argv[0])
+        sys.exit(-1)
+    run(TYPE_ASTEROIDS if sys.argv[1] == 'asteroids' else TYPE_COMETS,
+        sys.argv[2], sys.argv[3])
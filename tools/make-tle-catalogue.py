@@ -0,0 +1,133 @@
+#!/usr/bin/python3
+# coding: utf-8
+
+# Stellarium Web Engine - Copyright (c) 2018 - Noctua Software Ltd
+#
+# This program is licensed under the terms of the GNU AGPL v3, or
+# alternatively under a commercial licence.
+#
+# The terms of the AGPL v3 license can be found in the main directory of this
+# repository.
+
+# Convert a satellites jsonl file in noctuasky server format into a binary
+# catalogue that the satellites module can use directly, without parsing.
+# See tle_catalogue_t in src/modules/satellites.c for the description of the
+# format.
+#
+# Usage:
+#   ./tools/make-tle-catalogue.py tle_satellite.jsonl.gz out.bin
+
+import array
+import datetime
+import gzip
+import json
+import struct
+import sys
+
+MAGIC = b'TLEC'
+VERSION = 1
+TLE_LINE_SIZE = 70
+
+MJD0 = datetime.date(1858, 11, 17).toordinal()
+
+
+def mjd(year, month, day):
+    return datetime.date(year, month, day).toordinal() - MJD0
+
+
+def parse_date(s):
+    if not s: return 0
+    year, month, day = [int(x) for x in s.split('-')]
+    return mjd(year, month, day)
+
+
+def tle_epoch(line1):
+    # Same years range as in sgp4 twoline2rv.
+    year = int(line1[18:20])
+    year += 2000 if year < 57 else 1900
+    return mjd(year, 1, 1) - 1 + float(line1[20:32])
+
+
+def tle_perigee(line2):
+    # Same formula as in sgp4_get_perigree_height.
+    n0 = float(line2[52:63])
+    e0 = float(b'0.' + line2[26:33].strip())
+    a = (8681663.653 / n0) ** (2. / 3.)
+    return a * (1 - e0) - 6371
+
+
+def parse_sat(line):
+    data = json.loads(line)
+    md = data['model_data']
+    tle = [x.encode() for x in md['tle']]
+    if len(tle) != 2 or any(len(x) >= TLE_LINE_SIZE for x in tle):
+        raise ValueError
+    types = [t.encode() for t in data.get('types', [])
+             if isinstance(t, str)]
+    names = [n.encode() for n in data.get('names', [])
+             if isinstance(n, str)]
+    return dict(epoch=tle_epoch(tle[0]),
+                launch_date=parse_date(md.get('launch_date')),
+                decay_date=parse_date(md.get('decay_date')),
+                number=md['norad_number'],
+                stdmag=md.get('mag', float('nan')),
+                perigee=tle_perigee(tle[1]),
+                tle=b''.join(x.ljust(TLE_LINE_SIZE, b'\0') for x in tle),
+                names=names, types=types)
+
+
+def pad8(data):
+    return data + b'\0' * (-len(data) % 8)
+
+
+def column(typecode, values):
+    arr = array.array(typecode, values)
+    if sys.byteorder != 'little': arr.byteswap()
+    return pad8(arr.tobytes())
+
+
+def run(src, dst):
+    opener = gzip.open if src.endswith('.gz') else open
+    sats = []
+    nb_err = 0
+    with opener(src, 'rb') as f:
+        for line in f:
+            if not line.strip(): continue
+            try:
+                sats.append(parse_sat(line))
+            except (ValueError, KeyError, TypeError):
+                nb_err += 1
+
+    # String table, the empty list is at offset zero.
+    strings = bytearray(b'\0')
+    def add_list(values):
+        if not values: return 0
+        ret = len(strings)
+        for v in values: strings.extend(v + b'\0')
+        strings.extend(b'\0')
+        return ret
+
+    names = [add_list(s['names']) for s in sats]
+    types = [add_list(s['types']) for s in sats]
+    strings.extend(b'\0')
+
+    out = struct.pack('<4s3I16x', MAGIC, VERSION, len(sats), len(strings))
+    for attr in ('epoch', 'launch_date', 'decay_date'):
+        out += column('d', [s[attr] for s in sats])
+    out += column('i', [s['number'] for s in sats])
+    out += column('f', [s['stdmag'] for s in sats])
+    out += column('f', [s['perigee'] for s in sats])
+    out += pad8(b''.join(s['tle'] for s in sats))
+    out += column('I', names)
+    out += column('I', types)
+    out += bytes(strings)
+    with open(dst, 'wb') as f:
+        f.write(out)
+    print('%d satellites, %d errors, %d bytes' % (len(sats), nb_err, len(out)))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print('Usage: %s <src> <dst>' % sys.argv[0])
+        sys.exit(-1)
+    run(sys.argv[1], sys.argv[2])